@@ -0,0 +1,180 @@
+#include "bench.h"
+
+#include <avr/interrupt.h>
+#include <avr/sleep.h>
+
+#include "bsp/bsp.h"
+#include "bsp/private/processor/reg_io.h"
+#include "types.h"
+
+#define TIM1_CS_1       (1u << 0u)  /* TCCR1B clock select: CLK_io / 1 */
+#define TIM1_TOV_MASK   (1u << 0u)  /* TIFR1 overflow flag             */
+
+static u16_t overhead;
+
+static void empty_body(void);
+static u16_t measure(BenchFn_t body, bool_t *p_overflow);
+static void write_c_str(const char *c_str);
+static void write_u16(u16_t num);
+static void flush(void);
+
+/**
+ * @brief Initialize the benchmark harness.
+ *
+ * Timer1 is taken over as a cycle counter, so the BSP timer API must not be used
+ * by benchmark cases. The cost of timing an empty body is measured once and
+ * subtracted from every result.
+ */
+void bench_init(void)
+{
+    bool_t overflow;
+
+    bsp_init();
+    overhead = measure(empty_body, &overflow);
+}
+
+/**
+ * @brief Measure a benchmark case and report it over the serial port.
+ *
+ * The report is a single line: "BENCH <name> <calls> <cycles>". A body that
+ * runs for more than 65535 cycles reports "overflow" instead of a count.
+ *
+ * @param[in] p_case the case to run
+ */
+void bench_run(const BenchCase_t *p_case)
+{
+    bool_t overflow;
+    u16_t  ticks;
+
+    cli();
+
+    if (NULL_PTR != p_case->setup) {
+        p_case->setup();
+        cli(); /* setup may have called into code that enables interrupts */
+    }
+
+    ticks = measure(p_case->body, &overflow);
+
+    /* The serial driver is interrupt driven. */
+    sei();
+
+    write_c_str("BENCH ");
+    write_c_str(p_case->name);
+    write_c_str(" ");
+    write_u16(p_case->calls);
+    write_c_str(" ");
+    if (E_TRUE == overflow) {
+        write_c_str("overflow");
+    } else {
+        write_u16(ticks - overhead);
+    }
+    write_c_str("\n");
+
+    flush();
+}
+
+/**
+ * @brief Report the end of the run and stop the processor.
+ *
+ * Sleeping with interrupts disabled ends a simavr run.
+ */
+void bench_finish(void)
+{
+    sei();
+    write_c_str("BENCH-END\n");
+    flush();
+
+    cli();
+    sleep_enable();
+    sleep_cpu();
+
+    while (1) { }
+}
+
+static void empty_body(void)
+{
+}
+
+/**
+ * @brief Time a body with Timer1 running at the CPU clock.
+ *
+ * @param[in]  body       function to time
+ * @param[out] p_overflow E_TRUE when the 16-bit counter overflowed
+ *
+ * @return Timer1 ticks (CPU cycles) from the call to the return of body
+ */
+static u16_t measure(BenchFn_t body, bool_t *p_overflow)
+{
+    u16_t ticks;
+
+    /* Normal mode, no interrupts, cleared overflow flag (write 1 to clear). */
+    TIM1->TCCRB     = 0x00u;
+    TIM1->TCCRA     = 0x00u;
+    TIM1_IRQ->TIMSK = 0x00u;
+    TIM1_IRQ->TIFR  = TIM1_TOV_MASK;
+    TIM1->TCNT      = 0u;
+
+    TIM1->TCCRB = TIM1_CS_1;
+    body();
+    TIM1->TCCRB = 0x00u;
+
+    ticks = TIM1->TCNT;
+
+    if (0u != (TIM1_IRQ->TIFR & TIM1_TOV_MASK)) {
+        *p_overflow = E_TRUE;
+    } else {
+        *p_overflow = E_FALSE;
+    }
+
+    return ticks;
+}
+
+/**
+ * @brief Blocking C string write (spins while the transmit ring is full).
+ */
+static void write_c_str(const char *c_str)
+{
+    const char *p_c;
+
+    for (p_c = c_str; '\0' != *p_c; p_c += 1) {
+        while (E_FALSE == bsp_serial_write((u8_t)*p_c)) {
+            /* wait for the UDRE interrupt to make room */
+        }
+    }
+}
+
+/**
+ * @brief Blocking decimal write of an unsigned 16-bit number.
+ */
+static void write_u16(u16_t num)
+{
+    char c_str[6];  /* 5 digits plus NULL */
+    u8_t idx;
+
+    /* Digits are produced least significant first, so fill from the end. */
+    idx        = sizeof(c_str) - 1u;
+    c_str[idx] = '\0';
+
+    do {
+        idx       -= 1u;
+        c_str[idx] = (char)('0' + (num % 10u));
+        num       /= 10u;
+    } while (0u != num);
+
+    write_c_str(&c_str[idx]);
+}
+
+/**
+ * @brief Wait until every queued byte has left the transmit shift register.
+ */
+static void flush(void)
+{
+    /* The UDRE interrupt disables itself once the transmit ring is empty. */
+    while (0u != (USART0->UCSRB & UART_UCSRB_UDRIE_MASK)) { }
+
+    /* TXC is set once the last frame has been shifted out. */
+    while (0u == (USART0->UCSRA & UART_UCSRA_TXC_MASK)) { }
+
+    /* Clear TXC for the next flush (write 1 to clear, U2X is preserved). */
+    USART0->UCSRA |= UART_UCSRA_TXC_MASK;
+}
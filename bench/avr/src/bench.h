@@ -0,0 +1,39 @@
+#ifndef BENCH_H
+#define BENCH_H
+
+#include "types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Benchmark body function pointer type.
+ *
+ * The body is timed from its call to its return with interrupts disabled.
+ */
+typedef void (*BenchFn_t)(void);
+
+/**
+ * @brief A benchmark case.
+ *
+ * The setup function (optional) runs untimed before every measurement. The
+ * body makes calls to the function under test.
+ */
+typedef struct bench_case
+{
+    const char *name;   /* case name reported to the host      */
+    u16_t       calls;  /* calls to the measured function made  */
+    BenchFn_t   setup;  /* untimed setup or NULL_PTR            */
+    BenchFn_t   body;   /* timed body                           */
+} BenchCase_t;
+
+void bench_init(void);
+void bench_run(const BenchCase_t *p_case);
+void bench_finish(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* BENCH_H */
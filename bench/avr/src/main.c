@@ -0,0 +1,350 @@
+#include "bench.h"
+
+#include <avr/interrupt.h>
+#include <avr/pgmspace.h>
+
+#include "bsp/bsp.h"
+#include "bsp/sw_timers.h"
+#include "bsp/private/uart/uart.h"
+#include "morse/task.h"
+#include "utils/ascii_char.h"
+#include "utils/bytes.h"
+#include "utils/cobs.h"
+#include "utils/crc16.h"
+#include "utils/format.h"
+#include "types.h"
+
+/* The UART vectors are called directly to time them. The call and RETI stand
+   in for the interrupt response and vector table jump of a real interrupt. */
+void USART_RX_vect(void);
+void USART_UDRE_vect(void);
+
+/* Longest C string the morse task accepts (40 characters of 5 symbols each
+   keeps the wait time buffer within its 400 entries). */
+static const char * const MORSE_MAX_MSG = "0123456789 0123456789 0123456789 01234567";
+static const char * const MORSE_SOS_MSG = "SOS";
+
+/* Character mix for the classification predicates: letters of both cases, a
+   digit, white space, terminal and non-terminal punctuation, and a symbol. */
+#define ASCII_SAMPLE_LEN    (8u)
+static volatile char ascii_sample[ASCII_SAMPLE_LEN] = {
+    'a', 'Z', '5', ' ', '.', ',', '#', '\n'
+};
+
+#define BYTES_SET_LEN       (64u)
+static u8_t bytes_buffer[BYTES_SET_LEN];
+
+/* A short report line for the bulk UART write (compare with 16 uart_write) */
+#define UART_BUF_LEN        (16u)
+static const u8_t uart_buf[UART_BUF_LEN] = "Stack peak : 99\n";
+
+/* Output of the formatter cases (longest: 10 digits of a u32_t) */
+#define FORMAT_BUF_LEN      (12u)
+
+/* A serial frame payload: the largest that fits the 64 byte receive buffer
+   with its CRC. Bytes per second are F_CPU * FRAME_LEN / cycles. */
+#define FRAME_LEN           (62u)
+#define FRAME_ENCODED_SIZE  (COBS_ENCODED_MAX(FRAME_LEN + 2u) + 1u)
+
+static SwTimerHandle_t timer_handle;
+static char            num_c_str[6];
+static char            format_buf[FORMAT_BUF_LEN];
+static u8_t            format_len;
+static const u16_t     format_args[1] = { 65535u };    /* as LOG passes them */
+static u8_t            frame_payload[FRAME_LEN];
+static u8_t            frame_crc[2];
+static u8_t            frame_encoded[FRAME_ENCODED_SIZE];
+static u8_t            frame_encoded_len;
+static u8_t            frame_decoded[FRAME_LEN + 2u];
+static CobsDecoder_t   frame_decoder;
+
+static void num_to_c_str(u16_t num, char * c_str);
+static void format_buf_putc(void *p_ctx, char c);
+static void report_gather(u16_t num);
+static void frame_encoded_put(void *p_ctx, const u8_t *p_data, size_t len);
+
+/*
+ * Each predicate is called once per sample character, unrolled so the count is
+ * the cost of the calls alone.
+ */
+#define ASCII_BODY(fn)                      \
+static void bench_ ## fn(void)              \
+{                                           \
+    (void)fn(ascii_sample[0]);              \
+    (void)fn(ascii_sample[1]);              \
+    (void)fn(ascii_sample[2]);              \
+    (void)fn(ascii_sample[3]);              \
+    (void)fn(ascii_sample[4]);              \
+    (void)fn(ascii_sample[5]);              \
+    (void)fn(ascii_sample[6]);              \
+    (void)fn(ascii_sample[7]);              \
+}
+
+#define ASCII_CASE(fn)  { #fn, ASCII_SAMPLE_LEN, NULL_PTR, bench_ ## fn }
+
+ASCII_BODY(ascii_char_is_alpha)
+ASCII_BODY(ascii_char_is_vowel)
+ASCII_BODY(ascii_char_is_numeric)
+ASCII_BODY(ascii_char_is_alphanum)
+ASCII_BODY(ascii_char_is_punctuation)
+ASCII_BODY(ascii_char_is_terminal_punctuation)
+ASCII_BODY(ascii_char_is_whitespace)
+ASCII_BODY(ascii_char_to_lower)
+ASCII_BODY(ascii_char_to_upper)
+
+static void setup_morse_idle(void)      { morse_task_init(); }
+static void setup_morse_encode(void)    { morse_task_init(); morse_task_encode(MORSE_SOS_MSG, E_FALSE); }
+static void setup_udre(void)            { (void)uart_write('\n'); }
+static void setup_udre_stream(void)     { (void)uart_write_buf(uart_buf, 2u); }
+static void setup_uart_read(void)       { USART_RX_vect(); cli(); }
+static void setup_sw_timers(void)       { sw_timer_init(); }
+
+static void bench_morse_encode_sos(void) { morse_task_encode(MORSE_SOS_MSG, E_FALSE); }
+static void bench_morse_encode_max(void) { morse_task_encode(MORSE_MAX_MSG, E_FALSE); }
+static void bench_morse_task(void)       { morse_task(); }
+static void bench_sw_timer_usec(void)    { (void)sw_timer_usec(timer_handle); }
+static void bench_sw_timer_msec(void)    { (void)sw_timer_msec(timer_handle); }
+static void bench_sw_timer_sec(void)     { (void)sw_timer_sec(timer_handle); }
+static void bench_uart_write(void)       { (void)uart_write('\n'); }
+static void bench_uart_read(void)        { (void)uart_read(); }
+static void bench_uart_write_buf(void)   { (void)uart_write_buf(uart_buf, UART_BUF_LEN); }
+static void bench_uart_write_async(void) { (void)uart_write_async(uart_buf, UART_BUF_LEN); }
+static void bench_sw_timer_acquire(void) { (void)sw_timer_acquire(); }
+static void bench_bytes_set(void)        { bytes_set(bytes_buffer, BYTES_SET_LEN, 0xA5u); }
+static void bench_num_to_c_str_0(void)   { num_to_c_str(0u, num_c_str); }
+static void bench_num_to_c_str_9(void)   { num_to_c_str(9u, num_c_str); }
+static void bench_num_to_c_str_255(void) { num_to_c_str(255u, num_c_str); }
+static void bench_format_u_0(void)       { (void)format_P(format_buf_putc, NULL_PTR, PSTR("%u"), 0u); }
+static void bench_format_u_9(void)       { (void)format_P(format_buf_putc, NULL_PTR, PSTR("%u"), 9u); }
+static void bench_format_u_255(void)     { (void)format_P(format_buf_putc, NULL_PTR, PSTR("%u"), 255u); }
+static void bench_format_u_65535(void)   { (void)format_P(format_buf_putc, NULL_PTR, PSTR("%u"), 65535u); }
+static void bench_format_lu_max(void)    { (void)format_P(format_buf_putc, NULL_PTR, PSTR("%lu"), 0xFFFFFFFFul); }
+static void bench_format_x_ffff(void)    { (void)format_P(format_buf_putc, NULL_PTR, PSTR("%04x"), 0xFFFFu); }
+static void bench_format_args_u(void)    { (void)format_args_P(format_buf_putc, NULL_PTR, PSTR("%u"), format_args, 1u); }
+static void bench_report_gather(void)    { report_gather(255u); }
+static void bench_report_print(void)     { (void)bsp_serial_print_P(PSTR("\nStack peak : %u bytes\n"), 255u); }
+static void setup_format(void)           { format_len = 0u; }
+
+/* A telemetry like payload with a zero every 8 bytes, encoded once for the
+   decoder case. */
+static void setup_frame(void)
+{
+    u8_t i;
+    u16_t crc;
+
+    for (i = 0u; i < FRAME_LEN; i += 1u) {
+        frame_payload[i] = (0u == (i & 0x07u)) ? 0u : (u8_t)('0' + i);
+    }
+
+    crc          = crc16(CRC16_INIT, frame_payload, FRAME_LEN);
+    frame_crc[0] = (u8_t)(crc >> 8u);
+    frame_crc[1] = (u8_t)crc;
+
+    frame_encoded_len = 0u;
+    (void)cobs_encode(frame_payload, FRAME_LEN, frame_crc, 2u, frame_encoded_put, NULL_PTR);
+    frame_encoded[frame_encoded_len] = COBS_DELIMITER;
+    frame_encoded_len += 1u;
+
+    cobs_decoder_init(&frame_decoder, frame_decoded, sizeof(frame_decoded));
+}
+
+static void setup_frame_encode(void)
+{
+    setup_frame();
+    frame_encoded_len = 0u;
+}
+
+static void bench_crc16(void)
+{
+    (void)crc16(CRC16_INIT, frame_payload, FRAME_LEN);
+}
+
+static void bench_cobs_encode(void)
+{
+    (void)cobs_encode(frame_payload, FRAME_LEN, frame_crc, 2u, frame_encoded_put, NULL_PTR);
+}
+
+static void bench_cobs_decode(void)
+{
+    u8_t i;
+
+    for (i = 0u; i < frame_encoded_len; i += 1u) {
+        (void)cobs_decode(&frame_decoder, frame_encoded[i]);
+    }
+}
+
+static void bench_uart_write_frame(void) { (void)uart_write_frame(frame_payload, FRAME_LEN); }
+
+/* RETI re-enables interrupts. The instruction after it always executes before
+   a pending interrupt, so the cli() keeps the measurement window clean. */
+static void bench_usart_rx_isr(void)     { USART_RX_vect(); cli(); }
+static void bench_usart_udre_isr(void)   { USART_UDRE_vect(); cli(); }
+
+static const BenchCase_t CASES[] = {
+    { "morse_task_encode/sos",  1u, setup_morse_idle,   bench_morse_encode_sos  },
+    { "morse_task_encode/max",  1u, setup_morse_idle,   bench_morse_encode_max  },
+    { "morse_task/idle",        1u, setup_morse_idle,   bench_morse_task        },
+    { "morse_task/encode",      1u, setup_morse_encode, bench_morse_task        },
+    { "sw_timer_usec",          1u, NULL_PTR,           bench_sw_timer_usec     },
+    { "sw_timer_msec",          1u, NULL_PTR,           bench_sw_timer_msec     },
+    { "sw_timer_sec",           1u, NULL_PTR,           bench_sw_timer_sec      },
+    { "uart_write",             1u, NULL_PTR,           bench_uart_write        },
+    { "uart_write_buf/16",      1u, NULL_PTR,           bench_uart_write_buf    },
+    { "uart_write_async/16",    1u, NULL_PTR,           bench_uart_write_async  },
+    { "uart_read",              1u, setup_uart_read,    bench_uart_read         },
+    { "isr/usart_rx",           1u, NULL_PTR,           bench_usart_rx_isr      },
+    { "isr/usart_udre",         1u, setup_udre,         bench_usart_udre_isr    },
+    { "isr/usart_udre/stream",  1u, setup_udre_stream,  bench_usart_udre_isr    },
+    ASCII_CASE(ascii_char_is_alpha),
+    ASCII_CASE(ascii_char_is_vowel),
+    ASCII_CASE(ascii_char_is_numeric),
+    ASCII_CASE(ascii_char_is_alphanum),
+    ASCII_CASE(ascii_char_is_punctuation),
+    ASCII_CASE(ascii_char_is_terminal_punctuation),
+    ASCII_CASE(ascii_char_is_whitespace),
+    ASCII_CASE(ascii_char_to_lower),
+    ASCII_CASE(ascii_char_to_upper),
+    { "bytes_set/64",           1u, NULL_PTR,           bench_bytes_set         },
+    { "num_to_c_str/0",         1u, NULL_PTR,           bench_num_to_c_str_0    },
+    { "num_to_c_str/9",         1u, NULL_PTR,           bench_num_to_c_str_9    },
+    { "num_to_c_str/255",       1u, NULL_PTR,           bench_num_to_c_str_255  },
+    { "format_P/u_0",           1u, setup_format,       bench_format_u_0        },
+    { "format_P/u_9",           1u, setup_format,       bench_format_u_9        },
+    { "format_P/u_255",         1u, setup_format,       bench_format_u_255      },
+    { "format_P/u_65535",       1u, setup_format,       bench_format_u_65535    },
+    { "format_P/lu_max",        1u, setup_format,       bench_format_lu_max     },
+    { "format_P/04x_ffff",      1u, setup_format,       bench_format_x_ffff     },
+    { "format_args_P/u_65535",  1u, setup_format,       bench_format_args_u     },
+    { "report/gather",          1u, NULL_PTR,           bench_report_gather     },
+    { "report/print_P",         1u, NULL_PTR,           bench_report_print      },
+    { "crc16/62",               1u, setup_frame,        bench_crc16             },
+    { "cobs_encode/62",         1u, setup_frame_encode, bench_cobs_encode       },
+    { "cobs_decode/62",         1u, setup_frame,        bench_cobs_decode       },
+    { "uart_write_frame/62",    1u, setup_frame,        bench_uart_write_frame  },
+    /* Last, since it starts the software timers over. */
+    { "sw_timer_acquire",       1u, setup_sw_timers,    bench_sw_timer_acquire  },
+};
+
+/**
+ * @brief Common library micro-benchmarks
+ *
+ * Report the CPU cycles spent in the hot paths of the bsp, util, and morse
+ * libraries. See scripts/bench.py for running this under simavr.
+ */
+int main(void)
+{
+    size_t c;
+
+    bench_init();
+    sw_timer_init();
+
+    timer_handle = sw_timer_acquire();
+
+    for (c = 0u; c < (sizeof(CASES) / sizeof(CASES[0])); c += 1u) {
+        bench_run(&CASES[c]);
+    }
+
+    bench_finish();
+
+    return 0; /* Satisfy compiler. Should never get here */
+}
+
+/*
+ * The stack peak line as 07_sentence_statistics wrote it before the formatter:
+ * its division based number conversion and a gathered write of label, number
+ * and unit. Kept as the reference the formatter cases are compared with.
+ */
+static void num_to_c_str(u16_t num, char * c_str)
+{
+    size_t len;
+    size_t i;
+    u16_t  n;
+    u8_t   digit;
+    char   temp;
+
+    /* Exit early if the number is 0. */
+    if (0 == num) {
+        c_str[0] = '0';
+        c_str[1] = '\0';
+    } else {
+        /* This is a little inefficient since we go through two loops, but since the
+           number is limited to 5 digits, this is ok... for now.
+
+           This first loop parses the digits of num into characters and also
+           computes the length (number of digits) of the string. The parsing
+           puts the character representation of the digits in reverse order.
+
+           NOTE: The len variable is a little overloaded in this context. It is
+                 used as the index into the c_str and the length of the c_str.*/
+        n   = num;
+        len = 0;
+        while(n != 0) {
+            digit = (u8_t)(n % 10);
+            c_str[len] = ascii_char_digit_to_ascii(digit);
+            len++;
+            n /= 10;
+        }
+
+        /* Reverse the characters in the C string so the digits display
+           correctly.
+
+           NOTE: Only need to traverse half the array for reversal. */
+        for (i = 0; i < len/2; i += 1) {
+            temp = c_str[len - (i + 1)];
+            c_str[len - (i + 1)] = c_str[i];
+            c_str[i]             = temp;
+
+        }
+
+        /* Null terminate the string */
+        c_str[len] = '\0';
+    }
+}
+
+static void report_gather(u16_t num)
+{
+    static const char LABEL[] PROGMEM = "\nStack peak : ";
+    static const char UNIT[]  PROGMEM = " bytes\n";
+
+    BspSerialSegment_t segs[3];
+    size_t             len;
+
+    num_to_c_str(num, num_c_str);
+
+    len = 0u;
+    while ('\0' != num_c_str[len]) {
+        len += 1u;
+    }
+
+    segs[0].p_data   = (const u8_t*)LABEL;
+    segs[0].len      = sizeof(LABEL) - 1u;
+    segs[0].in_flash = E_TRUE;
+    segs[1].p_data   = (const u8_t*)num_c_str;
+    segs[1].len      = len;
+    segs[1].in_flash = E_FALSE;
+    segs[2].p_data   = (const u8_t*)UNIT;
+    segs[2].len      = sizeof(UNIT) - 1u;
+    segs[2].in_flash = E_TRUE;
+
+    (void)bsp_serial_write_gather(segs, 3u);
+}
+
+static void format_buf_putc(void *p_ctx, char c)
+{
+    (void)p_ctx;
+
+    format_buf[format_len] = c;
+    format_len += 1u;
+}
+
+static void frame_encoded_put(void *p_ctx, const u8_t *p_data, size_t len)
+{
+    (void)p_ctx;
+
+    while (0u != len) {
+        frame_encoded[frame_encoded_len] = *p_data;
+        frame_encoded_len += 1u;
+        p_data            += 1;
+        len               -= 1u;
+    }
+}
@@ -0,0 +1,385 @@
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "morse/task.h"
+#include "morse/private/parse.h"
+#include "utils/ascii_char.h"
+#include "utils/cobs.h"
+#include "utils/crc16.h"
+#include "utils/spsc_ring.h"
+#include "utils/spsc_ring.hpp"
+#include "types.h"
+
+/* Longest C string the morse task accepts (its wait time buffer holds 40
+   characters of 5 symbols). The corpora are fed to it in chunks of this size. */
+#define MORSE_CHUNK_LEN     ((size_t)MORSE_MAX_C_STR_LEN)
+
+/* Wait times of the longest character (5 symbols and 4 gaps) */
+#define MORSE_CHAR_WAITS    (9u)
+
+/* Size of the UART driver rings */
+#define BYTE_RING_SIZE      (256u)
+
+/* Largest payload of a serial frame (a 64 byte receive buffer less the CRC) */
+#define FRAME_PAYLOAD_LEN   (62u)
+
+SPSC_RING_DECLARATIONS(ByteRing, u8_t, BYTE_RING_SIZE)
+SPSC_RING_DECLARE(static ByteRing, byte_ring);
+
+static SpscRing<u8_t, BYTE_RING_SIZE> byte_ring_cpp;
+
+/**
+ * @brief A text corpus and its morse task sized chunks.
+ */
+typedef struct corpus
+{
+    const char               *name;
+    std::string               text;
+    std::vector<std::string>  chunks;
+} Corpus_t;
+
+/*
+ * English prose, digit heavy telemetry records, and punctuation dense log
+ * lines (see bench/host/corpus). Each exercises a different path through the
+ * comparison chains of the predicates and the morse parser.
+ */
+static Corpus_t corpora[] = {
+    { "prose",     {}, {} },
+    { "telemetry", {}, {} },
+    { "logs",      {}, {} },
+};
+
+typedef bool_t (*Predicate_t)(char c);
+typedef char (*Converter_t)(char c);
+
+static bool load_corpus(Corpus_t *p_corpus);
+static void frame_put(void *p_ctx, const u8_t *p_data, size_t len);
+static void frame_collect(void *p_ctx, const u8_t *p_data, size_t len);
+
+/*
+ * Every case reports the corpus characters it went through per second
+ * (items_per_second).
+ */
+static void case_morse_task_encode(benchmark::State &state, const Corpus_t *p_corpus)
+{
+    for (auto _ : state) {
+        for (const std::string &chunk : p_corpus->chunks) {
+            morse_task_encode(chunk.c_str(), E_FALSE);
+        }
+    }
+
+    state.SetItemsProcessed(state.iterations() * (int64_t)p_corpus->text.size());
+}
+
+static void case_cstr_to_waits(benchmark::State &state, const Corpus_t *p_corpus)
+{
+    static u8_t waits[MORSE_MAX_WAIT_TIMES];
+
+    for (auto _ : state) {
+        for (const std::string &chunk : p_corpus->chunks) {
+            morse_cstr_to_waits(waits, chunk.c_str());
+        }
+        benchmark::ClobberMemory();
+    }
+
+    state.SetItemsProcessed(state.iterations() * (int64_t)p_corpus->text.size());
+}
+
+static void case_pack_alphanum(benchmark::State &state, const Corpus_t *p_corpus)
+{
+    u8_t waits[MORSE_CHAR_WAITS];
+
+    for (auto _ : state) {
+        for (char c : p_corpus->text) {
+            benchmark::DoNotOptimize(morse_pack_alphanum(c, waits));
+        }
+        benchmark::ClobberMemory();
+    }
+
+    state.SetItemsProcessed(state.iterations() * (int64_t)p_corpus->text.size());
+}
+
+static void case_predicate(benchmark::State &state, const Corpus_t *p_corpus, Predicate_t fn)
+{
+    for (auto _ : state) {
+        for (char c : p_corpus->text) {
+            benchmark::DoNotOptimize(fn(c));
+        }
+    }
+
+    state.SetItemsProcessed(state.iterations() * (int64_t)p_corpus->text.size());
+}
+
+static void case_converter(benchmark::State &state, const Corpus_t *p_corpus, Converter_t fn)
+{
+    for (auto _ : state) {
+        for (char c : p_corpus->text) {
+            benchmark::DoNotOptimize(fn(c));
+        }
+    }
+
+    state.SetItemsProcessed(state.iterations() * (int64_t)p_corpus->text.size());
+}
+
+/*
+ * The corpus is pushed through a UART sized ring. Whenever it fills up it is
+ * drained, so both the full and the empty checks are taken.
+ */
+static void case_spsc_ring_c(benchmark::State &state, const Corpus_t *p_corpus)
+{
+    u8_t byte;
+
+    SPSC_RING_INIT(ByteRing, byte_ring);
+
+    for (auto _ : state) {
+        for (char c : p_corpus->text) {
+            if (E_FALSE == SPSC_RING_PUSH(ByteRing, byte_ring, (u8_t)c)) {
+                while (E_TRUE == SPSC_RING_POP(ByteRing, byte_ring, &byte)) {
+                    benchmark::DoNotOptimize(byte);
+                }
+                (void)SPSC_RING_PUSH(ByteRing, byte_ring, (u8_t)c);
+            }
+        }
+
+        while (E_TRUE == SPSC_RING_POP(ByteRing, byte_ring, &byte)) {
+            benchmark::DoNotOptimize(byte);
+        }
+    }
+
+    state.SetItemsProcessed(state.iterations() * (int64_t)p_corpus->text.size());
+}
+
+static void case_spsc_ring_cpp(benchmark::State &state, const Corpus_t *p_corpus)
+{
+    u8_t byte;
+
+    byte_ring_cpp.init();
+
+    for (auto _ : state) {
+        for (char c : p_corpus->text) {
+            if (false == byte_ring_cpp.push((u8_t)c)) {
+                while (true == byte_ring_cpp.pop(byte)) {
+                    benchmark::DoNotOptimize(byte);
+                }
+                (void)byte_ring_cpp.push((u8_t)c);
+            }
+        }
+
+        while (true == byte_ring_cpp.pop(byte)) {
+            benchmark::DoNotOptimize(byte);
+        }
+    }
+
+    state.SetItemsProcessed(state.iterations() * (int64_t)p_corpus->text.size());
+}
+
+/*
+ * The framing cases report the corpus bytes per second (bytes_per_second).
+ * The corpus is cut into serial frame payloads; the encoder output goes to a
+ * sink that only counts it, so the copy into the TX ring is not measured.
+ */
+static void case_cobs_encode(benchmark::State &state, const Corpus_t *p_corpus)
+{
+    const u8_t *p_text;
+    size_t      pos;
+    size_t      len;
+    size_t      count;
+    u8_t        crc_bytes[2] = { 0x12u, 0x34u };
+
+    p_text = (const u8_t*)p_corpus->text.data();
+    count  = 0u;
+
+    for (auto _ : state) {
+        for (pos = 0u; pos < p_corpus->text.size(); pos += FRAME_PAYLOAD_LEN) {
+            len = std::min<size_t>(FRAME_PAYLOAD_LEN, p_corpus->text.size() - pos);
+            cobs_encode(&p_text[pos], len, crc_bytes, sizeof(crc_bytes), frame_put, &count);
+        }
+        benchmark::DoNotOptimize(count);
+    }
+
+    state.SetBytesProcessed(state.iterations() * (int64_t)p_corpus->text.size());
+}
+
+static void case_cobs_decode(benchmark::State &state, const Corpus_t *p_corpus)
+{
+    std::vector<u8_t> encoded;
+    CobsDecoder_t     decoder;
+    u8_t              buffer[FRAME_PAYLOAD_LEN + 2u];
+    const u8_t       *p_text;
+    size_t            pos;
+    size_t            len;
+    size_t            frames;
+    u8_t              crc_bytes[2] = { 0x12u, 0x34u };
+
+    /* Encode the frames once, delimiters included. */
+    p_text = (const u8_t*)p_corpus->text.data();
+    for (pos = 0u; pos < p_corpus->text.size(); pos += FRAME_PAYLOAD_LEN) {
+        len = std::min<size_t>(FRAME_PAYLOAD_LEN, p_corpus->text.size() - pos);
+        cobs_encode(&p_text[pos], len, crc_bytes, sizeof(crc_bytes), frame_collect, &encoded);
+        encoded.push_back(COBS_DELIMITER);
+    }
+
+    for (auto _ : state) {
+        cobs_decoder_init(&decoder, buffer, sizeof(buffer));
+        frames = 0u;
+
+        for (u8_t byte : encoded) {
+            if (E_COBS_FRAME == cobs_decode(&decoder, byte)) {
+                frames += 1u;
+            }
+        }
+        benchmark::DoNotOptimize(frames);
+    }
+
+    state.SetBytesProcessed(state.iterations() * (int64_t)p_corpus->text.size());
+}
+
+static void case_crc16(benchmark::State &state, const Corpus_t *p_corpus)
+{
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(crc16(CRC16_INIT, (const u8_t*)p_corpus->text.data(),
+                                       p_corpus->text.size()));
+    }
+
+    state.SetBytesProcessed(state.iterations() * (int64_t)p_corpus->text.size());
+}
+
+#define PREDICATE(fn)   { #fn, fn }
+#define CONVERTER(fn)   { #fn, fn }
+
+static const struct { const char *name; Predicate_t fn; } PREDICATES[] = {
+    PREDICATE(ascii_char_is_alpha),
+    PREDICATE(ascii_char_is_vowel),
+    PREDICATE(ascii_char_is_numeric),
+    PREDICATE(ascii_char_is_alphanum),
+    PREDICATE(ascii_char_is_punctuation),
+    PREDICATE(ascii_char_is_terminal_punctuation),
+    PREDICATE(ascii_char_is_whitespace),
+};
+
+static const struct { const char *name; Converter_t fn; } CONVERTERS[] = {
+    CONVERTER(ascii_char_to_lower),
+    CONVERTER(ascii_char_to_upper),
+};
+
+/**
+ * @brief Host throughput benchmarks of the text processing paths
+ *
+ * Google Benchmark cases of the morse parser, the character predicates, the
+ * UART byte ring (C and C++ versions), and the serial framing (COBS and
+ * CRC-16) over each corpus, named
+ * <function>/<corpus>. The usual --benchmark_* options
+ * apply; scripts/bench.py host runs them and tracks the results per commit.
+ */
+int main(int argc, char *argv[])
+{
+    std::string name;
+    int         result;
+
+    result = 0;
+
+    for (Corpus_t &corpus : corpora) {
+        if (false == load_corpus(&corpus)) {
+            result = 1;
+        }
+    }
+
+    if (0 == result) {
+        for (const Corpus_t &corpus : corpora) {
+            name = corpus.name;
+
+            benchmark::RegisterBenchmark(("morse_task_encode/" + name).c_str(),
+                                         case_morse_task_encode, &corpus);
+            benchmark::RegisterBenchmark(("cstr_to_waits/" + name).c_str(),
+                                         case_cstr_to_waits, &corpus);
+            benchmark::RegisterBenchmark(("pack_alphanum/" + name).c_str(),
+                                         case_pack_alphanum, &corpus);
+            benchmark::RegisterBenchmark(("spsc_ring_c/" + name).c_str(),
+                                         case_spsc_ring_c, &corpus);
+            benchmark::RegisterBenchmark(("spsc_ring_cpp/" + name).c_str(),
+                                         case_spsc_ring_cpp, &corpus);
+            benchmark::RegisterBenchmark(("cobs_encode/" + name).c_str(),
+                                         case_cobs_encode, &corpus);
+            benchmark::RegisterBenchmark(("cobs_decode/" + name).c_str(),
+                                         case_cobs_decode, &corpus);
+            benchmark::RegisterBenchmark(("crc16/" + name).c_str(),
+                                         case_crc16, &corpus);
+
+            for (const auto &predicate : PREDICATES) {
+                benchmark::RegisterBenchmark((predicate.name + ("/" + name)).c_str(),
+                                             case_predicate, &corpus, predicate.fn);
+            }
+
+            for (const auto &converter : CONVERTERS) {
+                benchmark::RegisterBenchmark((converter.name + ("/" + name)).c_str(),
+                                             case_converter, &corpus, converter.fn);
+            }
+        }
+
+        morse_task_init();
+
+        benchmark::Initialize(&argc, argv);
+        benchmark::RunSpecifiedBenchmarks();
+        benchmark::Shutdown();
+    }
+
+    return result;
+}
+
+/**
+ * @brief Read a corpus from BENCH_CORPUS_DIR and split it into chunks.
+ *
+ * @retval true  - the corpus was loaded
+ * @retval false - the corpus file could not be read
+ */
+static bool load_corpus(Corpus_t *p_corpus)
+{
+    std::string path;
+    FILE       *file;
+    char        buffer[256];
+    size_t      count;
+    size_t      pos;
+    bool        loaded;
+
+    path   = std::string(BENCH_CORPUS_DIR "/") + p_corpus->name + ".txt";
+    file   = std::fopen(path.c_str(), "rb");
+    loaded = (nullptr != file);
+
+    if (true == loaded) {
+        while (0u != (count = std::fread(buffer, 1u, sizeof(buffer), file))) {
+            p_corpus->text.append(buffer, count);
+        }
+        std::fclose(file);
+
+        for (pos = 0u; pos < p_corpus->text.size(); pos += MORSE_CHUNK_LEN) {
+            p_corpus->chunks.push_back(p_corpus->text.substr(pos, MORSE_CHUNK_LEN));
+        }
+    } else {
+        std::fprintf(stderr, "bench_host: unable to read %s\n", path.c_str());
+    }
+
+    return loaded;
+}
+
+/**
+ * @brief COBS encoder sink that only counts the encoded bytes.
+ */
+static void frame_put(void *p_ctx, const u8_t *p_data, size_t len)
+{
+    (void)p_data;
+    *static_cast<size_t*>(p_ctx) += len;
+}
+
+/**
+ * @brief COBS encoder sink that appends to a std::vector<u8_t>.
+ */
+static void frame_collect(void *p_ctx, const u8_t *p_data, size_t len)
+{
+    std::vector<u8_t> *p_out = static_cast<std::vector<u8_t>*>(p_ctx);
+
+    p_out->insert(p_out->end(), p_data, p_data + len);
+}
@@ -1,3 +1,5 @@
+#include <avr/pgmspace.h>
+
 #include "bsp/bsp.h"
 #include "types.h"
 
@@ -12,7 +14,8 @@
 /* Number of morse elements in an SOS message */
 #define NUM_MORSE_ELEMENTS  (18)
 
-static const u8_t SOS_MORSE_TICKS[NUM_MORSE_ELEMENTS] = {
+/* The table stays in flash (PROGMEM), read it with pgm_read_byte. */
+static const u8_t SOS_MORSE_TICKS[NUM_MORSE_ELEMENTS] PROGMEM = {
     DOT, SYM_GAP, DOT, SYM_GAP, DOT,    /* S */
     CHAR_GAP,
     DASH, SYM_GAP, DASH, SYM_GAP, DASH, /* O */
@@ -45,7 +48,7 @@ int main(void)
        array (SENTENCE_GAP) */
     bsp_set_builtin_led(E_OFF);
     morse_index = NUM_MORSE_ELEMENTS - 1;
-    ticks_left  = SOS_MORSE_TICKS[morse_index];
+    ticks_left  = pgm_read_byte(&SOS_MORSE_TICKS[morse_index]);
     bsp_register_timer_isr_callback(bsp_timer_isr_callback);
 
     /* Enable interrupts now, so when the timer is configured and started the
@@ -76,7 +79,7 @@ static void bsp_timer_isr_callback(void)
 
     /* When ticks reaches 0 (or overflows and becomes bigger than the requested
        ticks), toggle the LED and prepare for the next morse element. */
-    if (0 == ticks_left || ticks_left > SOS_MORSE_TICKS[morse_index]) {
+    if (0 == ticks_left || ticks_left > pgm_read_byte(&SOS_MORSE_TICKS[morse_index])) {
         bsp_toggle_builtin_led();
 
         /* Move to the next morse element. Rollover to 0 and handle the
@@ -86,6 +89,6 @@ static void bsp_timer_isr_callback(void)
             morse_index = 0;
         }
 
-        ticks_left = SOS_MORSE_TICKS[morse_index];
+        ticks_left = pgm_read_byte(&SOS_MORSE_TICKS[morse_index]);
     }
 }
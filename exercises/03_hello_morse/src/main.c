@@ -1,6 +1,8 @@
 #include "bsp/bsp.h"
+#include "bsp/log.h"
 #include "morse/task.h"
 #include "types.h"
+#include "utils/exec_stats.h"
 
 /**
  * @brief Scheduler operating contexts.
@@ -29,20 +31,48 @@ typedef enum scheduler_context
 #define MINOR_CYCLE_MS      (100u)                              /* 100ms  */
 #define MAJOR_CYCLE_MS      (NUM_MINOR_CYCLES * MINOR_CYCLE_MS) /* 1000ms */
 
+/* An ENQ character (Ctrl-E) on the serial port requests the scheduler report. */
+#define REPORT_REQUEST      (0x05u)
+#define MAX_OVERRUNS        (0xFFu)
+
+/* Lines of the scheduler report, one written per pass (see report_line). */
+#define REPORT_BUDGET       (0u)
+#define REPORT_HEADER       (1u)
+#define REPORT_FIRST_CYCLE  (2u)
+#define REPORT_IDLE         (0xFFu)
+
 
 static volatile SchedulerContext_t curr_context;
 static volatile size_t curr_minor_cycle;
 
+/*
+ * Scheduler accounting. The execution times are in BSP timer ticks (4us for
+ * the millisecond period used here) and are kept per minor cycle, since each
+ * cycle runs a different task slot.
+ */
+static volatile u8_t overruns[NUM_MINOR_CYCLES];
+static ExecStats_t primary_stats[NUM_MINOR_CYCLES];
+static ExecStats_t background_stats[NUM_MINOR_CYCLES];
+
+/* Next line of the scheduler report (REPORT_IDLE when none was requested) */
+static u8_t report_line;
+
 
+static void execute_context(void);
 static void primary_context(void);
 static void background_context(void);
 static void initialize_scheduler(void);
+static void reset_scheduler_stats(void);
+static void scheduler_report_task(void);
 static void scheduler_isr(void);
 
 /**
  * @brief Hello, Morse!
  *
  * Extend the LED SOS exercise to blink out HELLO MORSE<sentence gap>
+ *
+ * An ENQ character (Ctrl-E) on the serial port reports the minor cycle
+ * overruns and the execution times of the scheduler contexts.
  */
 int main(void)
 {
@@ -57,17 +87,44 @@ int main(void)
     /* Scheduler loop */
     while (1) {
         /* Execute the context as specified by the scheduler */
-        if (E_CONTEXT_PRIMARY == curr_context) {
-            primary_context();
-        } else {
-            background_context();
-        }
+        execute_context();
+
+        /* The report is written outside of the contexts so it does not count
+           against any task slot. */
+        scheduler_report_task();
     }
 
     return 0; /* Satisfy compiler. Should never get here */
 }
 
 
+/**
+ * @brief Execute and time the current scheduler context.
+ *
+ * The minor cycle is captured before the context runs, so a context that is
+ * still running when the scheduler ISR fires is charged to the cycle it
+ * started in.
+ */
+static void execute_context(void)
+{
+    size_t minor_cycle;
+    u16_t  start;
+
+    minor_cycle = curr_minor_cycle;
+    start       = bsp_get_timer_ticks();
+
+    if (E_CONTEXT_PRIMARY == curr_context) {
+        primary_context();
+        exec_stats_add(&primary_stats[minor_cycle],
+                       bsp_get_timer_elapsed_ticks(start));
+    } else {
+        background_context();
+        exec_stats_add(&background_stats[minor_cycle],
+                       bsp_get_timer_elapsed_ticks(start));
+    }
+}
+
+
 /**
  * @brief PRIMARY execution context.
  *
@@ -172,6 +229,8 @@ static void initialize_scheduler(void)
 {
     curr_minor_cycle = NUM_MINOR_CYCLES - 1;    /* last cycle */
     curr_context     = E_CONTEXT_BACKGROUND;    /* in the background context */
+    report_line      = REPORT_IDLE;             /* no report requested */
+    reset_scheduler_stats();
 
     /* Enable interrupts before starting the timer so the first interrupt won't
        be missed. */
@@ -183,6 +242,72 @@ static void initialize_scheduler(void)
 }
 
 
+/**
+ * @brief Clear the overrun counters and execution time statistics.
+ */
+static void reset_scheduler_stats(void)
+{
+    size_t cycle;
+
+    for (cycle = 0u; cycle < NUM_MINOR_CYCLES; cycle += 1u) {
+        overruns[cycle] = 0u;
+        exec_stats_reset(&primary_stats[cycle]);
+        exec_stats_reset(&background_stats[cycle]);
+    }
+}
+
+
+/**
+ * @brief Report the scheduler accounting when it is requested.
+ *
+ * For every minor cycle the report lists the overruns, and the min/avg/max
+ * execution time of the PRIMARY context and of a single BACKGROUND pass. The
+ * budget line is the length of a minor cycle in the same timer ticks. The
+ * statistics start over after each report.
+ *
+ * The report is written a line per call, as the transmit buffer makes room, so
+ * the task never waits for the transmitter.
+ */
+static void scheduler_report_task(void)
+{
+    size_t cycle;
+    bool_t written;
+    u8_t   byte;
+
+    written = E_FALSE;
+
+    if (REPORT_IDLE == report_line) {
+        if ((E_TRUE == bsp_serial_read(&byte)) && (REPORT_REQUEST == byte)) {
+            report_line = REPORT_BUDGET;
+        }
+    } else if (REPORT_BUDGET == report_line) {
+        written = LOG("\nBudget: %u ticks per minor cycle\n", bsp_get_timer_period_ticks());
+    } else if (REPORT_HEADER == report_line) {
+        written = LOG_MSG("cycle overruns primary(min avg max) background(min avg max)\n");
+    } else {
+        cycle   = (size_t)(report_line - REPORT_FIRST_CYCLE);
+        written = LOG("%u %u %u %u %u %u %u %u\n",
+                      (u16_t)cycle,
+                      overruns[cycle],
+                      primary_stats[cycle].min,
+                      exec_stats_avg(&primary_stats[cycle]),
+                      primary_stats[cycle].max,
+                      background_stats[cycle].min,
+                      exec_stats_avg(&background_stats[cycle]),
+                      background_stats[cycle].max);
+    }
+
+    if (E_TRUE == written) {
+        report_line += 1u;
+
+        if ((REPORT_FIRST_CYCLE + NUM_MINOR_CYCLES) == report_line) {
+            reset_scheduler_stats();
+            report_line = REPORT_IDLE;
+        }
+    }
+}
+
+
 /**
  * @brief Scheduler ISR for context switching.
  *
@@ -193,10 +318,15 @@ static void initialize_scheduler(void)
  */
 static void scheduler_isr(void)
 {
-    /* Transition the scheduler context back to the PRIMARY context. In a real
-       system, it would be smart to check if the scheduler is still within the
-       PRIMARY context. If context is still PRIMARY by the time this ISR runs,
-       that would indicate a minor cycle overrun. */
+    /* If the context is still PRIMARY by the time this ISR runs, the PRIMARY
+       context of the ending minor cycle did not finish (or start) within its
+       cycle. Count the overrun against that cycle. */
+    if ((E_CONTEXT_PRIMARY == curr_context)
+        && (MAX_OVERRUNS > overruns[curr_minor_cycle])) {
+        overruns[curr_minor_cycle] += 1u;
+    }
+
+    /* Transition the scheduler context back to the PRIMARY context. */
     curr_context = E_CONTEXT_PRIMARY;
 
     /* Increment to the next minor cycle and roll back to zero when the cycle
@@ -1,19 +1,31 @@
+#include <avr/pgmspace.h>
+
 #include "bsp/bsp.h"
+#include "bsp/cpu_load.h"
 #include "bsp/sw_timers.h"
 #include "types.h"
 
+/* An ENQ character (Ctrl-E) requests the CPU load report. */
+#define LOAD_REQUEST    (0x05u)
+
 static SwTimerHandle_t delay_timer;
 static const u32_t MESSAGE_DELAY_SEC = 1u;
+static bool_t load_report_pending;     /* requested, waiting for room */
 
 static void say_hello(void);
+static bool_t load_report_task(void);
 
 /**
  * @brief Hello, UART!
  *
  * Display "Hello, UART!" in your favorite terminal program.
+ *
+ * An ENQ character (Ctrl-E) reports the CPU load of the main loop.
  */
 int main(void)
 {
+    bool_t busy;
+
     /* Initialize the hardware and software modules */
     bsp_init();              /* board support (e.g. the LED) */
     sw_timer_init();         /* software timer facility */
@@ -27,15 +39,27 @@ int main(void)
     /* enable interrupts */
     bsp_enable_interrupts();
 
+    /* CPU load meter (calibrates over the first idle loop passes) */
+    cpu_load_init();
+
     /* Scheduler loop */
     while (1) {
+        busy = E_FALSE;
+
         sw_timer_task();
 
         /* Print the message once we hit the timeout value. */
         if (MESSAGE_DELAY_SEC == sw_timer_sec(delay_timer)) {
             say_hello();
             sw_timer_reset(delay_timer);
+            busy = E_TRUE;
+        }
+
+        if (E_TRUE == load_report_task()) {
+            busy = E_TRUE;
         }
+
+        cpu_load_iteration(busy);
     }
 
     return 0; /* Satisfy compiler. Should never get here */
@@ -45,15 +69,40 @@ static void say_hello(void)
 {
     bool_t success;
     const char * curr_char;
-    static const char * const MESSAGE = "Hello, UART!\n\r";
+    char c;
+
+    /* The message stays in flash, read it a character at a time. */
+    static const char MESSAGE[] PROGMEM = "Hello, UART!\n\r";
 
     curr_char = MESSAGE;
-    while ('\0' != *curr_char) {
-        success = bsp_serial_write((u8_t)*curr_char);
+    c         = (char)pgm_read_byte(curr_char);
+    while ('\0' != c) {
+        success = bsp_serial_write((u8_t)c);
         if (E_FALSE == success) {
             bsp_error_trap();
         }
 
         curr_char += 1;
+        c          = (char)pgm_read_byte(curr_char);
     }
+}
+
+static bool_t load_report_task(void)
+{
+    bool_t did_work;
+    u8_t   byte;
+
+    did_work = E_FALSE;
+
+    if ((E_FALSE == load_report_pending) && (E_TRUE == bsp_serial_read(&byte)) && (LOAD_REQUEST == byte)) {
+        load_report_pending = E_TRUE;
+        did_work            = E_TRUE;
+    }
+
+    if ((E_TRUE == load_report_pending) && (E_TRUE == cpu_load_report())) {
+        load_report_pending = E_FALSE;
+        did_work            = E_TRUE;
+    }
+
+    return did_work;
 }
\ No newline at end of file
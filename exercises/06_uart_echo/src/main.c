@@ -1,35 +1,79 @@
 #include "bsp/bsp.h"
+#include "bsp/cpu_load.h"
+#include "bsp/sw_timers.h"
 #include "types.h"
 
-static void echo(void);
+/* An ENQ character (Ctrl-E) requests the CPU load report instead of an echo. */
+#define LOAD_REQUEST    (0x05u)
+
+/* Listen for the baud rate of the terminal first (see the top level
+   CMakeLists.txt). */
+#ifndef BSP_SERIAL_AUTOBAUD_MSEC
+#define BSP_SERIAL_AUTOBAUD_MSEC    (0u)
+#endif
+
+static bool_t echo(void);
+
+static bool_t load_report_pending;     /* requested, waiting for room */
 
 /**
  * @brief UART echo
  *
  * Echo data from the serial port back to the host.
+ *
+ * An ENQ character (Ctrl-E) reports the CPU load of the main loop.
+ *
+ * Built with BSP_SERIAL_AUTOBAUD_MSEC, the echo first waits that long for a
+ * 'U' and takes the terminal's baud rate from it.
  */
 int main(void)
 {
     /* Initialize the hardware and software modules */
     bsp_init();              /* board support (e.g. the LED) */
+    sw_timer_init();         /* time base of the CPU load meter */
 
     /* enable interrupts */
     bsp_enable_interrupts();
 
+    /* Follow the terminal's baud rate (before the software timers run) */
+    if (0u != BSP_SERIAL_AUTOBAUD_MSEC) {
+        (void)bsp_serial_autobaud(BSP_SERIAL_AUTOBAUD_MSEC, NULL_PTR);
+    }
+
+    /* CPU load meter (calibrates over the first idle loop passes) */
+    cpu_load_init();
+
     /* Scheduler loop */
     while (1) {
-        echo();
+        cpu_load_iteration(echo());
     }
 
     return 0; /* Satisfy compiler. Should never get here */
 }
 
-static void echo(void)
+static bool_t echo(void)
 {
-    u8_t byte;
+    bool_t did_work;
+    u8_t   byte;
+
+    did_work = E_FALSE;
 
-    if (E_TRUE == bsp_serial_read(&byte)) {
-        bsp_serial_write(byte);
-        bsp_toggle_builtin_led();
+    /* Reception waits behind a pending report so the echo stays in order. */
+    if (E_TRUE == load_report_pending) {
+        if (E_TRUE == cpu_load_report()) {
+            load_report_pending = E_FALSE;
+            did_work            = E_TRUE;
+        }
+    } else if (E_TRUE == bsp_serial_read(&byte)) {
+        did_work = E_TRUE;
+
+        if (LOAD_REQUEST == byte) {
+            load_report_pending = E_TRUE;
+        } else {
+            bsp_serial_write(byte);
+            bsp_toggle_builtin_led();
+        }
     }
+
+    return did_work;
 }
\ No newline at end of file
@@ -1,6 +1,8 @@
 #include "statistics.h"
 #include "bsp/bsp.h"
+#include "bsp/cpu_load.h"
 #include "bsp/sw_timers.h"
+#include "bsp/trace.h"
 #include "types.h"
 
 #define TOGGLE_PERIOD_MSEC (500U)
@@ -15,14 +17,19 @@
  * - number of digits
  * - number of whitespace characters (including the new line but not NULL)
  * - number of punctuation characters
+ *
+ * An ENQ character (Ctrl-E) reports the peak stack usage and the CPU load (and
+ * drains the event trace when it is compiled in) instead.
  */
 int main(void)
 {
     SwTimerHandle_t delay_timer;
+    bool_t          busy;
 
     /* Initialize the hardware and software modules */
     bsp_init();         /* board support (e.g. the LED) */
     sw_timer_init();    /* software timer facility */
+    trace_init();       /* event trace (when compiled in) */
     statistics_init();  /* initialize the statistics module */
 
     /* enable interrupts */
@@ -34,15 +41,25 @@ int main(void)
         bsp_error_trap();
     }
 
+    /* CPU load meter (calibrates over the first idle loop passes) */
+    cpu_load_init();
+
     /* Scheduler loop */
     while (1) {
+        busy = E_FALSE;
+
         /* Print the message once we hit the timeout value. */
         if (TOGGLE_PERIOD_MSEC == sw_timer_msec(delay_timer)) {
             bsp_toggle_builtin_led();
             sw_timer_reset(delay_timer);
+            busy = E_TRUE;
+        }
+
+        if (E_TRUE == statistics_task()) {
+            busy = E_TRUE;
         }
 
-        statistics_task();
+        cpu_load_iteration(busy);
     }
 
     return 0; /* Satisfy compiler. Should never get here */
@@ -1,10 +1,32 @@
 #include "statistics.h"
 
 #include "bsp/bsp.h"
+#include "bsp/cpu_load.h"
+#include "bsp/log.h"
+#include "bsp/trace.h"
 #include "utils/ascii_char.h"
 #include "utils/bytes.h"
 #include "types.h"
 
+/* Request character for the diagnostics report (ENQ, Ctrl-E in a terminal). */
+#define DIAGNOSTICS_REQUEST ('\x05')
+
+/**
+ * @brief The report line waiting to be written.
+ *
+ * The statistics report is one line. The diagnostics report runs from
+ * E_REPORT_STACK to E_REPORT_TRACE.
+ */
+typedef enum report
+{
+    E_REPORT_NONE,
+    E_REPORT_CONTEXT,
+    E_REPORT_STACK,
+    E_REPORT_UART,
+    E_REPORT_CPU_LOAD,
+    E_REPORT_TRACE,
+} Report_t;
+
 /**
  * @brief A statistics meseaurement element.
  */
@@ -32,26 +54,61 @@ typedef struct context
 static void reset_context(Context_t *p_ctx);
 static void process_char(Context_t*p_ctx, char byte);
 static void saturate_increment(Element_t *p_elem);
-static void output_context(Context_t *p_ctx);
-static void output_element(const Element_t *p_elem);
-static void num_to_c_str(u8_t num, char * c_str);
-static void write_c_str(const char * const c_str);
+static bool_t output_context(const Context_t *p_ctx);
+static u16_t clamp_char(const Element_t *p_elem);
+static bool_t output_report(void);
 
 static Context_t ctx;
+static Report_t  report;        /* next report line to write */
+static u8_t      echo_byte;     /* received, waiting for room to echo */
+static bool_t    echo_pending;
 
 void statistics_init(void)
 {
     reset_context(&ctx);
+    report       = E_REPORT_NONE;
+    echo_pending = E_FALSE;
 }
 
-void statistics_task(void)
+/**
+ * @brief Process the next received character.
+ *
+ * Nothing here waits for the transmitter. A report is written a line at a time
+ * as the transmit buffer makes room, and a character is only counted once its
+ * echo is written. The received characters wait in the receive buffer until
+ * then.
+ *
+ * @retval E_TRUE  - a character or a report line was processed
+ * @retval E_FALSE - nothing was received or the output is waiting for room
+ */
+bool_t statistics_task(void)
 {
-    u8_t byte;
+    bool_t did_work;
+
+    did_work = E_FALSE;
+
+    if (E_REPORT_NONE != report) {
+        did_work = output_report();
+    } else {
+        if ((E_FALSE == echo_pending) && (E_TRUE == bsp_serial_read(&echo_byte))) {
+            did_work = E_TRUE;
+
+            if (DIAGNOSTICS_REQUEST == (char)echo_byte) {
+                report = E_REPORT_STACK;
+            } else {
+                echo_pending = E_TRUE;
+            }
+        }
 
-    if (E_TRUE == bsp_serial_read(&byte)) {
-        bsp_serial_write(byte); /* Echo for easier typing */
-        process_char(&ctx, (char)byte);
+        /* Echo for easier typing */
+        if ((E_TRUE == echo_pending) && (E_TRUE == bsp_serial_write(echo_byte))) {
+            echo_pending = E_FALSE;
+            process_char(&ctx, (char)echo_byte);
+            did_work = E_TRUE;
+        }
     }
+
+    return did_work;
 }
 
 static void reset_context(Context_t *p_ctx)
@@ -76,9 +133,9 @@ static void process_char(Context_t*p_ctx, char c)
         saturate_increment(&p_ctx->punctuation);
     }
 
+    /* The context is reset once the report is written. */
     if ('\n' == c) {
-        output_context(p_ctx);
-        reset_context(p_ctx);
+        report = E_REPORT_CONTEXT;
     }
 }
 
@@ -95,102 +152,98 @@ static void saturate_increment(Element_t *p_elem)
     }
 }
 
-static void output_context(Context_t *p_ctx)
+static bool_t output_context(const Context_t *p_ctx)
 {
-    write_c_str("\n=================\n");
-    write_c_str("Letters    : ");
-    output_element(&p_ctx->letters);
-    write_c_str("\n");
-
-    write_c_str("Vowels     : ");
-    output_element(&p_ctx->vowels);
-    write_c_str("\n");
-
-    write_c_str("Digits     : ");
-    output_element(&p_ctx->digits);
-    write_c_str("\n");
-
-    write_c_str("Whitespace : ");
-    output_element(&p_ctx->whitespace);
-    write_c_str("\n");
-
-    write_c_str("Punctuation: ");
-    output_element(&p_ctx->punctuation);
-    write_c_str("\n\n");
+    /* The clamp flag is an optional character (0 prints nothing). */
+    return LOG("\n=================\n"
+        "Letters    : %u%c\n"
+        "Vowels     : %u%c\n"
+        "Digits     : %u%c\n"
+        "Whitespace : %u%c\n"
+        "Punctuation: %u%c\n\n",
+        p_ctx->letters.count,     clamp_char(&p_ctx->letters),
+        p_ctx->vowels.count,      clamp_char(&p_ctx->vowels),
+        p_ctx->digits.count,      clamp_char(&p_ctx->digits),
+        p_ctx->whitespace.count,  clamp_char(&p_ctx->whitespace),
+        p_ctx->punctuation.count, clamp_char(&p_ctx->punctuation));
 }
 
-static void output_element(const Element_t *p_elem)
+static u16_t clamp_char(const Element_t *p_elem)
 {
-    static const char * const clamp_str = "+";
-
-    /* Since the count is clamped to 255, we only need to handle 4 characters of
-       data (1 for each digit plus NULL) */
-    char c_str_buffer[4] = { 0 };
-
-    /* convert from integer to c string */
-    num_to_c_str(p_elem->count, c_str_buffer);
-
-    /* Output the numerical data */
-    write_c_str(c_str_buffer);
-    if (p_elem->clamped) {
-        write_c_str(clamp_str);
-    }
+    return (E_TRUE == p_elem->clamped) ? (u16_t)'+' : 0u;
 }
 
-static void num_to_c_str(u8_t num, char * c_str)
+/**
+ * @brief Write the next line of the pending report.
+ *
+ * @retval E_TRUE  - the line was written
+ * @retval E_FALSE - the transmit buffer has no room for it yet
+ */
+static bool_t output_report(void)
 {
-    size_t len;
-    size_t i;
-    u8_t   n;
-    u8_t   digit;
-    char   temp;
-
-    /* Exit early if the number is 0. */
-    if (0 == num) {
-        c_str[0] = '0';
-        c_str[1] = '\0';
-    } else {
-        /* This is a little inefficient since we go through two loops, but since the
-           number is limited to 3 digits, this is ok... for now.
-
-           This first loop parses the digits of num into characters and also
-           computes the length (number of digits) of the string. The parsing
-           puts the character representation of the digits in reverse order.
-
-           NOTE: The len variable is a little overloaded in this context. It is
-                 used as the index into the c_str and the length of the c_str.*/
-        n   = num;
-        len = 0;
-        while(n != 0) {
-            digit = n % 10;
-            c_str[len] = ascii_char_digit_to_ascii(digit);
-            len++;
-            n /= 10;
+    BspSerialStats_t serial;
+    bool_t           written;
+    Report_t         next;
+    u16_t            stack;
+
+    written = E_FALSE;
+    next    = E_REPORT_NONE;
+
+    switch (report) {
+        case E_REPORT_CONTEXT: {
+            written = output_context(&ctx);
+            if (E_TRUE == written) {
+                reset_context(&ctx);
+            }
+            break;
         }
 
-        /* Reverse the characters in the C string so the digits display
-           correctly.
-
-           NOTE: Only need to traverse half the array for reversal. */
-        for (i = 0; i < len/2; i += 1) {
-            temp = c_str[len - (i + 1)];
-            c_str[len - (i + 1)] = c_str[i];
-            c_str[i]             = temp;
+        case E_REPORT_STACK: {
+            stack = bsp_stack_high_water();
+            if (BSP_STACK_UNMEASURED == stack) {
+                written = LOG_MSG("\nStack peak : n/a\n");
+            } else {
+                written = LOG("\nStack peak : %u bytes\n", stack);
+            }
+            next = E_REPORT_UART;
+            break;
+        }
 
+        case E_REPORT_UART: {
+            /* Serial health since boot, to size the rings */
+            bsp_serial_get_stats(&serial, E_FALSE);
+
+            written = LOG("UART errors: %u overrun, %u framing, %u parity\n"
+                          "UART drops : %u rx, %u tx, %u pauses\n"
+                          "UART peak  : %u rx, %u tx bytes\n",
+                          serial.rx_overruns, serial.rx_framing_errors, serial.rx_parity_errors,
+                          serial.rx_drops, serial.tx_drops, serial.rx_pauses,
+                          serial.rx_peak, serial.tx_peak);
+            next = E_REPORT_CPU_LOAD;
+            break;
         }
 
-        /* Null terminate the string */
-        c_str[len] = '\0';
-    }
-}
+        case E_REPORT_CPU_LOAD: {
+            written = cpu_load_report();
+            next    = E_REPORT_TRACE;
+            break;
+        }
 
-static void write_c_str(const char * const c_str)
-{
-    const char *curr;
+        /* Binary trace frames (see scripts/trace_decode.py), a frame a call */
+        case E_REPORT_TRACE: {
+            written = trace_drain();
+            break;
+        }
 
-    for (curr = c_str; *curr != '\0'; curr += 1) {
-        if (E_FALSE == bsp_serial_write(*curr)) {
-            bsp_error_trap();
+        case E_REPORT_NONE:
+        default: {
+            break;
         }
     }
-}
\ No newline at end of file
+
+    if (E_TRUE == written) {
+        report = next;
+    }
+
+    return written;
+}
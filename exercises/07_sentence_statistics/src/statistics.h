@@ -8,7 +8,7 @@ extern "C" {
 #endif
 
 void statistics_init(void);
-void statistics_task(void);
+bool_t statistics_task(void);
 
 #ifdef __cplusplus
 }
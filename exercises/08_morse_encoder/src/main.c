@@ -1,6 +1,9 @@
 #include "string_encoder.h"
 #include "bsp/bsp.h"
+#include "bsp/cpu_load.h"
+#include "bsp/profiler.h"
 #include "bsp/sw_timers.h"
+#include "bsp/trace.h"
 #include "morse/task.h"
 #include "types.h"
 
@@ -11,16 +14,24 @@
  *
  * Encode a string from the UART into morse code and blink it out the builtin
  * LED.
+ *
+ * With BSP_PROFILER the main loop is sampled by the profiler. An ENQ character
+ * (Ctrl-E) dumps the histogram (when compiled in) and the CPU load over the
+ * UART.
  */
 int main(void)
 {
     SwTimerHandle_t morse_interval_timer;
+    bool_t          busy;
 
     /* Initialize the hardware and software modules */
     bsp_init();             /* board support (e.g. the LED) */
     sw_timer_init();        /* initialize the software timer facility */
+    trace_init();           /* event trace (when compiled in) */
     morse_task_init();      /* initialize the morse code encoder task */
     string_encoder_init();  /* initialize the string encoder processor */
+    profiler_init();        /* sample the main loop with Timer2 (when compiled in) */
+    profiler_start();
 
     /* enable interrupts */
     bsp_enable_interrupts();
@@ -31,19 +42,25 @@ int main(void)
         bsp_error_trap();
     }
 
+    /* CPU load meter (calibrates over the first idle loop passes) */
+    cpu_load_init();
+
     /* Scheduler loop */
     while (1) {
 
         /* Constantly spin the string encoder process, so we don't miss any
            bytes. */
-        string_encoder_process();
+        busy = string_encoder_process();
 
         /* Call the morse code task at the appropriate rate for morse code
            output. */
         if (MORSE_TASK_INTERVAL_MSEC == sw_timer_msec(morse_interval_timer)) {
             morse_task();
             sw_timer_reset(morse_interval_timer);
+            busy = E_TRUE;
         }
+
+        cpu_load_iteration(busy);
     }
 
     return 0; /* Satisfy compiler. Should never get here */
@@ -1,131 +1,172 @@
 #include "string_encoder.h"
 
 #include "bsp/bsp.h"
+#include "bsp/cpu_load.h"
+#include "bsp/log.h"
+#include "bsp/profiler.h"
 #include "morse/task.h"
-#include "utils/bytes.h"
 
 #define MAX_STRING_LEN 41 /* +1 to handle null terminator */
 
-static const char* ERROR_STRING = "\n\rERROR: Encoding already in progress!\n\r";
+#define PROFILE_REQUEST '\x05' /* ENQ (Ctrl-E) dumps the profiler and CPU load */
 
-static size_t the_string_idx;
-static u8_t   the_string[MAX_STRING_LEN];
+static void handle_line(char *p_line, size_t len);
+static void handle_profile_request(void);
+static bool_t is_encodable(char c);
 
-static void module_reset(void);
-static void handle_newline(void);
-static void handle_morse_byte(u8_t byte);
+static bool_t load_report_pending;  /* requested, waiting for room */
 
 /**
  * @brief Initialize the string encoder and its internal data.
+ *
+ * The serial receiver is put in line mode: it collects a line (and echoes it)
+ * on its own, and the encoder only sees finished lines.
  */
 void string_encoder_init(void)
 {
-    module_reset();
+    bsp_serial_set_line_mode(E_TRUE, E_TRUE);
+    load_report_pending = E_FALSE;
 }
 
 /**
  * @brief String encoder process
- * 
- * NOTE: This function should be called as often as possible to prevent serial
- *       port data loss.
+ *
+ * Handles the profile request character and the next received line. While a
+ * line is being handed to the morse task, the receiver keeps filling its other
+ * line buffer. The CPU load report of a profile request is written once the
+ * transmit buffer has room for it.
+ *
+ * @retval E_TRUE  - a character, line or report was processed
+ * @retval E_FALSE - nothing was received
  */
-void string_encoder_process(void)
+bool_t string_encoder_process(void)
 {
-    u8_t rx_char;
-
-    if (E_TRUE == bsp_serial_read(&rx_char)) {
-        switch(rx_char)
-        {
-            case '\0' :
-            case '~'  :
-            case '`'  :
-            case '@'  :
-            case '#'  :
-            case '$'  :
-            case '%'  :
-            case '^'  :
-            case '&'  :
-            case '*'  :
-            case '('  :
-            case ')'  :
-            case '-'  :
-            case '_'  :
-            case '='  :
-            case '+'  :
-            case '['  :
-            case '{'  :
-            case ']'  :
-            case '}'  :
-            case '\\' :
-            case '|'  :
-            case ';'  :
-            case ':'  :
-            case '\'' :
-            case '"'  :
-            case ','  :
-            case '<'  :
-            case '/'  :
-            case '\r' : /* DO NOTHING*/             break; /* Ignore these characters */
-
-            case '\n': handle_newline();            break; /* Sentence terminator */
-            default:   handle_morse_byte(rx_char);  break; /* Characters we can encode. */
-        }
+    bool_t did_work;
+    u8_t   rx_char;
+    char  *p_line;
+    size_t len;
+
+    /* Control characters arrive one at a time outside of the lines. */
+    did_work = bsp_serial_read(&rx_char);
+
+    if ((E_TRUE == did_work) && (PROFILE_REQUEST == (char)rx_char)) {
+        handle_profile_request();
+    }
+
+    if ((E_TRUE == load_report_pending) && (E_TRUE == cpu_load_report())) {
+        load_report_pending = E_FALSE;
+        did_work            = E_TRUE;
+    }
+
+    if (E_TRUE == bsp_serial_get_line(&p_line, &len)) {
+        handle_line(p_line, len);
+        bsp_serial_release_line();
+        did_work = E_TRUE;
     }
+
+    return did_work;
 }
 
 /**
- * @brief Reset the internals of the string encoder.
+ * @brief Handle a received line
+ *
+ * The characters the morse module can't encode are removed in place and the
+ * line is cut at the longest string the module accepts. Then one of two things
+ * will happen:
+ *
+ * 1. If the morse code module is already encoding a string, an error will be
+ *    transmitted over the serial port.
+ *
+ * 2. If the morse code module is idle, the line will be sent to the morse
+ *    module for encoding.
+ *
+ * @param[in,out] p_line NULL terminated line from the serial receiver
+ * @param[in]     len    length of the line
  */
-static void module_reset(void)
+static void handle_line(char *p_line, size_t len)
 {
-    the_string_idx = 0;
-    bytes_set(the_string, sizeof(the_string), 0x00);
+    size_t in;
+    size_t out;
+
+    out = 0u;
+
+    for (in = 0u; (in < len) && (out < (MAX_STRING_LEN-1)); in += 1u) {
+        if (E_TRUE == is_encodable(p_line[in])) {
+            p_line[out] = p_line[in];
+            out += 1u;
+        }
+    }
+
+    p_line[out] = '\0';
+
+    /* The morse task converts the string to wait times right away, so the line
+       buffer can go back to the receiver as soon as this returns. */
+    if (E_TRUE == morse_task_is_encoding()) {
+        /* Dropped when the transmit buffer is full */
+        (void)LOG_MSG("\n\rERROR: Encoding already in progress!\n\r");
+    } else {
+        morse_task_encode(p_line, E_FALSE);
+    }
 }
 
 /**
- * @brief Enqueue a byte that is morse encode-able into the string buffer.
- * 
- * @param[in] byte morse encode-able byte
+ * @brief Handle the profile request character
+ *
+ * The profiler histogram since the previous request is written to the serial
+ * port (see scripts/profile_report.py) and cleared for the next interval. The
+ * CPU load of the main loop follows the histogram.
  */
-static void handle_morse_byte(u8_t byte)
+static void handle_profile_request(void)
 {
-    if (the_string_idx < (MAX_STRING_LEN-1)) {
-        bsp_serial_write(byte);             /* echo */
-        the_string[the_string_idx] = byte;  /* add to our string */
-        the_string_idx += 1;                /* move to the next element */
-    }
+    profiler_dump();
+    profiler_reset();
+    load_report_pending = E_TRUE;
 }
 
 /**
- * @brief Handle the new line character
- * 
- * The new line character is our string terminator. One of two thing will happen
- * when a new line is received:
- * 
- * 1. If the morse code module is already encoding a string, an error will be
- *    transmitted over the serial port.
- * 
- * 2. If the morse code module is idle, the buffered string will be sent to the
- *    morse module for encoding.
- * 
- * In both cases, the module internals a reset for the next string.
+ * @brief Check if the morse module can encode a character.
+ *
+ * @param[in] c character of a received line
+ *
+ * @retval E_TRUE  - the character is encoded
+ * @retval E_FALSE - the character is ignored
  */
-static void handle_newline(void)
+static bool_t is_encodable(char c)
 {
-    /* If the morse code task is already encoding a string, we can't encode
-       another string. Transmit the error message. Otherwise, the morse code
-       task is waiting on us to give it a new string to encode.
-       
-       Remember to NULL terminate the string for the morse code task!! */
-    if (E_TRUE == morse_task_is_encoding()) {
-        bsp_serial_write_c_str(ERROR_STRING);
-    } else {
-        morse_task_encode((char*)the_string, E_FALSE);
-    }
+    bool_t result;
 
-    /* This moves the user's cursor down a line on their terminal */
-    bsp_serial_write_c_str("\n\r");
+    switch(c)
+    {
+        case '~'  :
+        case '`'  :
+        case '@'  :
+        case '#'  :
+        case '$'  :
+        case '%'  :
+        case '^'  :
+        case '&'  :
+        case '*'  :
+        case '('  :
+        case ')'  :
+        case '-'  :
+        case '_'  :
+        case '='  :
+        case '+'  :
+        case '['  :
+        case '{'  :
+        case ']'  :
+        case '}'  :
+        case '\\' :
+        case '|'  :
+        case ';'  :
+        case ':'  :
+        case '\'' :
+        case '"'  :
+        case ','  :
+        case '<'  :
+        case '/'  : result = E_FALSE; break; /* Ignore these characters */
+        default:    result = E_TRUE;  break; /* Characters we can encode. */
+    }
 
-    /* Always reset after getting a new line to prepare for the next string. */
-    module_reset();
+    return result;
 }
@@ -8,7 +8,7 @@ extern "C" {
 #endif
 
 void string_encoder_init(void);
-void string_encoder_process(void);
+bool_t string_encoder_process(void);
 
 #ifdef __cplusplus
 }
@@ -1,9 +1,13 @@
 #include "bsp/bsp.h"
 
 #include <avr/interrupt.h>
+#include <avr/pgmspace.h>
 #include "bsp/private/processor/reg_io.h"
+#include "bsp/private/stack/stack.h"
+#include "bsp/trace.h"
 #include "bsp/private/timer/timer.h"
 #include "bsp/private/uart/uart.h"
+#include "utils/format.h"
 
 #define LED_PORT        (GPIO_B)
 
@@ -15,6 +19,7 @@
 #define MAX_MSEC        (262u)
 #define MAX_SEC         (4u)
 
+static void print_putc(void *p_ctx, char c);
 
 /**
  * @brief BSP initialization
@@ -71,6 +76,46 @@ void bsp_set_builtin_led(on_off_t led_state)
     }
 }
 
+/**
+ * @brief Change the serial baud rate
+ *
+ * The rate is derived from the CPU clock in integer math with the speed
+ * doubler chosen automatically (see uart_set_baud). Rates whose error exceeds
+ * 2 % are refused. At 16 MHz 250000, 500000, 1000000, and 2000000 baud have no
+ * error at all.
+ *
+ * @param[in]  baud    requested rate in bits per second
+ * @param[out] p_error achieved error in 0.01 % (NULL_PTR if not needed)
+ *
+ * @retval E_TRUE  - the rate is set
+ * @retval E_FALSE - the rate is not reachable, or flow control holds output
+ *                   at the old rate; the old rate stays
+ */
+bool_t bsp_serial_set_baud(u32_t baud, s32_t *p_error)
+{
+    return uart_set_baud(baud, p_error);
+}
+
+/**
+ * @brief Take the serial baud rate from the peer
+ *
+ * Listens for a 'U' (0x55) and sets the rate it was sent at, so a node follows
+ * whatever rate its link runs at. The line is timed with the Timer1 input
+ * capture, so RXD (PD0) must also be wired to ICP1 (PB0, pin 8 of an Uno).
+ * The BSP timer stands still meanwhile; call it at startup before software
+ * timers matter. See uart_autobaud.
+ *
+ * @param[in]  timeout_msec how long to listen
+ * @param[out] p_baud       detected rate (NULL_PTR if not needed)
+ *
+ * @retval E_TRUE  - the rate was detected and set
+ * @retval E_FALSE - nothing detected in time; the old rate stays
+ */
+bool_t bsp_serial_autobaud(u16_t timeout_msec, u32_t *p_baud)
+{
+    return uart_autobaud(timeout_msec, p_baud);
+}
+
 /**
  * @brief Read a byte from the serial driver
  *
@@ -115,20 +160,442 @@ bool_t bsp_serial_write(u8_t byte)
  */
 bool_t bsp_serial_write_c_str(const char* c_str)
 {
-    const char *p_c;
-    bool_t      result;
+    size_t len;
+
+    len = 0u;
+    while ('\0' != c_str[len]) {
+        len += 1u;
+    }
+
+    /* One bulk write instead of a ring push per character. Whatever does not
+       fit is not sent. */
+    return (len == bsp_serial_write_buf((const u8_t*)c_str, len)) ? E_TRUE : E_FALSE;
+}
+
+/**
+ * @brief Write bytes that are in program memory out the serial port.
+ *
+ * Tables and messages declared PROGMEM stay in flash instead of being copied
+ * into RAM at startup. The bytes are read straight into the driver's buffer
+ * and the transmitter is started once.
+ *
+ * @param[in] p_flash bytes to write (program memory address)
+ * @param[in] len     number of bytes
+ *
+ * @return The number of bytes written. Less than len when the driver's buffer
+ * is full.
+ */
+size_t bsp_serial_write_P(const u8_t *p_flash, size_t len)
+{
+    size_t count;
+
+    count = 0u;
+    if (NULL_PTR != p_flash) {
+        count = uart_queue_P(p_flash, len);
+        uart_start_tx();
+    }
+
+    return count;
+}
+
+/**
+ * @brief Write a C-style string that is in program memory out the serial port.
+ *
+ * @param[in] c_str null terminated string in program memory (e.g. PSTR("..."))
+ *
+ * @retval E_TRUE  - successfully wrote string to serial driver
+ * @retval E_FALSE - serial driver encountered an error during write
+ */
+bool_t bsp_serial_write_c_str_P(const char *c_str)
+{
+    size_t len;
+
+    len = strlen_P(c_str);
+
+    return (len == bsp_serial_write_P((const u8_t*)c_str, len)) ? E_TRUE : E_FALSE;
+}
+
+/**
+ * @brief Formatted write out the serial port.
+ *
+ * The format string is in program memory (see utils/format.h for the
+ * conversions). Each character goes straight into the transmit buffer as it
+ * is formatted and the transmitter is started once at the end.
+ *
+ * @param[in] p_fmt format string in program memory (e.g. PSTR("..."))
+ *
+ * @retval E_TRUE  - the whole output was written
+ * @retval E_FALSE - the transmit buffer ran full and the rest was not sent
+ */
+bool_t bsp_serial_print_P(const char *p_fmt, ...)
+{
+    va_list args;
+    size_t  dropped;
+
+    dropped = 0u;
+
+    va_start(args, p_fmt);
+    (void)format_va_P(print_putc, &dropped, p_fmt, args);
+    va_end(args);
+
+    uart_start_tx();
+
+    return (0u == dropped) ? E_TRUE : E_FALSE;
+}
+
+/**
+ * @brief Read up to len bytes from the serial driver
+ *
+ * @param[out] p_buf destination of the received bytes
+ * @param[in]  len   size of the destination
+ *
+ * @return The number of bytes read (0 when nothing was received).
+ */
+size_t bsp_serial_read_buf(u8_t *p_buf, size_t len)
+{
+    size_t count;
+
+    count = 0u;
+    if (NULL_PTR != p_buf) {
+        count = uart_read_buf(p_buf, len);
+    }
+
+    return count;
+}
+
+/**
+ * @brief Write up to len bytes to the serial driver
+ *
+ * The bytes are copied in one pass and the transmitter is started once.
+ *
+ * @param[in] p_buf bytes to write
+ * @param[in] len   number of bytes
+ *
+ * @return The number of bytes written. Less than len when the driver's buffer
+ * is full; the caller decides whether to retry the rest.
+ */
+size_t bsp_serial_write_buf(const u8_t *p_buf, size_t len)
+{
+    size_t count;
 
-    p_c    = c_str;
-    result = E_TRUE;
+    count = 0u;
+    if (NULL_PTR != p_buf) {
+        count = uart_write_buf(p_buf, len);
+    }
 
-    while('\0' != *p_c) {
-        result = bsp_serial_write(*p_c);
-        p_c += 1;
+    return count;
+}
 
-        /* If an error occurs, don't bother sending the rest of the string. */
-        if (E_FALSE == result) {
-            break;
+/**
+ * @brief Write several buffers to the serial driver as one transfer
+ *
+ * The segments are queued in order until one does not fit, then the
+ * transmitter is started once for all of them. A report made of a label, a
+ * number, and a unit goes out without three separate writes. Segments marked
+ * in_flash are read from program memory.
+ *
+ * @param[in] p_segs segments to write
+ * @param[in] count  number of segments
+ *
+ * @return The number of bytes written over all segments.
+ */
+size_t bsp_serial_write_gather(const BspSerialSegment_t *p_segs, size_t count)
+{
+    size_t total;
+    size_t queued;
+    size_t s;
+
+    total = 0u;
+
+    if (NULL_PTR != p_segs) {
+        for (s = 0u; s < count; s += 1u) {
+            if (E_TRUE == p_segs[s].in_flash) {
+                queued = uart_queue_P(p_segs[s].p_data, p_segs[s].len);
+            } else {
+                queued = uart_queue_buf(p_segs[s].p_data, p_segs[s].len);
+            }
+            total += queued;
+
+            if (queued != p_segs[s].len) {
+                break;
+            }
         }
+
+        uart_start_tx();
+    }
+
+    return total;
+}
+
+/**
+ * @brief Write what fits of a buffer to the serial driver without waiting
+ *
+ * A producer with more output than the transmit buffer holds writes what
+ * fits, keeps its position, and resumes when there is room again instead of
+ * waiting or giving up. The bytes it keeps are not counted as drops.
+ *
+ * @param[in] p_buf bytes to write
+ * @param[in] len   number of bytes
+ *
+ * @return The number of bytes accepted.
+ */
+size_t bsp_serial_write_async(const u8_t *p_buf, size_t len)
+{
+    size_t accepted;
+
+    accepted = 0u;
+    if (NULL_PTR != p_buf) {
+        accepted = uart_write_async(p_buf, len);
+    }
+
+    return accepted;
+}
+
+/**
+ * @brief Get the number of bytes the serial transmit buffer has room for.
+ *
+ * @return Free bytes in the transmit buffer.
+ */
+size_t bsp_serial_tx_space(void)
+{
+    return uart_tx_space();
+}
+
+/**
+ * @brief Check if all serial output is on the line.
+ *
+ * @retval E_TRUE  - nothing is queued and the last byte was shifted out
+ * @retval E_FALSE - the transmitter is busy
+ */
+bool_t bsp_serial_tx_idle(void)
+{
+    return uart_tx_idle();
+}
+
+/**
+ * @brief Set the serial transmit notifications.
+ *
+ * on_space runs when at least space bytes are free again after a
+ * bsp_serial_write_async left less, so a producer can yield instead of
+ * polling. on_drained runs when the last queued byte left the transmitter
+ * (the TXC interrupt), e.g. before changing the baud rate or sleeping. Both
+ * run in interrupt context. NULL_PTR turns a notification off.
+ *
+ * @param[in] space      free bytes that trigger on_space (1 to 255)
+ * @param[in] on_space   callback or NULL_PTR
+ * @param[in] on_drained callback or NULL_PTR
+ */
+void bsp_serial_set_tx_notify(u8_t space, IsrCallback_t on_space, IsrCallback_t on_drained)
+{
+    uart_set_tx_notify(space, on_space, on_drained);
+}
+
+/**
+ * @brief Switch the serial receiver between byte mode and line mode.
+ *
+ * In line mode the receive interrupt assembles whole lines in a pair of
+ * buffers and bsp_serial_get_line hands them to the application without a
+ * copy. Control characters (e.g. ENQ) are still read with bsp_serial_read. See
+ * uart_set_line_mode for the editing rules.
+ *
+ * @param[in] enable E_TRUE for line mode, E_FALSE for byte mode (the default)
+ * @param[in] echo   E_TRUE to echo the line as it is typed
+ */
+void bsp_serial_set_line_mode(bool_t enable, bool_t echo)
+{
+    uart_set_line_mode(enable, echo);
+}
+
+/**
+ * @brief Get the oldest received line (line mode).
+ *
+ * The line belongs to the application until bsp_serial_release_line, and may
+ * be modified in place. The receiver fills the other buffer meanwhile.
+ *
+ * @param[out] pp_line NULL terminated line without its line end
+ * @param[out] p_len   length of the line
+ *
+ * @retval E_TRUE  - a line was received
+ * @retval E_FALSE - no complete line yet
+ */
+bool_t bsp_serial_get_line(char **pp_line, size_t *p_len)
+{
+    bool_t result;
+
+    result = E_FALSE;
+    if ((NULL_PTR != pp_line) && (NULL_PTR != p_len)) {
+        result = uart_get_line(pp_line, p_len);
+    }
+
+    return result;
+}
+
+/**
+ * @brief Give the line from bsp_serial_get_line back to the receiver.
+ */
+void bsp_serial_release_line(void)
+{
+    uart_release_line();
+}
+
+/**
+ * @brief Switch the serial receiver between byte mode and frame mode.
+ *
+ * Frames carry binary messages for machine to machine traffic: a payload and
+ * its CRC-16, COBS encoded (see utils/cobs.h) and ended by a 0x00 byte. In
+ * frame mode the receive interrupt decodes the frames as they arrive into the
+ * line buffers, so a payload is at most UART_LINE_SIZE - 2 bytes. Use RTS/CTS
+ * or no flow control; XON and XOFF are frame data here. See
+ * uart_set_frame_mode.
+ *
+ * @param[in] enable E_TRUE for frame mode, E_FALSE for byte mode
+ */
+void bsp_serial_set_frame_mode(bool_t enable)
+{
+    uart_set_frame_mode(enable);
+}
+
+/**
+ * @brief Get the oldest frame received with a good CRC (frame mode).
+ *
+ * The payload stays in the receiver's buffer, which the application may
+ * modify in place, until bsp_serial_release_frame. Bad frames are dropped and
+ * counted in the serial statistics.
+ *
+ * @param[out] pp_frame payload of the frame
+ * @param[out] p_len    payload length
+ *
+ * @retval E_TRUE  - a frame is available
+ * @retval E_FALSE - no frame
+ */
+bool_t bsp_serial_get_frame(u8_t **pp_frame, size_t *p_len)
+{
+    bool_t available;
+
+    available = E_FALSE;
+    if ((NULL_PTR != pp_frame) && (NULL_PTR != p_len)) {
+        available = uart_get_frame(pp_frame, p_len);
+    }
+
+    return available;
+}
+
+/**
+ * @brief Hand the frame from bsp_serial_get_frame back to the receiver.
+ */
+void bsp_serial_release_frame(void)
+{
+    /* Frames are decoded into the line buffers. */
+    uart_release_line();
+}
+
+/**
+ * @brief Send a payload as a frame (CRC-16, COBS encoded, delimited).
+ *
+ * The payload is encoded straight into the transmit buffer without a copy.
+ * Frames can be sent in any receiver mode.
+ *
+ * @param[in] p_data payload
+ * @param[in] len    payload length
+ *
+ * @retval E_TRUE  - the frame is queued
+ * @retval E_FALSE - no room for the whole frame; nothing was queued
+ */
+bool_t bsp_serial_write_frame(const u8_t *p_data, size_t len)
+{
+    bool_t result;
+
+    result = E_FALSE;
+    if (NULL_PTR != p_data) {
+        result = uart_write_frame(p_data, len);
+    }
+
+    return result;
+}
+
+/**
+ * @brief Read the serial driver's health counters.
+ *
+ * The receive errors the hardware flags (overrun, framing, parity), the bytes
+ * lost to full buffers in both directions, and the peak fill of the RX and TX
+ * rings since the last clear. A short write counts the bytes it could not
+ * queue, so a caller that retries counts them again.
+ *
+ * @param[out] p_stats the counters
+ * @param[in]  clear   E_TRUE to start counting over after the copy
+ */
+void bsp_serial_get_stats(BspSerialStats_t *p_stats, bool_t clear)
+{
+    if (NULL_PTR != p_stats) {
+        uart_get_stats(p_stats, clear);
+    }
+}
+
+/**
+ * @brief Select the flow control of the serial link.
+ *
+ * Without flow control a busy main loop lets the RX ring overflow at high
+ * baud rates. With it the receiver pauses the sender when the ring fill
+ * reaches the high watermark and resumes it at the low watermark, with XON and
+ * XOFF (software) or RTS on PD4 and CTS on PD3 (hardware). The transmitter
+ * honors the peer's XOFF or CTS in turn. See uart_set_flow_control.
+ *
+ * @param[in] mode flow control method
+ * @param[in] high RX ring fill that pauses the sender (at most 255)
+ * @param[in] low  RX ring fill that resumes it (below high)
+ *
+ * @retval E_TRUE  - flow control set
+ * @retval E_FALSE - invalid watermarks
+ */
+bool_t bsp_serial_set_flow_control(BspSerialFlow_t mode, u8_t high, u8_t low)
+{
+    return uart_set_flow_control(mode, high, low);
+}
+
+/**
+ * @brief Join or leave a multi-drop bus (such as RS-485) as an addressed node.
+ *
+ * The link switches to 9-bit frames and the receiver to the USART's
+ * multi-processor mode: data frames for other nodes are dropped by the
+ * hardware, so an idle node takes an RX interrupt only per address frame
+ * instead of per byte. The bytes after an address frame naming this node or
+ * BSP_SERIAL_BROADCAST are read as usual. See uart_set_multidrop.
+ *
+ * The transceiver's driver enable is not switched by the BSP; the drained
+ * callback of bsp_serial_set_tx_notify marks when the bus can be released.
+ *
+ * @param[in] enable  E_TRUE to join the bus, E_FALSE for the 8-bit link
+ * @param[in] address this node's address (not BSP_SERIAL_BROADCAST)
+ *
+ * @retval E_TRUE  - the link is switched
+ * @retval E_FALSE - flow control holds output in the old format; try again
+ */
+bool_t bsp_serial_set_multidrop(bool_t enable, u8_t address)
+{
+    return uart_set_multidrop(enable, address);
+}
+
+/**
+ * @brief Send a message to a node of the multi-drop bus.
+ *
+ * The node's address goes out as an address frame and the payload as data
+ * frames after it, behind the bytes already written.
+ *
+ * @param[in] address node address, or BSP_SERIAL_BROADCAST for all nodes
+ * @param[in] p_buf   payload
+ * @param[in] len     payload length
+ *
+ * @retval E_TRUE  - the message is queued
+ * @retval E_FALSE - not on a bus or no room for the whole message; nothing
+ *                   was queued
+ */
+bool_t bsp_serial_send_to(u8_t address, const u8_t *p_buf, size_t len)
+{
+    bool_t result;
+
+    result = E_FALSE;
+    if ((NULL_PTR != p_buf) || (0u == len)) {
+        result = uart_send_to(address, p_buf, len);
     }
 
     return result;
@@ -289,6 +756,55 @@ bool_t bsp_set_timer_period_sec(u16_t sec)
     return result;
 }
 
+/**
+ * @brief Current count of the BSP timer.
+ *
+ * The count runs from 0 up to the period set by one of the
+ * bsp_set_timer_period functions, so a tick is 0.5 usec for microsecond
+ * periods, 4 usec for millisecond periods and 64 usec for second periods.
+ *
+ * @return timer ticks since the start of the current period
+ */
+u16_t bsp_get_timer_ticks(void)
+{
+    return BSP_TIMER->TCNT;
+}
+
+/**
+ * @brief Number of ticks in one period of the BSP timer.
+ */
+u16_t bsp_get_timer_period_ticks(void)
+{
+    return BSP_TIMER->OCRA + 1u;
+}
+
+/**
+ * @brief Timer ticks elapsed since an earlier bsp_get_timer_ticks reading.
+ *
+ * The count restarts from 0 at the end of every period, so an interval that
+ * spans one period boundary is still measured correctly. Longer intervals
+ * lose a whole number of periods.
+ *
+ * @param[in] start_ticks count read at the start of the interval
+ *
+ * @return timer ticks since start_ticks
+ */
+u16_t bsp_get_timer_elapsed_ticks(u16_t start_ticks)
+{
+    u16_t now;
+    u16_t elapsed;
+
+    now = bsp_get_timer_ticks();
+
+    if (now >= start_ticks) {
+        elapsed = now - start_ticks;
+    } else {
+        elapsed = (bsp_get_timer_period_ticks() - start_ticks) + now;
+    }
+
+    return elapsed;
+}
+
 /**
  * @brief Busy loop (blocking) delay
  *
@@ -313,12 +829,57 @@ void bsp_spin_delay(size_t iter)
  * forward. The intent is that fatal errors are programming bugs and developer
  * intervention/reset are required to remediate the situation.
  *
+ * With the trace compiled in, the trap is recorded and the trace is drained
+ * over the serial port first. Interrupts are enabled for that, and the trap
+ * waits for the transmitter between frames since it never returns anyway.
+ *
  * @param[in] iter number of times to sit in the spin loop.
  */
 void bsp_error_trap(void)
 {
+    TRACE(E_TRACE_ERROR_TRAP, 0u);
+
+#if defined(BSP_TRACE)
+    sei();
+    while (E_FALSE == trace_drain()) {
+        /* wait for the transmitter to make room for the next frame */
+    }
+#endif
+
     while(1) {
         bsp_toggle_builtin_led();
         bsp_spin_delay(1);
     }
-}
\ No newline at end of file
+}
+
+/**
+ * @brief Peak stack usage since reset
+ *
+ * The free RAM between the static data and the stack is painted with a known
+ * pattern before main runs. The deepest stack byte that no longer holds the
+ * pattern is the high water mark. This includes interrupts and callbacks that
+ * a static analysis of the call graph cannot see.
+ *
+ * @return bytes of stack used at the deepest point so far, or
+ *         BSP_STACK_UNMEASURED where there is no painted stack (the host)
+ */
+u16_t bsp_stack_high_water(void)
+{
+    return stack_high_water();
+}
+
+/**
+ * @brief Formatter sink of bsp_serial_print_P.
+ *
+ * @param[inout] p_ctx count of characters that did not fit (size_t)
+ * @param[in]    c     next output character
+ */
+static void print_putc(void *p_ctx, char c)
+{
+    u8_t byte;
+
+    byte = (u8_t)c;
+    if (1u != uart_queue_buf(&byte, 1u)) {
+        *(size_t*)p_ctx += 1u;
+    }
+}
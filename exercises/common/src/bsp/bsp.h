@@ -7,23 +7,94 @@ extern "C" {
 
 #include "types.h"
 
+#define BSP_SERIAL_BROADCAST    (0xFFu)     /* multi-drop address of all nodes */
+#define BSP_STACK_UNMEASURED    (0u)        /* no painted stack (the host) */
+
+/**
+ * @brief One piece of a gathered serial write (see bsp_serial_write_gather).
+ */
+typedef struct bsp_serial_segment
+{
+    const u8_t *p_data;
+    size_t      len;
+    bool_t      in_flash;   /* p_data is in program memory (PROGMEM) */
+} BspSerialSegment_t;
+
+/**
+ * @brief Serial driver health counters (see bsp_serial_get_stats).
+ *
+ * The counters stop at 65535. The peaks are the highest number of bytes that
+ * waited in the driver's 255 byte rings.
+ */
+typedef struct bsp_serial_stats
+{
+    u16_t rx_overruns;          /* bytes the hardware lost before the RX ISR ran */
+    u16_t rx_framing_errors;    /* bytes received without a valid stop bit       */
+    u16_t rx_parity_errors;     /* bytes with a parity error (parity enabled)    */
+    u16_t rx_drops;             /* received bytes the driver had no room for     */
+    u16_t rx_pauses;            /* times flow control paused the sender          */
+    u16_t rx_frame_errors;      /* malformed or too long COBS frames             */
+    u16_t rx_crc_errors;        /* COBS frames that failed their CRC             */
+    u16_t tx_drops;             /* bytes a write could not queue (per attempt)   */
+    u8_t  rx_peak;              /* highest RX ring fill                          */
+    u8_t  tx_peak;              /* highest TX ring fill                          */
+} BspSerialStats_t;
+
+/**
+ * @brief Serial flow control methods (see bsp_serial_set_flow_control).
+ */
+typedef enum bsp_serial_flow
+{
+    E_SERIAL_FLOW_NONE = 0,     /* the default of the exercises         */
+    E_SERIAL_FLOW_XON_XOFF,     /* software: DC1/DC3 in the data stream */
+    E_SERIAL_FLOW_RTS_CTS,      /* hardware: RTS on PD4, CTS on PD3     */
+} BspSerialFlow_t;
+
 void bsp_init(void);
 void bsp_enable_interrupts(void);
 void bsp_toggle_builtin_led(void);
 void bsp_set_builtin_led(on_off_t led_state);
 
+bool_t bsp_serial_set_baud(u32_t baud, s32_t *p_error);
+bool_t bsp_serial_autobaud(u16_t timeout_msec, u32_t *p_baud);
 bool_t bsp_serial_read(u8_t * const byte);
 bool_t bsp_serial_write(u8_t byte);
 bool_t bsp_serial_write_c_str(const char* c_str);
+size_t bsp_serial_write_P(const u8_t *p_flash, size_t len);
+bool_t bsp_serial_write_c_str_P(const char *c_str);
+bool_t bsp_serial_print_P(const char *p_fmt, ...);
+size_t bsp_serial_read_buf(u8_t *p_buf, size_t len);
+size_t bsp_serial_write_buf(const u8_t *p_buf, size_t len);
+size_t bsp_serial_write_gather(const BspSerialSegment_t *p_segs, size_t count);
+size_t bsp_serial_write_async(const u8_t *p_buf, size_t len);
+size_t bsp_serial_tx_space(void);
+bool_t bsp_serial_tx_idle(void);
+void bsp_serial_set_tx_notify(u8_t space, IsrCallback_t on_space, IsrCallback_t on_drained);
+void bsp_serial_set_line_mode(bool_t enable, bool_t echo);
+bool_t bsp_serial_get_line(char **pp_line, size_t *p_len);
+void bsp_serial_release_line(void);
+void bsp_serial_set_frame_mode(bool_t enable);
+bool_t bsp_serial_get_frame(u8_t **pp_frame, size_t *p_len);
+void bsp_serial_release_frame(void);
+bool_t bsp_serial_write_frame(const u8_t *p_data, size_t len);
+void bsp_serial_get_stats(BspSerialStats_t *p_stats, bool_t clear);
+bool_t bsp_serial_set_flow_control(BspSerialFlow_t mode, u8_t high, u8_t low);
+bool_t bsp_serial_set_multidrop(bool_t enable, u8_t address);
+bool_t bsp_serial_send_to(u8_t address, const u8_t *p_buf, size_t len);
 
 void bsp_register_timer_isr_callback(IsrCallback_t cb);
 bool_t bsp_set_timer_period_uses(u16_t usec);
 bool_t bsp_set_timer_period_msec(u16_t msec);
 bool_t bsp_set_timer_period_sec(u16_t sec);
+u16_t bsp_get_timer_ticks(void);
+u16_t bsp_get_timer_period_ticks(void);
+u16_t bsp_get_timer_elapsed_ticks(u16_t start_ticks);
 
 void bsp_spin_delay(size_t iter);
 void bsp_error_trap(void);
 
+u16_t bsp_stack_high_water(void);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,202 @@
+#include "bsp/cpu_load.h"
+
+#include "private/processor/reg_io.h"
+#include "bsp/log.h"
+#include "types.h"
+
+#if defined(BSP_HOST)
+#include "bsp/private/host/host_machine.h"
+#endif
+
+/*
+ * The sliding window is made of sub-windows of 125 msec. Time is kept with the
+ * free running TIM0 of the software timers (64 usec per tick).
+ */
+#define NUM_SUB_WINDOWS     (8u)
+#define SUB_WINDOW_MSEC     (CPU_LOAD_WINDOW_MSEC / NUM_SUB_WINDOWS)
+#define USEC_PER_TIMER_CNT  (64u)
+#define TICKS_PER_WINDOW    ((u16_t)((SUB_WINDOW_MSEC * 1000u) / USEC_PER_TIMER_CNT))
+
+/**
+ * @brief Main loop passes counted in one sub-window.
+ */
+typedef struct sub_window
+{
+    u32_t idle;     /* passes where no task did any work */
+    u32_t total;    /* all passes                        */
+} SubWindow_t;
+
+static SubWindow_t windows[NUM_SUB_WINDOWS];    /* completed sub-windows        */
+static SubWindow_t curr_window;                 /* sub-window being counted     */
+static u8_t        next_window;                 /* oldest completed sub-window  */
+static u8_t        num_windows;                 /* completed sub-windows so far */
+static u16_t       window_ticks;                /* TIM0 ticks into curr_window  */
+static u8_t        prev_ticks;                  /* TIM0 count of the last pass  */
+static u32_t       idle_reference;              /* idle passes of an idle CPU   */
+
+static void close_window(void);
+
+/**
+ * @brief Start measuring the CPU load of the main loop.
+ *
+ * The first sub-window after initialization calibrates the meter. The main
+ * loop is expected to be idle for that long (no serial input, no expired
+ * timers), so the number of passes it makes is what 0% load looks like. The
+ * calibration is raised later if an idle sub-window ever makes more passes.
+ *
+ * Interrupt handlers run during the calibration as well, so their time counts
+ * as idle. The load is the share of main loop time spent doing work.
+ *
+ * @note The software timers must be initialized (sw_timer_init) since TIM0 is
+ *       the time base.
+ */
+void cpu_load_init(void)
+{
+    u8_t w;
+
+    for (w = 0u; w < NUM_SUB_WINDOWS; w += 1u) {
+        windows[w].idle  = 0u;
+        windows[w].total = 0u;
+    }
+
+    curr_window.idle  = 0u;
+    curr_window.total = 0u;
+    next_window       = 0u;
+    num_windows       = 0u;
+    window_ticks      = 0u;
+    prev_ticks        = TIM0->TCNT;
+    idle_reference    = 0u;
+}
+
+/**
+ * @brief Count one pass of the main loop.
+ *
+ * This must be called exactly once per main loop pass. Like the software
+ * timers, it relies on being called at least every 16 msec (a TIM0 rollover).
+ *
+ * @param[in] busy E_TRUE when any task did work during the pass
+ */
+void cpu_load_iteration(bool_t busy)
+{
+    u8_t curr_ticks;
+
+    curr_window.total += 1u;
+    if (E_FALSE == busy) {
+        curr_window.idle += 1u;
+
+#if defined(BSP_HOST)
+        /* An idle pass is where the host's virtual clock jumps ahead. */
+        host_machine_idle();
+#endif
+    }
+
+    /* The 8-bit subtraction takes care of a counter rollover. */
+    curr_ticks    = TIM0->TCNT;
+    window_ticks += (u8_t)(curr_ticks - prev_ticks);
+    prev_ticks    = curr_ticks;
+
+    if (TICKS_PER_WINDOW <= window_ticks) {
+        window_ticks -= TICKS_PER_WINDOW;
+        close_window();
+    }
+}
+
+/**
+ * @brief Check whether the calibration sub-window is over.
+ */
+bool_t cpu_load_is_calibrated(void)
+{
+    return (0u != idle_reference) ? E_TRUE : E_FALSE;
+}
+
+/**
+ * @brief CPU load over the sliding window.
+ *
+ * The time of an idle pass is known from the calibration, so the idle passes
+ * of the window tell how much of it the main loop spent idle. The rest is
+ * load.
+ *
+ * @return load in percent (0 until the first sub-window after calibration)
+ */
+u8_t cpu_load_percent(void)
+{
+    u32_t idle;
+    u32_t idle_max;
+    u8_t  w;
+    u8_t  load;
+
+    load = 0u;
+
+    if (0u != num_windows) {
+        idle = 0u;
+        for (w = 0u; w < num_windows; w += 1u) {
+            idle += windows[w].idle;
+        }
+
+        idle_max = idle_reference * num_windows;
+        load     = (u8_t)(100u - ((100u * idle) / idle_max));
+    }
+
+    return load;
+}
+
+/**
+ * @brief Write the CPU load over the serial port.
+ *
+ * Next to the load, the report shows the share of main loop passes in which a
+ * task did work. Busy passes take longer than idle ones, so that share is
+ * normally below the load.
+ *
+ * @retval E_TRUE  - the report was written
+ * @retval E_FALSE - the transmit buffer has no room for it yet, call again
+ */
+bool_t cpu_load_report(void)
+{
+    bool_t written;
+    u32_t  idle;
+    u32_t  total;
+    u8_t   w;
+
+    if (E_FALSE == cpu_load_is_calibrated()) {
+        written = LOG_MSG("\nCPU load   : calibrating\n");
+    } else {
+        idle  = 0u;
+        total = 0u;
+        for (w = 0u; w < num_windows; w += 1u) {
+            idle  += windows[w].idle;
+            total += windows[w].total;
+        }
+
+        written = LOG("\nCPU load   : %u%% over %u msec (%u%% of passes busy)\n",
+                      cpu_load_percent(),
+                      (u16_t)(num_windows * SUB_WINDOW_MSEC),
+                      (0u != total) ? (u16_t)(100u - ((100u * idle) / total)) : 0u);
+    }
+
+    return written;
+}
+
+/**
+ * @brief Move the current sub-window into the sliding window.
+ */
+static void close_window(void)
+{
+    if (0u == idle_reference) {
+        /* Calibration window. Guard against a loop that was never idle. */
+        idle_reference = (0u != curr_window.idle) ? curr_window.idle : 1u;
+    } else {
+        if (curr_window.idle > idle_reference) {
+            idle_reference = curr_window.idle;
+        }
+
+        windows[next_window] = curr_window;
+        next_window          = (u8_t)((next_window + 1u) % NUM_SUB_WINDOWS);
+
+        if (NUM_SUB_WINDOWS > num_windows) {
+            num_windows += 1u;
+        }
+    }
+
+    curr_window.idle  = 0u;
+    curr_window.total = 0u;
+}
@@ -0,0 +1,22 @@
+#ifndef CPU_LOAD_H
+#define CPU_LOAD_H
+
+#include "types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define CPU_LOAD_WINDOW_MSEC    (1000u) /* length of the sliding window */
+
+void cpu_load_init(void);
+void cpu_load_iteration(bool_t busy);
+bool_t cpu_load_is_calibrated(void);
+u8_t cpu_load_percent(void);
+bool_t cpu_load_report(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CPU_LOAD_H */
@@ -0,0 +1,130 @@
+#include "bsp/log.h"
+
+#include "bsp/bsp.h"
+#include "utils/format.h"
+#include "types.h"
+
+/* First byte of a deferred record. Never part of the ASCII text on the wire. */
+#define LOG_SYNC    (0xFFu)
+
+/* Bytes of a deferred record: the sync byte, the id, and 2 per argument */
+#define LOG_DEFERRED_LEN(nargs)     (3u + (2u * (size_t)(nargs)))
+
+/* Size of the staging buffer of a message. The bytes go to the serial driver
+   in bulk writes of up to this many instead of one ring push each. */
+#define LOG_OUT_SIZE    (16u)
+
+/**
+ * @brief Output staging buffer of one log message.
+ */
+typedef struct log_out
+{
+    u8_t data[LOG_OUT_SIZE];
+    u8_t len;
+} LogOut_t;
+
+static void write_byte(LogOut_t *p_out, u8_t byte);
+static void write_char(void *p_ctx, char c);
+static void count_char(void *p_ctx, char c);
+static void flush(LogOut_t *p_out);
+
+/**
+ * @brief Send a deferred log record (see LOG in log.h).
+ *
+ * @param[in] id     offset of the format string in the .logfmt section
+ * @param[in] p_args arguments (NULL_PTR when there are none)
+ * @param[in] nargs  number of arguments
+ *
+ * @retval E_TRUE  - the record was written
+ * @retval E_FALSE - the transmit buffer has no room for it yet
+ */
+bool_t log_deferred__(u16_t id, const u16_t *p_args, u8_t nargs)
+{
+    LogOut_t out;
+    bool_t   written;
+    u8_t     a;
+
+    written = E_FALSE;
+
+    if (LOG_DEFERRED_LEN(nargs) <= bsp_serial_tx_space()) {
+        out.len = 0u;
+
+        write_byte(&out, LOG_SYNC);
+        write_byte(&out, (u8_t)id);
+        write_byte(&out, (u8_t)(id >> 8u));
+
+        for (a = 0u; a < nargs; a += 1u) {
+            write_byte(&out, (u8_t)p_args[a]);
+            write_byte(&out, (u8_t)(p_args[a] >> 8u));
+        }
+
+        flush(&out);
+        written = E_TRUE;
+    }
+
+    return written;
+}
+
+/**
+ * @brief Format a log message on the target (see LOG in log.h).
+ *
+ * The message goes through the formatter of bsp_serial_print_P (see
+ * utils/format.h), with the arguments taken from the array. A first pass only
+ * measures it, so the message is written whole or not at all.
+ *
+ * @param[in] p_fmt  format string in program memory
+ * @param[in] p_args arguments (NULL_PTR when there are none)
+ * @param[in] nargs  number of arguments
+ *
+ * @retval E_TRUE  - the message was written
+ * @retval E_FALSE - the transmit buffer has no room for it yet
+ */
+bool_t log_text__(const char *p_fmt, const u16_t *p_args, u8_t nargs)
+{
+    LogOut_t out;
+    bool_t   written;
+
+    written = E_FALSE;
+
+    if (format_args_P(count_char, NULL_PTR, p_fmt, p_args, nargs) <= bsp_serial_tx_space()) {
+        out.len = 0u;
+
+        (void)format_args_P(write_char, &out, p_fmt, p_args, nargs);
+
+        flush(&out);
+        written = E_TRUE;
+    }
+
+    return written;
+}
+
+static void write_byte(LogOut_t *p_out, u8_t byte)
+{
+    if (LOG_OUT_SIZE == p_out->len) {
+        flush(p_out);
+    }
+
+    p_out->data[p_out->len] = byte;
+    p_out->len += 1u;
+}
+
+static void write_char(void *p_ctx, char c)
+{
+    write_byte((LogOut_t*)p_ctx, (u8_t)c);
+}
+
+static void count_char(void *p_ctx, char c)
+{
+    /* Only the count format_args_P returns is needed. */
+    (void)p_ctx;
+    (void)c;
+}
+
+static void flush(LogOut_t *p_out)
+{
+    /* The room for the whole message was checked up front, and only the main
+       loop writes to the transmit buffer, so it all fits. */
+    (void)bsp_serial_write_async(p_out->data, p_out->len);
+
+    p_out->len = 0u;
+}
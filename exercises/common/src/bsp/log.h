@@ -0,0 +1,68 @@
+#ifndef LOG_H
+#define LOG_H
+
+#include <avr/pgmspace.h>
+
+#include "types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Diagnostic logging.
+ *
+ * LOG_MSG(fmt) and LOG(fmt, ...) send a message over the serial port. The
+ * format is a string literal with %u, %d, %x, %c and %% conversions and every
+ * argument is passed as a 16-bit value. A %c of value 0 prints nothing, which
+ * lets a message carry an optional character.
+ *
+ * With the BSP_LOG_DEFERRED CMake option (AVR builds only, off by default) the
+ * format strings are kept in the .logfmt ELF section, which is not loaded on
+ * the part. The wire then carries a short binary record instead of the text:
+ *
+ *     0xFF <id lo> <id hi> <arg0 lo> <arg0 hi> ...
+ *
+ * where the id is the offset of the format in .logfmt. scripts/log_decode.py
+ * rebuilds the text from the .elf. Without the option the format is kept in
+ * flash and the message is formatted on the target by utils/format.h (the
+ * host backend always does this).
+ *
+ * Logging is meant for the main loop and never waits. A message is written
+ * whole or not at all: LOG and LOG_MSG return E_TRUE when it was written and
+ * E_FALSE, writing nothing, while the transmit buffer has no room for it. A
+ * caller that must not lose the message keeps its place and tries again on a
+ * later pass. A message longer than the transmit buffer (255 bytes) never fits.
+ */
+
+#define LOG_NARGS__(...)    ((u8_t)(sizeof((const u16_t[]){ __VA_ARGS__ }) / sizeof(u16_t)))
+#define LOG_ARGS__(...)     ((const u16_t[]){ __VA_ARGS__ })
+
+#if defined(BSP_LOG_DEFERRED)
+
+/* A GCC statement expression, so the record has a format of its own and LOG
+   still returns the result. */
+#define LOG_DEFERRED__(fmt, p_args, nargs)                                      \
+    __extension__ ({                                                            \
+        static const char log_fmt__[] __attribute__((section(".logfmt"))) = fmt;\
+        log_deferred__((u16_t)(size_t)log_fmt__, (p_args), (nargs));            \
+    })
+
+#define LOG_MSG(fmt)        LOG_DEFERRED__(fmt, NULL_PTR, 0u)
+#define LOG(fmt, ...)       LOG_DEFERRED__(fmt, LOG_ARGS__(__VA_ARGS__), LOG_NARGS__(__VA_ARGS__))
+
+#else
+
+#define LOG_MSG(fmt)        log_text__(PSTR(fmt), NULL_PTR, 0u)
+#define LOG(fmt, ...)       log_text__(PSTR(fmt), LOG_ARGS__(__VA_ARGS__), LOG_NARGS__(__VA_ARGS__))
+
+#endif /* BSP_LOG_DEFERRED */
+
+bool_t log_deferred__(u16_t id, const u16_t *p_args, u8_t nargs);
+bool_t log_text__(const char *p_fmt, const u16_t *p_args, u8_t nargs);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* LOG_H */
@@ -6,6 +6,25 @@
 
 typedef float FLOAT_T;
 
+#if defined(BSP_HOST)
+/*
+ * The host backend runs on an LP64 machine and shares translation units with
+ * the system headers. The size types must match the compiler's own so the
+ * typedefs are compatible redefinitions, and long is too wide for 32 bits.
+ */
+typedef __PTRDIFF_TYPE__    ssize_t;
+typedef __SIZE_TYPE__       size_t;
+
+typedef signed char         s8_t;
+typedef signed short        s16_t;
+typedef signed int          s32_t;
+typedef signed long long    s64_t;
+
+typedef unsigned char       u8_t;
+typedef unsigned short      u16_t;
+typedef unsigned int        u32_t;
+typedef unsigned long long  u64_t;
+#else
 typedef signed   int ssize_t;
 typedef unsigned int size_t;
 
@@ -18,6 +37,7 @@ typedef unsigned char       u8_t;
 typedef unsigned short      u16_t;
 typedef unsigned long       u32_t;
 typedef unsigned long long  u64_t;
+#endif
 
 /* 
  * When compiling with C11, use static_asserts to verify the widths of the types
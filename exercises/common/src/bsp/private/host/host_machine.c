@@ -0,0 +1,473 @@
+/**
+ * @file host_machine.c
+ * @brief Register-level model of the ATmega328P peripherals used by the BSP.
+ *
+ * The BSP drivers (bsp.c, timer.c, uart.c, sw_timers.c) are compiled unchanged
+ * for the host. Their register accesses land in host_io_space (see reg_io.h)
+ * and this module advances those registers in virtual time:
+ *
+ * - TIM0 and TIM1 count prescaled CPU cycles in normal or CTC mode and raise
+ *   their overflow/compare interrupts.
+ *
+ * - USART0 moves bytes between the pty and UDR at the configured baud rate and
+ *   raises the RX complete, data register empty and TX complete interrupts.
+ *
+ * - GPIO output levels are mirrored into the PIN registers, and PORTB5 (the
+ *   builtin LED) is sampled so every transition is traced.
+ *
+ * Peripherals are stepped from the host's interrupt context. Every step returns
+ * the cycle of the next event, where host_os.c moves the virtual clock next:
+ * the next TIM1 interrupt or UART frame, and at most STEP_MAX_CYCLES ahead so
+ * firmware polling TIM0 sees every tick of it.
+ */
+#include "bsp/private/host/host_machine.h"
+
+#include <avr/io.h>
+
+#include "bsp/private/host/host_os.h"
+#include "bsp/private/processor/reg_io.h"
+#include "types.h"
+
+/* Clock select bits shared by the timer control B registers */
+#define CS_MASK             (0x07u)
+
+/* Timer1 CTC mode bit (WGM12) in TCCR1B */
+#define TIM1_WGM_CTC_MASK   (1u << 3u)
+
+/* Timer interrupt flag bits */
+#define TOV_MASK            (1u << 0u)
+#define OCFA_MASK           (1u << 1u)
+
+/* LED pin on GPIO B */
+#define LED_PIN_MASK        (1u << 5u)
+#define CTS_PIN_MASK        (1u << 3u)  /* PD3, the serial flow control CTS */
+
+/* Asynchronous frame: 1 start, 8 data, 1 stop */
+#define UART_FRAME_BITS     (10u)
+
+/* Longest step: one tick of TIM0 at the 64 usec of the software timers */
+#define STEP_MAX_CYCLES     (1024u)
+
+/* Event cycle of a peripheral that has nothing coming */
+#define NO_EVENT            (~(u64_t)0u)
+
+typedef struct host_timer
+{
+    u64_t last_cycles;  /* cycle count at the last whole prescaled tick */
+} HostTimer_t;
+
+typedef struct host_uart
+{
+    u64_t rx_ready_cycles;  /* earliest cycle the next RX byte can land */
+    u64_t tx_ready_cycles;  /* cycle the transmit shifter becomes free  */
+} HostUart_t;
+
+volatile u8_t host_io_space[HOST_IO_SPACE_SIZE];
+
+/* Interrupt service routines the model can raise. They are weak so a firmware
+   that does not link a given driver simply has no handler. */
+void TIMER1_COMPA_vect(void) __attribute__((weak));
+void TIMER0_OVF_vect(void)   __attribute__((weak));
+void USART_RX_vect(void)     __attribute__((weak));
+void USART_UDRE_vect(void)   __attribute__((weak));
+void USART_TX_vect(void)     __attribute__((weak));
+
+static bool_t      started = E_FALSE;
+static u64_t       prev_cycles;
+static HostTimer_t timer0;
+static HostTimer_t timer1;
+static HostUart_t  uart;
+static u8_t        led_state;
+
+static unsigned long long machine_step(unsigned long long now);
+static u64_t next_event(u64_t now);
+static u64_t timer1_event(u64_t now);
+static u16_t timer_prescale(u8_t tccrb);
+static u32_t timer_ticks(HostTimer_t *p_timer, u8_t tccrb, u64_t now);
+static void step_timer0(u64_t now);
+static void step_timer1(u64_t now);
+static void step_uart(u64_t now);
+static void step_gpio(u64_t now);
+static void raise_irq(volatile u8_t *p_flags, u8_t flag, u8_t mask, IsrCallback_t isr);
+
+/**
+ * @brief Global interrupt enable.
+ *
+ * The first enable also powers up the machine model. Firmware that never
+ * enables interrupts never sees its peripherals advance, which is the only
+ * difference to the real part worth knowing about.
+ */
+void host_machine_sei(void)
+{
+    if (E_FALSE == started) {
+        started = E_TRUE;
+        host_os_start(machine_step);
+    }
+
+    host_os_irq_enable();
+}
+
+/**
+ * @brief Global interrupt disable.
+ */
+void host_machine_cli(void)
+{
+    host_os_irq_disable();
+}
+
+/**
+ * @brief Global interrupt disable that returns the previous state (SREG I-bit).
+ */
+int host_machine_irq_save(void)
+{
+    return host_os_irq_save();
+}
+
+/**
+ * @brief Re-enable interrupts if they were enabled by the matching save.
+ *
+ * Takes a pointer so it can be the cleanup function of ATOMIC_BLOCK.
+ */
+void host_machine_irq_restore(const int *p_state)
+{
+    if (0 != *p_state) {
+        host_os_irq_enable();
+    }
+}
+
+/**
+ * @brief The main loop has nothing to do until the next event.
+ *
+ * Lets the virtual clock jump to that event now (see host_os_idle).
+ */
+void host_machine_idle(void)
+{
+    if (E_TRUE == started) {
+        host_os_idle();
+    }
+}
+
+/**
+ * @brief Advance every modelled peripheral to the given virtual time.
+ *
+ * @param[in] now virtual cycle count to advance to
+ *
+ * @return virtual cycle of the next event
+ */
+static unsigned long long machine_step(unsigned long long now)
+{
+    /* Interrupts are raised in vector priority order. */
+    step_timer1(now);
+    step_timer0(now);
+    step_uart(now);
+    step_gpio(now);
+
+    prev_cycles = now;
+
+    return next_event(now);
+}
+
+/**
+ * @brief Virtual cycle of the next event of the machine.
+ *
+ * The UART frames end at their ready cycles. A frame that was not started
+ * leaves its ready cycle in the past, and the step after the next byte is
+ * queued (at most STEP_MAX_CYCLES later) starts it.
+ */
+static u64_t next_event(u64_t now)
+{
+    u64_t next;
+
+    next = now + STEP_MAX_CYCLES;
+
+    if (timer1_event(now) < next) {
+        next = timer1_event(now);
+    }
+
+    if ((now < uart.rx_ready_cycles) && (uart.rx_ready_cycles < next)) {
+        next = uart.rx_ready_cycles;
+    }
+
+    if ((now < uart.tx_ready_cycles) && (uart.tx_ready_cycles < next)) {
+        next = uart.tx_ready_cycles;
+    }
+
+    return next;
+}
+
+/**
+ * @brief Virtual cycle of the next TIM1 compare match (CTC) or overflow.
+ *
+ * @return the cycle, or NO_EVENT while the timer is stopped
+ */
+static u64_t timer1_event(u64_t now)
+{
+    u16_t prescale;
+    u32_t count;
+    u32_t period;
+    u32_t ticks;
+    u64_t event;
+
+    prescale = timer_prescale(TIM1->TCCRB);
+
+    if (0u == prescale) {
+        event = NO_EVENT;
+    } else {
+        if (0u != (TIM1->TCCRB & TIM1_WGM_CTC_MASK)) {
+            period = (u32_t)TIM1->OCRA + 1u;
+        } else {
+            period = 0x10000u;
+        }
+
+        /* Past TOP the counter runs on to MAX and wraps first (see step_timer1). */
+        count = TIM1->TCNT;
+        if (count >= period) {
+            ticks = (0x10000u - count) + period;
+        } else {
+            ticks = period - count;
+        }
+
+        event = timer1.last_cycles + ((u64_t)ticks * prescale);
+        if (event <= now) {
+            event = now + 1u;
+        }
+    }
+
+    return event;
+}
+
+/**
+ * @brief CPU cycles per timer tick.
+ *
+ * @param[in] tccrb timer control register B (clock select bits)
+ *
+ * @return the prescale factor, or 0 when the timer is stopped
+ */
+static u16_t timer_prescale(u8_t tccrb)
+{
+    /* CS[2:0] = 6 and 7 are external clock sources that are never wired. */
+    static const u16_t PRESCALE[8] = { 0u, 1u, 8u, 64u, 256u, 1024u, 0u, 0u };
+
+    return PRESCALE[tccrb & CS_MASK];
+}
+
+/**
+ * @brief Whole prescaled timer ticks since the last call.
+ *
+ * @param[inout] p_timer timer model state
+ * @param[in]    tccrb   timer control register B (clock select bits)
+ * @param[in]    now     current virtual cycle count
+ *
+ * @return number of timer ticks to apply to the counter
+ */
+static u32_t timer_ticks(HostTimer_t *p_timer, u8_t tccrb, u64_t now)
+{
+    u16_t prescale;
+    u64_t ticks;
+
+    prescale = timer_prescale(tccrb);
+
+    if (0u == prescale) {
+        /* A stopped timer does not accumulate time. */
+        p_timer->last_cycles = now;
+        ticks = 0u;
+    } else {
+        ticks = (now - p_timer->last_cycles) / prescale;
+        p_timer->last_cycles += ticks * prescale;
+    }
+
+    return (u32_t)ticks;
+}
+
+/**
+ * @brief TIM0 in normal mode (free running 8-bit counter, overflow interrupt).
+ */
+static void step_timer0(u64_t now)
+{
+    u32_t count;
+
+    count = (u32_t)TIM0->TCNT + timer_ticks(&timer0, TIM0->TCCRB, now);
+    TIM0->TCNT = (u8_t)count;
+
+    if (0xFFu < count) {
+        raise_irq(&TIM0_IRQ->TIFR, TOV_MASK, (u8_t)(1u << TOIE0), TIMER0_OVF_vect);
+    }
+}
+
+/**
+ * @brief TIM1 in normal or CTC (TOP = OCR1A) mode.
+ */
+static void step_timer1(u64_t now)
+{
+    u32_t count;
+    u32_t period;
+    u32_t ticks;
+
+    ticks = timer_ticks(&timer1, TIM1->TCCRB, now);
+    if (0u == ticks) {
+        return;
+    }
+
+    if (0u != (TIM1->TCCRB & TIM1_WGM_CTC_MASK)) {
+        period = (u32_t)TIM1->OCRA + 1u;
+    } else {
+        period = 0x10000u;
+    }
+
+    /* A counter already past TOP (OCR1A lowered while running) runs on to MAX
+       and wraps before it can match again. */
+    count = TIM1->TCNT;
+    if (count >= period) {
+        if ((count + ticks) <= 0xFFFFu) {
+            TIM1->TCNT = (u16_t)(count + ticks);
+            return;
+        }
+
+        ticks -= 0x10000u - count;
+        count  = 0u;
+    }
+
+    count += ticks;
+    TIM1->TCNT = (u16_t)(count % period);
+
+    if (count >= period) {
+        if (0x10000u == period) {
+            raise_irq(&TIM1_IRQ->TIFR, TOV_MASK, (u8_t)(1u << TOIE1), NULL_PTR);
+        } else {
+            raise_irq(&TIM1_IRQ->TIFR, OCFA_MASK, (u8_t)(1u << OCIE1A), TIMER1_COMPA_vect);
+        }
+    }
+}
+
+/**
+ * @brief USART0 in asynchronous interrupt driven mode.
+ *
+ * The model relies on the driver's UDRE ISR either writing UDR or clearing
+ * UDRIE, which is the only correct way to service that interrupt. The RX model
+ * needs RXCIE since it cannot see UDR being read. The pty carries 8-bit bytes,
+ * so the TXB8 of a 9-bit frame is lost on the way out.
+ */
+static void step_uart(u64_t now)
+{
+    u64_t byte_cycles;
+    u16_t ubrr;
+    u8_t  byte;
+
+    ubrr        = (u16_t)(((USART0->UBRRH & 0x0Fu) << 8u) | USART0->UBRRL);
+    byte_cycles = (u64_t)UART_FRAME_BITS * (ubrr + 1u)
+                * ((0u != (USART0->UCSRA & UART_UCSRA_U2X_MASK)) ? 8u : 16u);
+
+    /* Receiver: one byte per frame time while the pty has data. */
+    if (uart.rx_ready_cycles < prev_cycles) {
+        uart.rx_ready_cycles = prev_cycles;
+    }
+
+    while ((0u != (USART0->UCSRB & UART_UCSRB_RXEN_MASK))  &&
+           (0u != (USART0->UCSRB & UART_UCSRB_RXCIE_MASK)) &&
+           (uart.rx_ready_cycles <= now) &&
+           (0 != host_os_uart_read(&byte))) {
+        /* The pty has no 9th bit, so every byte is a data frame, which the
+           multi-processor mode (MPCM) filters out. */
+        if (0u == (USART0->UCSRA & UART_UCSRA_MPCM_MASK)) {
+            USART0->UDR    = byte;
+            USART0->UCSRA |= UART_UCSRA_RXC_MASK;
+            USART0->UCSRB &= (u8_t)~UART_UCSRB_RXB8_MASK;
+
+            if (NULL_PTR != USART_RX_vect) {
+                USART_RX_vect();
+            }
+
+            USART0->UCSRA &= (u8_t)~UART_UCSRA_RXC_MASK;
+        }
+        uart.rx_ready_cycles += byte_cycles;
+    }
+
+    /* Transmitter: one byte per frame time while UDRIE is set. */
+    if (uart.tx_ready_cycles < prev_cycles) {
+        uart.tx_ready_cycles = prev_cycles;
+    }
+
+    if (uart.tx_ready_cycles <= now) {
+        USART0->UCSRA |= UART_UCSRA_UDRE_MASK;
+    }
+
+    while ((0u != (USART0->UCSRB & UART_UCSRB_TXEN_MASK))  &&
+           (0u != (USART0->UCSRB & UART_UCSRB_UDRIE_MASK)) &&
+           (uart.tx_ready_cycles <= now) &&
+           (NULL_PTR != USART_UDRE_vect)) {
+        USART_UDRE_vect();
+
+        if (0u != (USART0->UCSRB & UART_UCSRB_UDRIE_MASK)) {
+            host_os_uart_write(USART0->UDR);
+            uart.tx_ready_cycles += byte_cycles;
+            USART0->UCSRA &= (u8_t)~(UART_UCSRA_UDRE_MASK | UART_UCSRA_TXC_MASK);
+        }
+    }
+
+    /* TXC is the model's: the line is idle once the shifter is free and the
+       driver stopped feeding it. The driver's write-one-to-clear is undone
+       above after every byte. */
+    if ((uart.tx_ready_cycles <= now) &&
+        (0u == (USART0->UCSRB & UART_UCSRB_UDRIE_MASK))) {
+        USART0->UCSRA |= UART_UCSRA_TXC_MASK;
+
+        /* The vector clears the flag on entry. */
+        if ((0u != (USART0->UCSRB & UART_UCSRB_TXCIE_MASK)) && (NULL_PTR != USART_TX_vect)) {
+            USART0->UCSRA &= (u8_t)~UART_UCSRA_TXC_MASK;
+            USART_TX_vect();
+        }
+    }
+}
+
+/**
+ * @brief Drive the pins and trace transitions of the builtin LED (PORTB5).
+ *
+ * Nothing external drives the inputs, so an input pin reads back its pull-up
+ * setting. The exception is CTS: the pseudo terminal always takes data, so
+ * it is held asserted (low).
+ */
+static void step_gpio(u64_t now)
+{
+    static GpioPortTypeDef * const PORTS[] = { GPIO_B, GPIO_C, GPIO_D };
+
+    size_t p;
+    u8_t   state;
+
+    for (p = 0u; p < (sizeof(PORTS) / sizeof(PORTS[0])); p += 1u) {
+        PORTS[p]->PIN = PORTS[p]->PORT;
+    }
+
+    GPIO_D->PIN &= (u8_t)~CTS_PIN_MASK;
+
+    state = GPIO_B->PORT & GPIO_B->DDR & LED_PIN_MASK;
+
+    if (state != led_state) {
+        led_state = state;
+        host_os_led_trace(now, (0u != state) ? 1 : 0);
+    }
+}
+
+/**
+ * @brief Set an interrupt flag and run the ISR if that interrupt is enabled.
+ *
+ * The model always runs with interrupts enabled (the step itself is the
+ * interrupt context), so an enabled source is serviced immediately and its flag
+ * is cleared on vector entry like the hardware does.
+ *
+ * @param[inout] p_flags interrupt flag register (TIFRn)
+ * @param[in]    flag    flag bit to set
+ * @param[in]    mask    interrupt enable bit in TIMSKn
+ * @param[in]    isr     interrupt service routine or NULL_PTR
+ */
+static void raise_irq(volatile u8_t *p_flags, u8_t flag, u8_t mask, IsrCallback_t isr)
+{
+    /* TIMSKn sits 57 bytes after TIFRn (see TimerIrqRegTypeDef). */
+    const TimerIrqRegTypeDef *p_irq = (const TimerIrqRegTypeDef *)p_flags;
+
+    *p_flags |= flag;
+
+    if ((0u != (p_irq->TIMSK & mask)) && (NULL_PTR != isr)) {
+        *p_flags &= (u8_t)~flag;
+        isr();
+    }
+}
@@ -0,0 +1,18 @@
+#ifndef HOST_MACHINE_H
+#define HOST_MACHINE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+void host_machine_sei(void);
+void host_machine_cli(void);
+int host_machine_irq_save(void);
+void host_machine_irq_restore(const int *p_state);
+void host_machine_idle(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* HOST_MACHINE_H */
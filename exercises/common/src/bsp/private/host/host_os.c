@@ -0,0 +1,468 @@
+/**
+ * @file host_os.c
+ * @brief POSIX side of the host BSP backend.
+ *
+ * The host backend emulates the microcontroller inside a normal Linux process:
+ *
+ * - Interrupts are delivered by a periodic SIGALRM. The handler runs on the
+ *   application's only thread, so just like on the AVR an ISR preempts the main
+ *   loop at an arbitrary instruction and never runs concurrently with it.
+ *   Masking the signal is the global interrupt disable.
+ *
+ * - Time is a virtual CPU cycle count that advances in discrete steps. Each
+ *   step jumps to the next event of the machine model (a timer interrupt, a
+ *   UART frame, or at most one tick of the software timers' time base), so the
+ *   firmware sees every event in order no matter how fast the clock runs. A
+ *   step is taken when the firmware reports an idle main loop pass
+ *   (host_os_idle) and, for firmware that never does, every STEP_PERIOD_USEC
+ *   of real time.
+ *
+ * - With a speed factor the virtual clock is paced: a step never moves it past
+ *   the real time elapsed times the speed. With BSP_HOST_SPEED=max it is not
+ *   paced at all and runs as fast as the firmware goes idle. It then holds at
+ *   cycle 0 until the UART pty is opened, so a script cannot miss output.
+ *
+ * - The UART is the master side of a pseudo-terminal.
+ *
+ * - The builtin LED is written to a trace file as timestamped transitions.
+ *
+ * The backend is configured through the environment:
+ *
+ *   BSP_HOST_SPEED      virtual seconds per real second, or max (default 1)
+ *   BSP_HOST_PTY        path of a symlink to create to the UART pty
+ *   BSP_HOST_LED_TRACE  file receiving the LED trace (default stderr)
+ *   BSP_HOST_EXIT_SEC   exit after this many virtual seconds without a byte
+ *                       received on the UART (default: run forever)
+ */
+#define _DEFAULT_SOURCE
+#define _XOPEN_SOURCE 600
+
+#include "bsp/private/host/host_os.h"
+
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <sys/time.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+
+#define STEP_PERIOD_USEC    (20)            /* real time between machine steps */
+#define NSEC_PER_SEC        (1000000000.0)
+#define USEC_PER_SEC        (1000000ull)
+#define DRAIN_POLL_USEC     (1000)          /* real time between drain checks */
+#define DRAIN_TIMEOUT_USEC  (1000000)       /* longest wait for the UART peer */
+
+static struct timespec start_time;          /* real time of virtual cycle 0   */
+static double cycles_per_nsec;              /* virtual cycles per real nsec (0: not paced) */
+static unsigned long long now_cycles;       /* the virtual clock              */
+static unsigned long long next_cycles;      /* next event of the machine      */
+static unsigned long long input_cycles;     /* last byte received (or start)  */
+static unsigned long long exit_cycles;      /* run time without input (0: forever) */
+static HostOsStep_t machine_step;           /* machine model step function    */
+static sigset_t irq_set;                    /* the "interrupt" signal         */
+static int uart_fd = -1;                    /* pty master (the UART wire)     */
+static int uart_slave_fd = -1;              /* pty slave (open while paced)   */
+static char uart_slave_name[64];            /* path of the pty slave          */
+static int uart_peer = 1;                   /* the UART pty has been opened   */
+static int led_fd = STDERR_FILENO;          /* LED trace output               */
+
+static void irq_handler(int signum);
+static void step(void);
+static int step_is_due(void);
+static unsigned long long real_cycles(void);
+static void drain_and_exit(void);
+static double read_speed(void);
+static double read_exit_sec(void);
+static void open_uart(void);
+static void open_led_trace(void);
+static char *decimal_before(char *p_end, unsigned long long value);
+
+/**
+ * @brief Start the virtual machine.
+ *
+ * Captures the real time origin, opens the UART and LED trace, and starts the
+ * periodic interrupt signal that steps the machine model. The machine takes its
+ * first step at virtual cycle 0.
+ *
+ * @param[in] step_fn machine model step function
+ */
+void host_os_start(HostOsStep_t step_fn)
+{
+    struct sigaction action;
+    struct itimerval period;
+
+    clock_gettime(CLOCK_MONOTONIC, &start_time);
+    cycles_per_nsec = read_speed() * ((double)F_CPU / NSEC_PER_SEC);
+    exit_cycles     = (unsigned long long)(read_exit_sec() * (double)F_CPU);
+    machine_step    = step_fn;
+
+    open_uart();
+    open_led_trace();
+
+    sigemptyset(&irq_set);
+    sigaddset(&irq_set, SIGALRM);
+
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = irq_handler;
+    action.sa_flags   = SA_RESTART;
+    sigemptyset(&action.sa_mask);
+    sigaction(SIGALRM, &action, NULL);
+
+    period.it_interval.tv_sec  = 0;
+    period.it_interval.tv_usec = STEP_PERIOD_USEC;
+    period.it_value            = period.it_interval;
+    setitimer(ITIMER_REAL, &period, NULL);
+}
+
+/**
+ * @brief Step the machine from an idle pass of the main loop.
+ *
+ * The firmware has nothing to do until the next event, so the clock jumps to
+ * it right away instead of waiting for the periodic signal. The step is an
+ * interrupt, so it is skipped while interrupts are disabled.
+ */
+void host_os_idle(void)
+{
+    int enabled;
+
+    if (0 != step_is_due()) {
+        enabled = host_os_irq_save();
+
+        if (0 != enabled) {
+            step();
+            host_os_irq_enable();
+        }
+    }
+}
+
+/**
+ * @brief Global interrupt enable (unblock the interrupt signal).
+ */
+void host_os_irq_enable(void)
+{
+    sigprocmask(SIG_UNBLOCK, &irq_set, NULL);
+}
+
+/**
+ * @brief Global interrupt disable (block the interrupt signal).
+ */
+void host_os_irq_disable(void)
+{
+    sigprocmask(SIG_BLOCK, &irq_set, NULL);
+}
+
+/**
+ * @brief Global interrupt disable that reports the previous state.
+ *
+ * @retval 1 - interrupts were enabled
+ * @retval 0 - interrupts were already disabled (e.g. inside an ISR)
+ */
+int host_os_irq_save(void)
+{
+    sigset_t prev_set;
+
+    sigprocmask(SIG_BLOCK, &irq_set, &prev_set);
+
+    return (0 == sigismember(&prev_set, SIGALRM)) ? 1 : 0;
+}
+
+/**
+ * @brief Non-blocking read of one byte from the UART wire.
+ *
+ * @param[out] byte received byte
+ *
+ * @retval 1 - a byte was received
+ * @retval 0 - nothing to receive
+ */
+int host_os_uart_read(unsigned char *byte)
+{
+    int received;
+
+    received = (1 == read(uart_fd, byte, 1)) ? 1 : 0;
+    if (0 != received) {
+        input_cycles = now_cycles;
+    }
+
+    return received;
+}
+
+/**
+ * @brief Put one byte on the UART wire.
+ *
+ * Bytes are dropped when nobody drains the pty, just like a real UART with
+ * nothing connected.
+ *
+ * @param[in] byte byte to transmit
+ */
+void host_os_uart_write(unsigned char byte)
+{
+    (void)write(uart_fd, &byte, 1);
+}
+
+/**
+ * @brief Record an LED transition in the trace.
+ *
+ * Each line is "<virtual usec> <virtual cycles> <ON|OFF>". The transitions
+ * come from the machine model, which steps inside the interrupt signal handler,
+ * so the line is put together by hand (snprintf is not async-signal-safe) from
+ * the end of the buffer backwards.
+ *
+ * @param[in] cycles virtual time of the transition
+ * @param[in] on     non-zero when the LED turned on
+ */
+void host_os_led_trace(unsigned long long cycles, int on)
+{
+    static const char ON[]  = " ON\n";
+    static const char OFF[] = " OFF\n";
+
+    char   line[64];
+    char  *p_line;
+    size_t state_len;
+
+    state_len = (0 != on) ? (sizeof(ON) - 1u) : (sizeof(OFF) - 1u);
+    p_line    = &line[sizeof(line) - state_len];
+    memcpy(p_line, (0 != on) ? ON : OFF, state_len);
+
+    p_line  = decimal_before(p_line, cycles);
+    p_line -= 1;
+    *p_line = ' ';
+    p_line  = decimal_before(p_line, (cycles * USEC_PER_SEC) / (unsigned long long)F_CPU);
+
+    (void)write(led_fd, p_line, (size_t)(&line[sizeof(line)] - p_line));
+}
+
+/**
+ * @brief Interrupt signal handler.
+ *
+ * The kernel blocks SIGALRM while the handler runs, which matches the AVR
+ * clearing the global interrupt flag on ISR entry.
+ */
+static void irq_handler(int signum)
+{
+    (void)signum;
+
+    if (0 != step_is_due()) {
+        step();
+    }
+}
+
+/**
+ * @brief Advance the virtual clock to the next event and step the machine.
+ *
+ * Runs with the interrupt signal blocked. Until the UART has a peer the clock
+ * holds (only when it is not paced, see open_uart).
+ */
+static void step(void)
+{
+    struct pollfd wire;
+
+    if (0 == uart_peer) {
+        wire.fd      = uart_fd;
+        wire.events  = POLLIN;
+        wire.revents = 0;
+
+        /* The master hangs up while no slave is open. */
+        if ((0 <= poll(&wire, 1, 0)) && (0 == (wire.revents & POLLHUP))) {
+            uart_peer = 1;
+        }
+    } else {
+        now_cycles  = next_cycles;
+        next_cycles = machine_step(now_cycles);
+
+        if ((0u != exit_cycles) && (exit_cycles <= (now_cycles - input_cycles))) {
+            drain_and_exit();
+        }
+    }
+}
+
+/**
+ * @brief Check whether the next event may be stepped to (pacing).
+ *
+ * @retval 1 - the clock is not paced, or the event is not ahead of real time
+ * @retval 0 - the event is still in the future
+ */
+static int step_is_due(void)
+{
+    return ((0.0 == cycles_per_nsec) || (next_cycles <= real_cycles())) ? 1 : 0;
+}
+
+/**
+ * @brief Real time elapsed since the machine started, in paced virtual cycles.
+ */
+static unsigned long long real_cycles(void)
+{
+    struct timespec now;
+    double elapsed_nsec;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    elapsed_nsec = ((double)(now.tv_sec - start_time.tv_sec) * NSEC_PER_SEC)
+                 + (double)(now.tv_nsec - start_time.tv_nsec);
+
+    return (unsigned long long)(elapsed_nsec * cycles_per_nsec);
+}
+
+/**
+ * @brief End the run (BSP_HOST_EXIT_SEC).
+ *
+ * Closing the pty master discards what the peer has not read yet, so the exit
+ * waits (a bounded real time) for the transmitted bytes to be drained. Only
+ * async-signal-safe calls are made since this runs from the signal handler.
+ */
+static void drain_and_exit(void)
+{
+    int pending;
+    int waited;
+
+    pending = 0;
+    waited  = 0;
+
+    if (0 > uart_slave_fd) {
+        uart_slave_fd = open(uart_slave_name, O_RDWR | O_NOCTTY | O_NONBLOCK);
+    }
+
+    if (0 <= uart_slave_fd) {
+        while ((0 == ioctl(uart_slave_fd, FIONREAD, &pending)) && (0 < pending) &&
+               (waited < DRAIN_TIMEOUT_USEC)) {
+            (void)usleep(DRAIN_POLL_USEC);
+            waited += DRAIN_POLL_USEC;
+        }
+    }
+
+    _exit(EXIT_SUCCESS);
+}
+
+/**
+ * @brief Parse the BSP_HOST_SPEED factor (defaults to real time).
+ *
+ * @return virtual seconds per real second, 0 when the clock is not paced (max)
+ */
+static double read_speed(void)
+{
+    const char *env;
+    double      speed;
+
+    env = getenv("BSP_HOST_SPEED");
+
+    if (NULL == env) {
+        speed = 1.0;
+    } else if (0 == strcmp(env, "max")) {
+        speed = 0.0;
+    } else {
+        speed = strtod(env, NULL);
+        speed = (0.0 < speed) ? speed : 1.0;
+    }
+
+    return speed;
+}
+
+/**
+ * @brief Parse BSP_HOST_EXIT_SEC (0, the default, runs forever).
+ */
+static double read_exit_sec(void)
+{
+    const char *env;
+    double      sec;
+
+    env = getenv("BSP_HOST_EXIT_SEC");
+    sec = (NULL != env) ? strtod(env, NULL) : 0.0;
+
+    return (0.0 < sec) ? sec : 0.0;
+}
+
+/**
+ * @brief Open the pseudo-terminal that stands in for the UART.
+ *
+ * The slave side is configured raw (no echo, no line editing, no CR/LF
+ * translation) so bytes pass through exactly as they would on the wire.
+ *
+ * A paced clock keeps the slave open so the master always has a peer. A clock
+ * that is not paced would run far ahead before anyone attaches, so the slave
+ * is closed once configured and the clock holds until it is opened again. The
+ * drain on exit reopens it to see what is left unread.
+ */
+static void open_uart(void)
+{
+    struct termios tio;
+    const char    *slave_name;
+    const char    *link_name;
+
+    uart_fd = posix_openpt(O_RDWR | O_NOCTTY);
+    if ((0 > uart_fd) || (0 != grantpt(uart_fd)) || (0 != unlockpt(uart_fd))) {
+        perror("bsp-host: pty");
+        exit(EXIT_FAILURE);
+    }
+
+    slave_name = ptsname(uart_fd);
+    (void)snprintf(uart_slave_name, sizeof(uart_slave_name), "%s", slave_name);
+
+    uart_slave_fd = open(slave_name, O_RDWR | O_NOCTTY);
+    if (0 == tcgetattr(uart_slave_fd, &tio)) {
+        cfmakeraw(&tio);
+        (void)tcsetattr(uart_slave_fd, TCSANOW, &tio);
+    }
+
+    if (0.0 == cycles_per_nsec) {
+        (void)close(uart_slave_fd);
+        uart_slave_fd = -1;
+        uart_peer     = 0;
+    }
+
+    (void)fcntl(uart_fd, F_SETFL, fcntl(uart_fd, F_GETFL) | O_NONBLOCK);
+
+    link_name = getenv("BSP_HOST_PTY");
+    if (NULL != link_name) {
+        (void)unlink(link_name);
+        if (0 != symlink(slave_name, link_name)) {
+            perror("bsp-host: BSP_HOST_PTY");
+        }
+    }
+
+    fprintf(stderr, "bsp-host: UART on %s\n", slave_name);
+}
+
+/**
+ * @brief Open the LED trace file (stderr when BSP_HOST_LED_TRACE is not set).
+ */
+static void open_led_trace(void)
+{
+    const char *path;
+
+    path = getenv("BSP_HOST_LED_TRACE");
+    if (NULL != path) {
+        led_fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (0 > led_fd) {
+            perror("bsp-host: BSP_HOST_LED_TRACE");
+            led_fd = STDERR_FILENO;
+        }
+    }
+}
+
+/**
+ * @brief Write a number in decimal right before p_end.
+ *
+ * Safe in the signal handler, unlike the stdio formatting.
+ *
+ * @param[in] p_end  one past the last digit
+ * @param[in] value  number to write
+ *
+ * @return Where the first digit was written.
+ */
+static char *decimal_before(char *p_end, unsigned long long value)
+{
+    char *p_digit;
+
+    p_digit = p_end;
+
+    do {
+        p_digit -= 1;
+        *p_digit = (char)('0' + (value % 10u));
+        value   /= 10u;
+    } while (0u != value);
+
+    return p_digit;
+}
@@ -0,0 +1,36 @@
+/**
+ * @brief POSIX services used by the host machine model.
+ *
+ * This header deliberately avoids the project types so it can be shared between
+ * the register-level machine model and the system-level implementation.
+ */
+#ifndef HOST_OS_H
+#define HOST_OS_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Machine step function pointer type.
+ *
+ * Called from the host's interrupt context every time the virtual clock
+ * advances. It brings the machine to the given virtual cycle and returns the
+ * cycle of its next event, which is where the clock jumps next.
+ */
+typedef unsigned long long (*HostOsStep_t)(unsigned long long now);
+
+void host_os_start(HostOsStep_t step_fn);
+void host_os_idle(void);
+void host_os_irq_enable(void);
+void host_os_irq_disable(void);
+int host_os_irq_save(void);
+int host_os_uart_read(unsigned char *byte);
+void host_os_uart_write(unsigned char byte);
+void host_os_led_trace(unsigned long long cycles, int on);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* HOST_OS_H */
@@ -0,0 +1,30 @@
+/**
+ * @file host_profiler.c
+ * @brief Host stand-in for the sampling profiler.
+ *
+ * Native builds are profiled with the host's own tools (perf, gprof), so the
+ * profiler API does nothing here.
+ */
+#include "bsp/profiler.h"
+
+#include "types.h"
+
+void profiler_init(void)
+{
+}
+
+void profiler_start(void)
+{
+}
+
+void profiler_stop(void)
+{
+}
+
+void profiler_reset(void)
+{
+}
+
+void profiler_dump(void)
+{
+}
@@ -0,0 +1,16 @@
+/**
+ * @file host_stack.c
+ * @brief Host stand-in for the stack painting module.
+ *
+ * The firmware runs on the host process stack, so there is no painted region to
+ * measure and the high water mark reads as BSP_STACK_UNMEASURED.
+ */
+#include "bsp/private/stack/stack.h"
+
+#include "bsp/bsp.h"
+#include "types.h"
+
+u16_t stack_high_water(void)
+{
+    return BSP_STACK_UNMEASURED;
+}
@@ -0,0 +1,21 @@
+/**
+ * @brief Host stand-in for the avr-libc interrupt header.
+ *
+ * Interrupt service routines become plain functions that the host machine model
+ * calls from its interrupt context (a signal handler). The global interrupt
+ * enable maps onto blocking and unblocking that signal.
+ */
+#ifndef HOST_AVR_INTERRUPT_H
+#define HOST_AVR_INTERRUPT_H
+
+#include <avr/io.h>
+
+#include "bsp/private/host/host_machine.h"
+
+#define sei()   host_machine_sei()
+#define cli()   host_machine_cli()
+
+/* The leading prototype satisfies -Wmissing-prototypes. */
+#define ISR(vector, ...)    void vector(void); void vector(void)
+
+#endif /* HOST_AVR_INTERRUPT_H */
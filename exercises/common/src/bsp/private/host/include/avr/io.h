@@ -0,0 +1,31 @@
+/**
+ * @brief Host stand-in for the avr-libc IO header.
+ *
+ * Only the vector names and register bit positions the BSP uses are provided.
+ * Registers themselves are reached through bsp/private/processor/reg_io.h.
+ */
+#ifndef HOST_AVR_IO_H
+#define HOST_AVR_IO_H
+
+/* Interrupt vectors (same numbering as avr-libc and crt0.s) */
+#define INT1_vect           __vector_2
+#define TIMER2_COMPA_vect   __vector_7
+#define TIMER2_OVF_vect     __vector_9
+#define TIMER1_CAPT_vect    __vector_10
+#define TIMER1_COMPA_vect   __vector_11
+#define TIMER0_COMPA_vect   __vector_14
+#define TIMER0_OVF_vect     __vector_16
+#define USART_RX_vect       __vector_18
+#define USART_UDRE_vect     __vector_19
+#define USART_TX_vect       __vector_20
+
+/* Timer interrupt mask bits */
+#define TOIE0   (0)
+#define OCIE0A  (1)
+#define TOIE1   (0)
+#define OCIE1A  (1)
+#define ICIE1   (5)
+#define TOIE2   (0)
+#define OCIE2A  (1)
+
+#endif /* HOST_AVR_IO_H */
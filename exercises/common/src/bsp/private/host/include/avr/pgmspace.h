@@ -0,0 +1,24 @@
+/**
+ * @brief Host stand-in for the avr-libc program memory header.
+ *
+ * The host has a single address space, so PROGMEM data is ordinary read-only
+ * data and the flash readers are plain loads and C library calls.
+ */
+#ifndef HOST_AVR_PGMSPACE_H
+#define HOST_AVR_PGMSPACE_H
+
+#include <stdint.h>
+#include <string.h>
+
+#define PROGMEM
+
+#define PSTR(s)                     (s)
+
+#define pgm_read_byte(addr)         (*(const unsigned char *)(addr))
+#define pgm_read_word(addr)         (*(const uint16_t *)(addr))
+#define pgm_read_dword(addr)        (*(const uint32_t *)(addr))
+
+#define memcpy_P(dst, src, len)     memcpy((dst), (src), (len))
+#define strlen_P(s)                 strlen(s)
+
+#endif /* HOST_AVR_PGMSPACE_H */
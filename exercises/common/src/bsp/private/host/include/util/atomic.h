@@ -0,0 +1,20 @@
+/**
+ * @brief Host stand-in for the avr-libc atomic block header.
+ *
+ * Same shape as the avr-libc macros: the block runs with interrupts disabled
+ * and the cleanup attribute restores them on every exit from the block.
+ */
+#ifndef HOST_UTIL_ATOMIC_H
+#define HOST_UTIL_ATOMIC_H
+
+#include "bsp/private/host/host_machine.h"
+
+#define ATOMIC_RESTORESTATE \
+    int host_irq_state__ __attribute__((cleanup(host_machine_irq_restore))) = host_machine_irq_save()
+
+#define ATOMIC_FORCEON \
+    int host_irq_state__ __attribute__((cleanup(host_machine_irq_restore))) = (host_machine_cli(), 1)
+
+#define ATOMIC_BLOCK(type)  for (type, host_atomic_todo__ = 1; 0 != host_atomic_todo__; host_atomic_todo__ = 0)
+
+#endif /* HOST_UTIL_ATOMIC_H */
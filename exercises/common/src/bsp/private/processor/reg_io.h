@@ -52,6 +52,26 @@ typedef struct Timer16Bit
     IO__ u16_t OCRB;
 } PACKED Timer16BitTypeDef;
 
+#define TIM_TIFR_TOV_MASK           (1u << 0u)  /* TIFRn: overflow               */
+#define TIM_TIFR_OCFA_MASK          (1u << 1u)  /* TIFRn: output compare A       */
+#define TIM1_TIFR_ICF_MASK          (1u << 5u)  /* TIFR1: input capture          */
+#define TIM1_TCCRB_CS10_MASK        (1u << 0u)  /* TCCR1B: clock, no prescaling  */
+#define TIM1_TCCRB_ICES_MASK        (1u << 6u)  /* TCCR1B: capture rising edges  */
+#define TIM1_TCCRB_ICNC_MASK        (1u << 7u)  /* TCCR1B: capture noise filter  */
+
+typedef struct ExtIrq
+{
+    IO__ u8_t  EIFR;
+    IO__ u8_t  EIMSK;
+         u8_t  reserved0[43];
+    IO__ u8_t  EICRA;
+} PACKED ExtIrqTypeDef;
+
+#define EXT_IRQ_INT0_MASK           (1u << 0u)  /* EIFR/EIMSK */
+#define EXT_IRQ_INT1_MASK           (1u << 1u)
+#define EXT_IRQ_ISC10_MASK          (1u << 2u)  /* EICRA: INT1 sense control */
+#define EXT_IRQ_ISC11_MASK          (1u << 3u)
+
 typedef struct Usart 
 {
     IO__ u8_t UCSRA;
@@ -114,16 +134,29 @@ typedef struct Usart
 #define UART_UCSRC_UMSEL1_OFFSET    (7u)
 #define UART_UCSRC_UMSEL1_MASK      (1u << UART_UCSRC_UMSEL1_OFFSET)
 
-#define GPIO_B      ((GpioPortTypeDef*)     (0x23))
-#define GPIO_C      ((GpioPortTypeDef*)     (0x26))
-#define GPIO_D      ((GpioPortTypeDef*)     (0x29))
-#define TIM0_IRQ    ((TimerIrqRegTypeDef*)  (0x35))
-#define TIM1_IRQ    ((TimerIrqRegTypeDef*)  (0x36))
-#define TIM2_IRQ    ((TimerIrqRegTypeDef*)  (0x37))
-#define TIM0        ((Timer8BitTypeDef*)    (0x44))
-#define TIM1        ((Timer16BitTypeDef*)   (0x80))
-#define TIM2        ((Timer8BitTypeDef*)    (0xB2))
-#define USART0      ((UsartTypeDef*)        (0xC0))
+/*
+ * The host backend has no IO space. Peripherals are instead mapped onto an
+ * emulated register file that bsp/private/host/host_machine.c steps in time.
+ */
+#if defined(BSP_HOST)
+    #define HOST_IO_SPACE_SIZE  (0x100u)
+    extern volatile u8_t host_io_space[HOST_IO_SPACE_SIZE];
+    #define IO_ADDR__(addr)     (host_io_space + (addr))
+#else
+    #define IO_ADDR__(addr)     (addr)
+#endif
+
+#define GPIO_B      ((GpioPortTypeDef*)     IO_ADDR__(0x23))
+#define GPIO_C      ((GpioPortTypeDef*)     IO_ADDR__(0x26))
+#define GPIO_D      ((GpioPortTypeDef*)     IO_ADDR__(0x29))
+#define TIM0_IRQ    ((TimerIrqRegTypeDef*)  IO_ADDR__(0x35))
+#define TIM1_IRQ    ((TimerIrqRegTypeDef*)  IO_ADDR__(0x36))
+#define TIM2_IRQ    ((TimerIrqRegTypeDef*)  IO_ADDR__(0x37))
+#define EXT_IRQ     ((ExtIrqTypeDef*)       IO_ADDR__(0x3C))
+#define TIM0        ((Timer8BitTypeDef*)    IO_ADDR__(0x44))
+#define TIM1        ((Timer16BitTypeDef*)   IO_ADDR__(0x80))
+#define TIM2        ((Timer8BitTypeDef*)    IO_ADDR__(0xB0))
+#define USART0      ((UsartTypeDef*)        IO_ADDR__(0xC0))
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,69 @@
+#include "bsp/private/stack/stack.h"
+
+#include <avr/io.h>
+
+#include "types.h"
+
+/*
+ * First RAM address after the static data. The avr-libc linker scripts place it
+ * after .noinit and avr.ld provides it for the custom startup.
+ */
+extern u8_t __heap_start;
+
+static void stack_paint(void) __attribute__((naked, used, section(".init3")));
+
+/* Lowest stack address found written so far (one past RAMEND when unused). */
+static u8_t *p_low_water = (u8_t*)(RAMEND + 1u);
+
+/**
+ * @brief Peak stack usage since reset.
+ *
+ * The stack grows down from RAMEND into the painted region, so the mark moves
+ * down over the bytes that no longer hold the paint value. The scan starts
+ * below the previous mark and stops at the first painted byte, so a call only
+ * reads the bytes the stack has grown into since the last one.
+ *
+ * The result is a lower bound. Stack bytes that were reserved but never
+ * written (e.g. an unused tail of a local array), or written with the paint
+ * value, are not seen, and neither is anything deeper than such a gap.
+ *
+ * @return bytes of stack used at the deepest point so far
+ */
+u16_t stack_high_water(void)
+{
+    while ((&__heap_start < p_low_water) && (STACK_PAINT != *(p_low_water - 1))) {
+        p_low_water -= 1;
+    }
+
+    return (u16_t)((RAMEND + 1u) - (u16_t)p_low_water);
+}
+
+/**
+ * @brief Paint the free RAM with STACK_PAINT.
+ *
+ * Runs from the avr-libc .init3 section, after .init2 set up the stack pointer
+ * and before main. The region from __heap_start up to the current stack pointer
+ * is filled (.bss and .data are initialized afterwards and sit below it).
+ *
+ * This is written in assembly since a naked function has no frame for the
+ * compiler to spill to.
+ */
+static void stack_paint(void)
+{
+    __asm__ __volatile__ (
+        "    ldi  r30, lo8(__heap_start)    \n"
+        "    ldi  r31, hi8(__heap_start)    \n"
+        "    in   r26, __SP_L__             \n"
+        "    in   r27, __SP_H__             \n"
+        "    ldi  r24, %[paint]             \n"
+        "1:  cp   r30, r26                  \n"
+        "    cpc  r31, r27                  \n"
+        "    brsh 2f                        \n"
+        "    st   Z+, r24                   \n"
+        "    rjmp 1b                        \n"
+        "2:                                 \n"
+        :
+        : [paint] "M" (STACK_PAINT)
+        : "r24", "r26", "r27", "r30", "r31", "memory"
+    );
+}
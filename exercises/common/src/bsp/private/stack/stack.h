@@ -0,0 +1,19 @@
+#ifndef STACK_H
+#define STACK_H
+
+#include "types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Value painted over the unused RAM between the static data and the stack */
+#define STACK_PAINT     (0xC5u)
+
+u16_t stack_high_water(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* STACK_H */
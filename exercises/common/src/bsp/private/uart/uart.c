@@ -1,52 +1,208 @@
 #include "bsp/private/uart/uart.h"
 
 #include <avr/interrupt.h>
+#include <avr/pgmspace.h>
+#include <util/atomic.h>
+#include "bsp/bsp.h"
 #include "bsp/private/processor/reg_io.h"
+#include "bsp/trace.h"
+#include "utils/cobs.h"
+#include "utils/crc16.h"
 #include "types.h"
 
-/* Baud rate configuration */
-#define BAUD    (19200u)                    /* 19.2K */
-#define UBRR    ((F_CPU/(8.0f * BAUD)) - 1) /* assuming U2X0 is set */
+/* Baud rate configuration. BSP_SERIAL_BAUD comes from the build (see the
+   top level CMakeLists.txt). */
+#ifndef BSP_SERIAL_BAUD
+#define BSP_SERIAL_BAUD     UART_DEFAULT_BAUD
+#endif
 
-/* Ring buffer infrastructure */
+#define UBRR_MAX            (4095u)     /* 12-bit baud rate register */
+#define BAUD_DIV_NORMAL     (16u)       /* clocks per bit            */
+#define BAUD_DIV_DOUBLE     (8u)        /* clocks per bit with U2X   */
+
+#define BAUD_ERROR_ABS(err) (((err) < 0) ? -(err) : (err))
+
+/* Automatic baud rate detection (see uart_autobaud). The sync character 0x55
+   ('U') has falling edges at the start bit and at data bits 1, 3, 5 and 7,
+   two bit times apart. Timer1 captures them on ICP1 (PB0), which is wired to
+   RXD (PD0). */
+#define AUTOBAUD_EDGES      (5u)        /* falling edges timed                   */
+#define AUTOBAUD_BITS       (8u)        /* bit times from the first to the last  */
+#define AUTOBAUD_SKEW_SHIFT (3u)        /* an interval may be 1/8 off the mean   */
+#define ICP_PIN_MASK        (1u << 0u)  /* PB0, the Timer1 input capture pin     */
+
+/* Flow control configuration from the build (see the top level
+   CMakeLists.txt) */
+#ifndef BSP_SERIAL_FLOW
+#define BSP_SERIAL_FLOW     E_SERIAL_FLOW_NONE
+#endif
+
+/* Flow control characters and pins */
+#define FLOW_XON            (0x11u)     /* DC1 (Ctrl-Q)                         */
+#define FLOW_XOFF           (0x13u)     /* DC3 (Ctrl-S)                         */
+#define RTS_PIN_MASK        (1u << 4u)  /* PD4 out, low: ready to receive       */
+#define CTS_PIN_MASK        (1u << 3u)  /* PD3 (INT1) in, low: clear to send    */
+
+/* Ring buffer infrastructure. The RX ring is filled by the RX ISR and emptied
+   by the application; the TX ring the other way around. */
 #define BYTE_RING_MAX_SIZE  (256u)
-#define PRIVATE_RING_SIZE   BYTE_RING_MAX_SIZE  /* set ring size */
-#define PRIVATE_RING_VOLATILE_DECL              /* byte rings in this module are volatile */
-#include "utils/private_ring.h"
+#include "utils/spsc_ring.h"
+
+SPSC_RING_DECLARATIONS(ByteRing, u8_t, BYTE_RING_MAX_SIZE) /* create ring type of bytes */
+SPSC_RING_DECLARE(static ByteRing, rx_ring);               /* bytes to read             */
+SPSC_RING_DECLARE(static ByteRing, tx_ring);               /* bytes to write            */
+
+/* Echo of the line mode. The RX ISR produces it and the UDRE ISR consumes it,
+   so the TX ring keeps the application as its only producer. */
+#define ECHO_RING_SIZE      (16u)
+
+SPSC_RING_DECLARATIONS(EchoRing, u8_t, ECHO_RING_SIZE)
+SPSC_RING_DECLARE(static EchoRing, echo_ring);
+
+/* Address frames of the multi-drop bus (see uart_send_to). Each one marks the
+   TX ring position it goes out at, so the UDRE ISR sends it with the 9th bit
+   set once the bytes queued before it are gone. */
+#define TX_ADDRESS_RING_SIZE (4u)
+
+typedef struct tx_address
+{
+    u8_t at;        /* TX ring write position when the address was queued */
+    u8_t address;   /* node the bytes after it are for          */
+} TxAddress_t;
+
+SPSC_RING_DECLARATIONS(AddressRing, TxAddress_t, TX_ADDRESS_RING_SIZE)
+SPSC_RING_DECLARE(static AddressRing, tx_addresses);
+
+/* Readability macros for the ring functions */
+#define BYTE_RING_INIT(var_name)               SPSC_RING_INIT(ByteRing, var_name)
+#define BYTE_RING_COUNT(var_name)              SPSC_RING_COUNT(ByteRing, var_name)
+#define BYTE_RING_IS_EMPTY(var_name)           SPSC_RING_IS_EMPTY(ByteRing, var_name)
+#define BYTE_RING_WRITE_POS(var_name)          SPSC_RING_WRITE_POS(ByteRing, var_name)
+#define BYTE_RING_READ_POS(var_name)           SPSC_RING_READ_POS(ByteRing, var_name)
+#define BYTE_RING_PUSH(var_name, data)         SPSC_RING_PUSH(ByteRing, var_name, data)
+#define BYTE_RING_POP(var_name, p_data)        SPSC_RING_POP(ByteRing, var_name, p_data)
+#define BYTE_RING_WRITE(var_name, p_src, len)  SPSC_RING_WRITE(ByteRing, var_name, p_src, len)
+#define BYTE_RING_READ(var_name, p_dst, len)   SPSC_RING_READ(ByteRing, var_name, p_dst, len)
+
+/* Receive error flags of UCSRA. They belong to the byte in UDR, so they are
+   read first. */
+#define RX_ERROR_MASK       (UART_UCSRA_DOR_MASK | UART_UCSRA_FE_MASK | UART_UCSRA_UPE_MASK)
+
+/* Count an event; the counters stop at their maximum. */
+#define STATS_COUNT(counter, n)                                 \
+    do {                                                        \
+        stats.counter = ((0xFFFFu - stats.counter) < (n)) ?     \
+                        0xFFFFu : (u16_t)(stats.counter + (n)); \
+    } while (0)
+
+/* Raise a peak fill mark */
+#define STATS_PEAK(peak, fill)                                  \
+    do {                                                        \
+        if ((fill) > stats.peak) {                              \
+            stats.peak = (fill);                                \
+        }                                                       \
+    } while (0)
 
-PRIVATE_RING_DECLARATIONS(ByteRing, u8_t)                /* create ring type of bytes */
-PRIVATE_RING_DECLARE(static volatile ByteRing, rx_ring); /* bytes to read             */
-PRIVATE_RING_DECLARE(static volatile ByteRing, tx_ring); /* bytes to write            */
+/* Line mode characters */
+#define LINE_END            ('\n')
+#define LINE_IGNORED        ('\r')
+#define LINE_BACKSPACE      ('\b')
+#define LINE_DELETE         ('\x7F')
+#define LINE_CONTROL_END    (' ')   /* bytes below this are control bytes */
 
-/* Readability macros for private ring functions */
-#define BYTE_RING_INIT(var_name)       PRIVATE_RING_INIT(ByteRing, var_name)
-#define BYTE_RING_IS_EMPTY(var_name)   PRIVATE_RING_IS_EMPTY(ByteRing, var_name)
-#define BYTE_RING_IS_FULL(var_name)    PRIVATE_RING_IS_FULL(ByteRing, var_name)
-#define BYTE_RING_PUSH(var_name, data) PRIVATE_RING_PUSH(ByteRing, var_name, data)
-#define BYTE_RING_POP(var_name)        PRIVATE_RING_POP(ByteRing, var_name)
-#define BYTE_RING_PEEK(var_name)       PRIVATE_RING_PEEK(ByteRing, var_name)
+/* Line mode buffers. The RX ISR fills line_buf[line_fill] and hands it over
+   with its ready flag; the application reads line_buf[line_read] until it
+   releases it. */
+static u8_t            line_buf[UART_LINES][UART_LINE_SIZE];
+static volatile u8_t   line_len[UART_LINES];
+static volatile bool_t line_ready[UART_LINES];
+static u8_t            line_fill;       /* RX ISR only     */
+static u8_t            line_fill_len;   /* RX ISR only     */
+static bool_t          line_discard;    /* RX ISR only     */
+static u8_t            line_read;       /* application only */
+static volatile bool_t line_mode;
+static volatile bool_t line_echo;
+
+/* Frame mode decodes COBS frames into the line buffers (RX ISR only). */
+static volatile bool_t frame_mode;
+static CobsDecoder_t   frame_decoder;
+
+/* Health counters. The RX fields are written by the RX ISR and the TX fields
+   by the application, so only reading and clearing need interrupts off. */
+static BspSerialStats_t stats;
+
+/* Flow control. rx_paused and flow_byte change in the RX ISR and, with
+   interrupts off, in the application. */
+static volatile BspSerialFlow_t flow_mode;
+static u8_t                     flow_high;      /* RX ring fill that pauses the sender */
+static u8_t                     flow_low;       /* RX ring fill that resumes it        */
+static volatile bool_t          rx_paused;      /* the sender was told to stop         */
+static volatile u8_t            flow_byte;      /* XON/XOFF to send next (0: none)     */
+static volatile bool_t          tx_xoff;        /* the peer sent XOFF                  */
+
+/* Set while a byte the UDRE ISR loaded may still be on the line, so TXC tells
+   when the line is idle. The TXC ISR clears it. */
+static volatile bool_t tx_started;
+
+/* Transmit notifications (see uart_set_tx_notify). The UDRE ISR runs the space
+   callback once the TX ring fill falls to tx_notify_fill after a write left it
+   above; the TXC ISR runs the drained callback. */
+static volatile IsrCallback_t tx_space_cb;
+static volatile IsrCallback_t tx_drained_cb;
+static u8_t                   tx_notify_fill;
+static volatile bool_t        tx_space_armed;
+
+/* Multi-drop bus (see uart_set_multidrop). The RX ISR compares address frames
+   with node_address and lets the hardware drop the data frames of other
+   nodes. */
+static volatile bool_t multidrop;
+static volatile u8_t   node_address;
+
+static void line_receive(u8_t data);
+static void frame_receive(u8_t data);
+static void frame_put(void *p_ctx, const u8_t *p_data, size_t len);
+static void rx_errors(u8_t status);
+static void rx_drop(u8_t data);
+static void rx_pause(void);
+static void rx_resume(void);
+static void rx_check_resume(void);
+static void send_flow_byte(u8_t data);
+static bool_t tx_held(void);
+static void echo_byte(u8_t data);
+static void multidrop_address(u8_t address);
+static bool_t tx_address_due(u8_t *p_address);
+static u16_t baud_ubrr(u32_t baud, u8_t div, s32_t *p_error);
+static bool_t autobaud_capture(u16_t *p_bit_cycles);
+static bool_t autobaud_in_time(u16_t start, u16_t *p_waited);
+static void autobaud_clear_flags(u8_t mask);
+static bool_t tx_drain(void);
+static void tx_arm_space(void);
+static bool_t tx_is_empty(void);
 
 /**
  * @brief Initialize the UART hardware driver.
  */
 void uart_init(void)
 {
-    u16_t ubrr_val; /* properly typed UBRR register value */
-    u16_t ubrr_hi;  /* UBRR register high bits */
-    u16_t ubrr_lo;  /* UBRR register low bits  */
-
-    /* The baurd rate settings are split across 2 registers: high and low. */
-    ubrr_val = (u16_t)UBRR;
-    ubrr_hi  = (ubrr_val >> 8) & 0x0F;
-    ubrr_lo  = (ubrr_val >> 0) & 0xFF;
-
-    USART0->UBRRH = (u8_t)ubrr_hi;
-    USART0->UBRRL = (u8_t)ubrr_lo;
+    tx_started = E_FALSE;
+    flow_mode  = E_SERIAL_FLOW_NONE;
+    rx_paused  = E_FALSE;
+    flow_byte  = 0u;
+    tx_xoff    = E_FALSE;
+    multidrop  = E_FALSE;
+    uart_get_stats(NULL_PTR, E_TRUE);
+    uart_set_tx_notify(SPSC_RING_CAPACITY(BYTE_RING_MAX_SIZE), NULL_PTR, NULL_PTR);
 
     /* hard disable the UART */
     USART0->UCSRB = 0;
     USART0->UCSRA = 0;
 
+    /* Initialize byte rings (empty before uart_set_baud drains them) */
+    BYTE_RING_INIT(rx_ring);
+    BYTE_RING_INIT(tx_ring);
+    SPSC_RING_INIT(EchoRing, echo_ring);
+    SPSC_RING_INIT(AddressRing, tx_addresses);
+
     /*  Configure the control registers
 
         CSR A
@@ -56,7 +212,7 @@ void uart_init(void)
         4. read-only (0)
         3. read-only (0)
         2. read-only (0)
-        1. transmission speed doubler enabled (1)
+        1. transmission speed doubler (chosen by uart_set_baud)
         0. multi-processor communication disabled (0)
 
         CSRB
@@ -79,13 +235,180 @@ void uart_init(void)
         NOTE: CSRB is configured last to allow the TX/RX enable to occurr after
               all other configuration.
     */
-    USART0->UCSRA = UART_UCSRA_U2X_MASK;
     USART0->UCSRC = UART_UCSRC_UCSZ1_MASK | UART_UCSRC_UCSZ0_MASK;
+    if (E_FALSE == uart_set_baud(BSP_SERIAL_BAUD, NULL_PTR)) {
+        (void)uart_set_baud(UART_DEFAULT_BAUD, NULL_PTR);
+    }
     USART0->UCSRB = UART_UCSRB_RXCIE_MASK | UART_UCSRB_RXEN_MASK | UART_UCSRB_TXEN_MASK;
 
-    /* Initialize byte rings */
-    BYTE_RING_INIT(rx_ring);
-    BYTE_RING_INIT(tx_ring);
+    uart_set_line_mode(E_FALSE, E_FALSE);
+    (void)uart_set_flow_control(BSP_SERIAL_FLOW, UART_FLOW_HIGH, UART_FLOW_LOW);
+}
+
+/**
+ * @brief Set the baud rate.
+ *
+ * The UBRR value is computed in integer math for the normal and the double
+ * speed (U2X) mode and the one closer to the requested rate is used; normal
+ * mode on a tie, since its receiver samples each bit more often. At 16 MHz
+ * 250k, 500k, and 1M are exact in normal mode and 2M in double speed mode.
+ *
+ * The transmitter finishes the bytes already written at the old rate first,
+ * so interrupts must be enabled when there is output pending. While the peer
+ * holds the transmitter with flow control, the rate is not changed.
+ *
+ * @param[in]  baud    requested rate in bits per second
+ * @param[out] p_error error of the closest achievable rate in 0.01 % (basis
+ *                     points, positive when faster) or NULL_PTR. Not written
+ *                     for 0 or a rate above F_CPU / 8.
+ *
+ * @retval E_TRUE  - the rate is set
+ * @retval E_FALSE - the error would exceed UART_BAUD_MAX_ERROR, the rate is
+ *                   out of range, or the peer holds output at the old rate;
+ *                   the rate is unchanged
+ */
+bool_t uart_set_baud(u32_t baud, s32_t *p_error)
+{
+    u16_t  ubrr;
+    u16_t  ubrr_double;
+    s32_t  error;
+    s32_t  error_double;
+    bool_t use_double;
+    bool_t result;
+
+    result = E_FALSE;
+
+    /* Below 8 clocks per bit there is nothing to choose from. */
+    if ((0u != baud) && (baud <= ((u32_t)F_CPU / BAUD_DIV_DOUBLE))) {
+        ubrr        = baud_ubrr(baud, BAUD_DIV_NORMAL, &error);
+        ubrr_double = baud_ubrr(baud, BAUD_DIV_DOUBLE, &error_double);
+
+        use_double = E_FALSE;
+        if (BAUD_ERROR_ABS(error_double) < BAUD_ERROR_ABS(error)) {
+            use_double = E_TRUE;
+            ubrr       = ubrr_double;
+            error      = error_double;
+        }
+
+        if ((-UART_BAUD_MAX_ERROR <= error) && (error <= UART_BAUD_MAX_ERROR) &&
+            (E_TRUE == tx_drain())) {
+            /* UBRRL last, writing it updates the baud rate prescaler. Keep the
+               multi-processor mode bit, which the RX ISR also writes; the flag
+               bits are not written. */
+            ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+                USART0->UCSRA = (u8_t)((USART0->UCSRA & UART_UCSRA_MPCM_MASK) |
+                                       ((E_TRUE == use_double) ? UART_UCSRA_U2X_MASK : 0u));
+            }
+            USART0->UBRRH = (u8_t)((ubrr >> 8u) & 0x0Fu);
+            USART0->UBRRL = (u8_t)(ubrr & 0xFFu);
+
+            result = E_TRUE;
+        }
+
+        if (NULL_PTR != p_error) {
+            *p_error = error;
+        }
+    }
+
+    return result;
+}
+
+/**
+ * @brief Detect the baud rate of the peer from a sync character.
+ *
+ * The receiver is switched off and Timer1, unprescaled, captures the falling
+ * edges of the RX line on ICP1 (PB0, so PB0 must be wired to RXD). A 0x55
+ * ('U') has five falling edges two bit times apart; the bit time is the span
+ * of the edges divided by 8 and the rate is set with uart_set_baud. Bytes
+ * whose edges are not evenly spaced are ignored, so the operator can keep
+ * typing 'U' until the link is up. Rates from 2400 bit/s (the five edges
+ * must fit the 16-bit counter) to about 500 kbit/s (the edges after the first
+ * are polled) are found.
+ *
+ * Timer1 is the BSP timer; its registers are put back afterwards, but it does
+ * not tick while the rate is detected. Interrupts are disabled while a
+ * character is timed. The host backend has no line to time and times out.
+ *
+ * @param[in]  timeout_msec how long to listen
+ * @param[out] p_baud       detected rate in bits per second or NULL_PTR (only
+ *                          written on success)
+ *
+ * @retval E_TRUE  - the rate was detected and set
+ * @retval E_FALSE - no sync character in time; the rate is unchanged
+ */
+bool_t uart_autobaud(u16_t timeout_msec, u32_t *p_baud)
+{
+    u8_t   tccra;
+    u8_t   tccrb;
+    u8_t   timsk;
+    u16_t  tcnt;
+    u16_t  ocra;
+    u16_t  now;
+    u16_t  prev;
+    u16_t  bit_cycles;
+    u32_t  overflows;
+    u32_t  baud;
+    bool_t result;
+
+    result     = E_FALSE;
+    bit_cycles = 0u;
+
+    /* The counter wraps every 65536 cycles. */
+    overflows = ((u32_t)timeout_msec * ((u32_t)F_CPU / 1000u)) >> 16u;
+
+    /* Borrow Timer1 (the BSP timer) as a free running capture timer. */
+    tccra = TIM1->TCCRA;
+    tccrb = TIM1->TCCRB;
+    timsk = TIM1_IRQ->TIMSK;
+    tcnt  = TIM1->TCNT;
+    ocra  = TIM1->OCRA;
+
+    TIM1->TCCRB     = 0u;
+    TIM1_IRQ->TIMSK = 0u;
+    TIM1->TCCRA     = 0u;
+    TIM1->TCNT      = 0u;
+    autobaud_clear_flags(TIM1_TIFR_ICF_MASK);
+    TIM1->TCCRB     = TIM1_TCCRB_ICNC_MASK | TIM1_TCCRB_CS10_MASK;
+
+    /* The sync character is not data. */
+    USART0->UCSRB &= (u8_t)~(UART_UCSRB_RXCIE_MASK | UART_UCSRB_RXEN_MASK);
+
+    prev = 0u;
+
+    while ((E_FALSE == result) && (0u != overflows)) {
+        if (0u != (TIM1_IRQ->TIFR & TIM1_TIFR_ICF_MASK)) {
+            if (E_TRUE == autobaud_capture(&bit_cycles)) {
+                /* bits per second = F_CPU / (span / 8), rounded */
+                baud   = (((u32_t)F_CPU * AUTOBAUD_BITS) + (bit_cycles / 2u)) / bit_cycles;
+                result = uart_set_baud(baud, NULL_PTR);
+
+                if ((E_TRUE == result) && (NULL_PTR != p_baud)) {
+                    *p_baud = baud;
+                }
+            }
+
+            prev = TIM1->TCNT;
+        } else {
+            now = TIM1->TCNT;
+            if (now < prev) {
+                overflows -= 1u;
+            }
+            prev = now;
+        }
+    }
+
+    USART0->UCSRB |= UART_UCSRB_RXCIE_MASK | UART_UCSRB_RXEN_MASK;
+
+    /* Give Timer1 back without the compare match it may have passed. */
+    TIM1->TCCRB     = 0u;
+    TIM1->TCCRA     = tccra;
+    TIM1->OCRA      = ocra;
+    TIM1->TCNT      = tcnt;
+    autobaud_clear_flags(TIM_TIFR_TOV_MASK | TIM_TIFR_OCFA_MASK | TIM1_TIFR_ICF_MASK);
+    TIM1_IRQ->TIMSK = timsk;
+    TIM1->TCCRB     = tccrb;
+
+    return result;
 }
 
 /**
@@ -117,12 +440,12 @@ u8_t uart_read(void)
 {
     u8_t byte;
 
-    if (E_TRUE == uart_data_available()) {
-        byte = BYTE_RING_POP(rx_ring);
-    } else {
+    if (E_FALSE == BYTE_RING_POP(rx_ring, &byte)) {
         byte = '\0';
     }
 
+    rx_check_resume();
+
     return byte;
 }
 
@@ -139,11 +462,12 @@ bool_t uart_write(u8_t byte)
     bool_t result;
 
     /* If the ring is not full, add the byte to the buffer. */
-    if (E_FALSE == BYTE_RING_IS_FULL(tx_ring)) {
-        BYTE_RING_PUSH(tx_ring, byte);
-        result = E_TRUE;
+    result = BYTE_RING_PUSH(tx_ring, byte);
+    if (E_FALSE == result) {
+        TRACE(E_TRACE_UART_TX_DROP, byte);
+        STATS_COUNT(tx_drops, 1u);
     } else {
-        result = E_FALSE;
+        STATS_PEAK(tx_peak, BYTE_RING_COUNT(tx_ring));
     }
 
     /* Regardless of the buffer state, we need to enable the transmitter to
@@ -154,27 +478,1198 @@ bool_t uart_write(u8_t byte)
     return result;
 }
 
-ISR(USART_RX_vect)
+/**
+ * @brief Read up to len bytes from the driver's buffer
+ *
+ * @param[out] p_buf destination of the received bytes
+ * @param[in]  len   size of the destination
+ *
+ * @return The number of bytes read (0 when nothing was received).
+ */
+size_t uart_read_buf(u8_t *p_buf, size_t len)
 {
-    u8_t data;
+    size_t count;
+
+    count = BYTE_RING_READ(rx_ring, p_buf, len);
+    rx_check_resume();
+
+    return count;
+}
+
+/**
+ * @brief Copy up to len bytes into the driver's buffer without starting the
+ * transmitter (see uart_start_tx).
+ *
+ * Queuing several pieces and starting the transmitter once keeps the data
+ * register empty interrupt from firing between the pieces.
+ *
+ * @param[in] p_buf bytes to transmit over the UART
+ * @param[in] len   number of bytes
+ *
+ * @return The number of bytes queued. Less than len when the buffer is full.
+ */
+size_t uart_queue_buf(const u8_t *p_buf, size_t len)
+{
+    size_t queued;
+    u16_t  refused;
 
-    /* Read the data regardless of the ring state to clear the interrupt */
-    data = USART0->UDR;
+    queued = BYTE_RING_WRITE(tx_ring, p_buf, len);
 
-    /* Only push to the ring if it is not full. */
-    if (E_FALSE == BYTE_RING_IS_FULL(rx_ring)) {
-        BYTE_RING_PUSH(rx_ring, data);
+    if (queued < len) {
+        refused = ((len - queued) < 0xFFFFu) ? (u16_t)(len - queued) : 0xFFFFu;
+        STATS_COUNT(tx_drops, refused);
     }
+    STATS_PEAK(tx_peak, BYTE_RING_COUNT(tx_ring));
+
+    return queued;
 }
 
-ISR(USART_UDRE_vect)
+/**
+ * @brief Copy up to len bytes from program memory into the driver's buffer
+ * without starting the transmitter (see uart_queue_buf).
+ *
+ * Each byte is read with pgm_read_byte straight into the TX ring, so nothing is
+ * staged in RAM.
+ *
+ * @param[in] p_flash bytes to transmit (program memory address)
+ * @param[in] len     number of bytes
+ *
+ * @return The number of bytes queued. Less than len when the buffer is full.
+ */
+size_t uart_queue_P(const u8_t *p_flash, size_t len)
 {
-    u8_t data;
+    size_t queued;
+    u16_t  refused;
 
-    if (E_TRUE == BYTE_RING_IS_EMPTY(tx_ring)) {
-        USART0->UCSRB &= ~UART_UCSRB_UDRIE_MASK;
+    queued = 0u;
+
+    while ((queued < len) && (E_TRUE == BYTE_RING_PUSH(tx_ring, pgm_read_byte(&p_flash[queued])))) {
+        queued += 1u;
+    }
+
+    if (queued < len) {
+        refused = ((len - queued) < 0xFFFFu) ? (u16_t)(len - queued) : 0xFFFFu;
+        STATS_COUNT(tx_drops, refused);
+    }
+    STATS_PEAK(tx_peak, BYTE_RING_COUNT(tx_ring));
+
+    return queued;
+}
+
+/**
+ * @brief Start transmitting the queued bytes.
+ */
+void uart_start_tx(void)
+{
+    USART0->UCSRB |= UART_UCSRB_UDRIE_MASK;
+}
+
+/**
+ * @brief Write up to len bytes to the driver's buffer
+ *
+ * @param[in] p_buf bytes to transmit over the UART
+ * @param[in] len   number of bytes
+ *
+ * @return The number of bytes written. Less than len when the buffer is full.
+ */
+size_t uart_write_buf(const u8_t *p_buf, size_t len)
+{
+    size_t written;
+
+    written = uart_queue_buf(p_buf, len);
+    if (written < len) {
+        TRACE(E_TRACE_UART_TX_DROP, p_buf[written]);
+    }
+
+    /* Like uart_write, start the transmitter even when nothing fit. */
+    uart_start_tx();
+
+    return written;
+}
+
+/**
+ * @brief Write as many of len bytes as the driver's buffer has room for.
+ *
+ * Unlike uart_write_buf, a short write is backpressure and not a drop: the
+ * caller keeps the rest and offers it again later, e.g. from its task once the
+ * space callback of uart_set_tx_notify ran. A write that leaves less room than
+ * the notification asks for arms the callback.
+ *
+ * @param[in] p_buf bytes to transmit over the UART
+ * @param[in] len   number of bytes
+ *
+ * @return The number of bytes accepted (0 when the buffer is full).
+ */
+size_t uart_write_async(const u8_t *p_buf, size_t len)
+{
+    size_t accepted;
+
+    accepted = BYTE_RING_WRITE(tx_ring, p_buf, len);
+    STATS_PEAK(tx_peak, BYTE_RING_COUNT(tx_ring));
+
+    uart_start_tx();
+    tx_arm_space();
+
+    return accepted;
+}
+
+/**
+ * @brief Get the room left in the driver's buffer.
+ *
+ * @return The number of bytes a write would accept now.
+ */
+size_t uart_tx_space(void)
+{
+    return (size_t)SPSC_RING_CAPACITY(BYTE_RING_MAX_SIZE) - BYTE_RING_COUNT(tx_ring);
+}
+
+/**
+ * @brief Check if everything written so far left the transmitter.
+ *
+ * @retval E_TRUE  - the buffers are empty and the last stop bit is out
+ * @retval E_FALSE - bytes are queued or still shifting out
+ */
+bool_t uart_tx_idle(void)
+{
+    bool_t idle;
+
+    idle = E_FALSE;
+
+    if ((E_TRUE == tx_is_empty()) && (0u == (USART0->UCSRB & UART_UCSRB_UDRIE_MASK)) &&
+        ((E_FALSE == tx_started) || (0u != (USART0->UCSRA & UART_UCSRA_TXC_MASK)))) {
+        idle = E_TRUE;
+    }
+
+    return idle;
+}
+
+/**
+ * @brief Set the transmit notifications.
+ *
+ * on_space runs in the UDRE ISR once at least space bytes are free again
+ * after a uart_write_async left less. on_drained runs in the TXC ISR when the
+ * transmitter ran out of bytes and the last one is on the line. Both run in
+ * interrupt context, so they should only set a flag or wake a task.
+ *
+ * @param[in] space      free bytes that trigger on_space (1 to 255)
+ * @param[in] on_space   callback or NULL_PTR
+ * @param[in] on_drained callback or NULL_PTR
+ */
+void uart_set_tx_notify(u8_t space, IsrCallback_t on_space, IsrCallback_t on_drained)
+{
+    if (0u == space) {
+        space = 1u;
+    }
+
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+        tx_space_cb    = on_space;
+        tx_drained_cb  = on_drained;
+        tx_notify_fill = (u8_t)(SPSC_RING_CAPACITY(BYTE_RING_MAX_SIZE) - space);
+        tx_space_armed = E_FALSE;
+    }
+}
+
+/**
+ * @brief Copy the health counters of the driver.
+ *
+ * @param[out] p_stats copy of the counters (NULL_PTR to only clear them)
+ * @param[in]  clear   E_TRUE to start the counters and peaks over
+ */
+void uart_get_stats(BspSerialStats_t *p_stats, bool_t clear)
+{
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+        if (NULL_PTR != p_stats) {
+            *p_stats = stats;
+        }
+
+        if (E_TRUE == clear) {
+            stats.rx_overruns       = 0u;
+            stats.rx_framing_errors = 0u;
+            stats.rx_parity_errors  = 0u;
+            stats.rx_drops          = 0u;
+            stats.rx_pauses         = 0u;
+            stats.rx_frame_errors   = 0u;
+            stats.rx_crc_errors     = 0u;
+            stats.tx_drops          = 0u;
+            stats.rx_peak           = 0u;
+            stats.tx_peak           = 0u;
+        }
+    }
+}
+
+/**
+ * @brief Switch the receiver between byte mode and line mode.
+ *
+ * In byte mode (the default) every received byte goes through the RX ring. In
+ * line mode the RX ISR assembles lines directly into one of two line buffers
+ * and hands a finished line to the application (uart_get_line) while it fills
+ * the other one. The line end is replaced by a NULL, so a line is a C string.
+ * Carriage returns are ignored, backspace and delete remove the last byte, and
+ * the bytes of a line past UART_LINE_SIZE - 1 are dropped. A line that starts
+ * while both buffers are with the application is dropped entirely. Other
+ * control bytes (e.g. an ENQ request) still go through the RX ring.
+ *
+ * With echo, the RX ISR echoes the bytes it adds to the line (a line end as
+ * "\n\r") ahead of anything the application queued for transmission.
+ *
+ * @note Call with interrupts disabled or before the receiver is busy; a partial
+ * line is discarded.
+ *
+ * @param[in] enable E_TRUE for line mode, E_FALSE for byte mode
+ * @param[in] echo   E_TRUE to echo the line from the RX ISR
+ */
+void uart_set_line_mode(bool_t enable, bool_t echo)
+{
+    u8_t l;
+
+    frame_mode = E_FALSE;
+    line_mode  = E_FALSE;
+
+    for (l = 0u; l < UART_LINES; l += 1u) {
+        line_len[l]   = 0u;
+        line_ready[l] = E_FALSE;
+    }
+
+    line_fill     = 0u;
+    line_fill_len = 0u;
+    line_discard  = E_FALSE;
+    line_read     = 0u;
+    line_echo     = echo;
+    line_mode     = enable;
+}
+
+/**
+ * @brief Get the oldest line the receiver finished (line mode).
+ *
+ * The line stays with the application, which may modify it in place, until
+ * uart_release_line. No bytes are copied.
+ *
+ * @param[out] pp_line the NULL terminated line (without its line end)
+ * @param[out] p_len   length of the line
+ *
+ * @retval E_TRUE  - a line is available
+ * @retval E_FALSE - no finished line
+ */
+bool_t uart_get_line(char **pp_line, size_t *p_len)
+{
+    bool_t available;
+
+    available = line_ready[line_read];
+
+    if (E_TRUE == available) {
+        *pp_line = (char*)line_buf[line_read];
+        *p_len   = line_len[line_read];
+    }
+
+    return available;
+}
+
+/**
+ * @brief Hand the line from uart_get_line back to the receiver.
+ */
+void uart_release_line(void)
+{
+    if (E_TRUE == line_ready[line_read]) {
+        line_ready[line_read] = E_FALSE;
+        line_read ^= 1u;
+    }
+
+    rx_check_resume();
+}
+
+/**
+ * @brief Switch the receiver between byte mode and COBS frame mode.
+ *
+ * In frame mode the RX ISR decodes COBS frames (see utils/cobs.h) into the
+ * line buffers as the bytes arrive. A frame is handed over at its delimiter
+ * and uart_get_frame checks its CRC. A frame longer than UART_LINE_SIZE, or
+ * one that starts while both buffers are with the application, is dropped.
+ *
+ * XON and XOFF may be frame data, so software flow control does not intercept
+ * them in frame mode; use RTS/CTS.
+ *
+ * @note Call with interrupts disabled or before the receiver is busy; a partial
+ * frame is discarded.
+ *
+ * @param[in] enable E_TRUE for frame mode, E_FALSE for byte mode
+ */
+void uart_set_frame_mode(bool_t enable)
+{
+    uart_set_line_mode(E_FALSE, E_FALSE);
+    cobs_decoder_init(&frame_decoder, line_buf[line_fill], UART_LINE_SIZE);
+    frame_mode = enable;
+}
+
+/**
+ * @brief Get the oldest good frame the receiver decoded (frame mode).
+ *
+ * Frames that fail their CRC are counted and handed back to the receiver. The
+ * frame stays with the application until uart_release_line. No bytes are
+ * copied.
+ *
+ * @param[out] pp_frame payload of the frame (without its CRC)
+ * @param[out] p_len    payload length
+ *
+ * @retval E_TRUE  - a frame is available
+ * @retval E_FALSE - no good frame
+ */
+bool_t uart_get_frame(u8_t **pp_frame, size_t *p_len)
+{
+    bool_t available;
+    u8_t   len;
+
+    available = E_FALSE;
+
+    while ((E_FALSE == available) && (E_TRUE == line_ready[line_read])) {
+        len = line_len[line_read];
+
+        /* The CRC over the payload and its CRC is 0 for a good frame. */
+        if ((UART_FRAME_CRC_SIZE <= len) &&
+            (0u == crc16(CRC16_INIT, line_buf[line_read], len))) {
+            *pp_frame = line_buf[line_read];
+            *p_len    = (size_t)len - UART_FRAME_CRC_SIZE;
+            available = E_TRUE;
+        } else {
+            STATS_COUNT(rx_crc_errors, 1u);
+            uart_release_line();
+        }
+    }
+
+    return available;
+}
+
+/**
+ * @brief Send a COBS frame.
+ *
+ * The CRC-16 of the payload is appended (most significant byte first), the
+ * whole is COBS encoded straight from the caller's buffer into the transmit
+ * buffer, and the frame ends with its delimiter. A frame is only queued when
+ * it fits completely.
+ *
+ * @param[in] p_data payload
+ * @param[in] len    payload length
+ *
+ * @retval E_TRUE  - the frame is queued
+ * @retval E_FALSE - the transmit buffer has no room for the frame
+ */
+bool_t uart_write_frame(const u8_t *p_data, size_t len)
+{
+    u8_t   crc_bytes[UART_FRAME_CRC_SIZE];
+    u8_t   delimiter;
+    u16_t  crc;
+    size_t space;
+    bool_t result;
+
+    result = E_FALSE;
+    space  = (size_t)SPSC_RING_CAPACITY(BYTE_RING_MAX_SIZE) - BYTE_RING_COUNT(tx_ring);
+
+    if ((COBS_ENCODED_MAX(len + UART_FRAME_CRC_SIZE) + 1u) <= space) {
+        crc          = crc16(CRC16_INIT, p_data, len);
+        crc_bytes[0] = (u8_t)(crc >> 8u);
+        crc_bytes[1] = (u8_t)crc;
+        delimiter    = COBS_DELIMITER;
+
+        (void)cobs_encode(p_data, len, crc_bytes, UART_FRAME_CRC_SIZE, frame_put, NULL_PTR);
+        frame_put(NULL_PTR, &delimiter, 1u);
+
+        STATS_PEAK(tx_peak, BYTE_RING_COUNT(tx_ring));
+        uart_start_tx();
+
+        result = E_TRUE;
     } else {
-        data        = BYTE_RING_POP(tx_ring);
-        USART0->UDR = data;
+        STATS_COUNT(tx_drops, (len < 0xFFFFu) ? (u16_t)len : 0xFFFFu);
     }
-}
\ No newline at end of file
+
+    return result;
+}
+
+/**
+ * @brief Select the flow control of the link.
+ *
+ * Software flow control sends XOFF from the RX ISR when the RX ring fill
+ * reaches the high watermark and XON once the application read it down to the
+ * low watermark. XON and XOFF from the peer pause and resume the transmitter;
+ * they are not received as data.
+ *
+ * Hardware flow control drives RTS (PD4) high at the high watermark and low
+ * again at the low watermark, and holds the transmitter while CTS (PD3) is
+ * high. The INT1 interrupt on the falling CTS edge restarts it, so INT1 is
+ * taken in this mode. CTS has its pull-up enabled and must be wired.
+ *
+ * In line and frame mode the sender is paused while both line buffers are with
+ * the application instead.
+ *
+ * @param[in] mode flow control method
+ * @param[in] high RX ring fill that pauses the sender
+ * @param[in] low  RX ring fill that resumes it (below high)
+ *
+ * @retval E_TRUE  - the flow control is set
+ * @retval E_FALSE - invalid mode or watermarks; nothing changed
+ */
+bool_t uart_set_flow_control(BspSerialFlow_t mode, u8_t high, u8_t low)
+{
+    bool_t result;
+
+    result = E_FALSE;
+
+    if ((low < high) && (mode <= E_SERIAL_FLOW_RTS_CTS)) {
+        ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+            /* Release the peer under the old method first. */
+            if (E_TRUE == rx_paused) {
+                rx_resume();
+            }
+
+            tx_xoff          = E_FALSE;
+            EXT_IRQ->EIMSK  &= (u8_t)~EXT_IRQ_INT1_MASK;
+
+            if (E_SERIAL_FLOW_RTS_CTS == mode) {
+                GPIO_D->PORT  = (u8_t)((GPIO_D->PORT & ~RTS_PIN_MASK) | CTS_PIN_MASK);
+                GPIO_D->DDR   = (u8_t)((GPIO_D->DDR  & ~CTS_PIN_MASK) | RTS_PIN_MASK);
+                EXT_IRQ->EICRA = (u8_t)((EXT_IRQ->EICRA & ~EXT_IRQ_ISC10_MASK) | EXT_IRQ_ISC11_MASK);
+            } else if (E_SERIAL_FLOW_RTS_CTS == flow_mode) {
+                GPIO_D->DDR  &= (u8_t)~(RTS_PIN_MASK | CTS_PIN_MASK);
+                GPIO_D->PORT &= (u8_t)~(RTS_PIN_MASK | CTS_PIN_MASK);
+            }
+
+            flow_high = high;
+            flow_low  = low;
+            flow_mode = mode;
+
+            /* Restart a transmitter the old method held. */
+            USART0->UCSRB |= UART_UCSRB_UDRIE_MASK;
+        }
+
+        result = E_TRUE;
+    }
+
+    return result;
+}
+
+/**
+ * @brief Join or leave a multi-drop bus.
+ *
+ * On the bus the USART sends and receives 9-bit frames. A frame with the 9th
+ * bit set carries the address of the node the frames after it are for. The
+ * receiver waits in multi-processor communication mode (MPCM), where the
+ * hardware drops data frames without an RX interrupt, so the RX ISR only runs
+ * for address frames until one names this node or BSP_SERIAL_BROADCAST. Then
+ * it receives the data frames like the 8-bit link does, until the next address
+ * frame names another node.
+ *
+ * The transmitter finishes the bytes already written in the old frame format
+ * first, so interrupts must be enabled when there is output pending.
+ *
+ * @param[in] enable  E_TRUE to use 9-bit frames and address filtering
+ * @param[in] address this node's address (not BSP_SERIAL_BROADCAST)
+ *
+ * @retval E_TRUE  - the frame format is set
+ * @retval E_FALSE - the peer holds output in the old format; nothing changed
+ */
+bool_t uart_set_multidrop(bool_t enable, u8_t address)
+{
+    bool_t result;
+
+    result = tx_drain();
+
+    if (E_TRUE == result) {
+        ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+            node_address = address;
+
+            if (E_TRUE == enable) {
+                USART0->UCSRB |= UART_UCSRB_UCSZ2_MASK;
+                USART0->UCSRA  = (u8_t)((USART0->UCSRA & UART_UCSRA_U2X_MASK) | UART_UCSRA_MPCM_MASK);
+            } else {
+                USART0->UCSRB &= (u8_t)~(UART_UCSRB_UCSZ2_MASK | UART_UCSRB_TXB8_MASK);
+                USART0->UCSRA  = (u8_t)(USART0->UCSRA & UART_UCSRA_U2X_MASK);
+            }
+
+            multidrop = enable;
+        }
+    }
+
+    return result;
+}
+
+/**
+ * @brief Send a message to a node of the multi-drop bus.
+ *
+ * The address frame is queued in front of the payload, which goes out as data
+ * frames after the bytes already written. A message is only queued when it
+ * fits completely. Bytes written with the other write functions afterwards go
+ * to the same node.
+ *
+ * @param[in] address node address, or BSP_SERIAL_BROADCAST for all nodes
+ * @param[in] p_buf   payload
+ * @param[in] len     payload length (may be 0 to only address the node)
+ *
+ * @retval E_TRUE  - the message is queued
+ * @retval E_FALSE - not on a bus, or no room for the address or the payload
+ *                   (only the latter counts as dropped bytes)
+ */
+bool_t uart_send_to(u8_t address, const u8_t *p_buf, size_t len)
+{
+    TxAddress_t mark;
+    size_t      space;
+    bool_t      result;
+
+    result = E_FALSE;
+    space  = (size_t)SPSC_RING_CAPACITY(BYTE_RING_MAX_SIZE) - BYTE_RING_COUNT(tx_ring);
+
+    if (E_FALSE == multidrop) {
+        /* nothing to address */
+    } else if ((len <= space) && (E_FALSE == SPSC_RING_IS_FULL(AddressRing, tx_addresses))) {
+        mark.at      = BYTE_RING_WRITE_POS(tx_ring);
+        mark.address = address;
+
+        (void)SPSC_RING_PUSH(AddressRing, tx_addresses, mark);
+        (void)BYTE_RING_WRITE(tx_ring, p_buf, len);
+
+        STATS_PEAK(tx_peak, BYTE_RING_COUNT(tx_ring));
+        uart_start_tx();
+
+        result = E_TRUE;
+    } else {
+        STATS_COUNT(tx_drops, (len < 0xFFFFu) ? (u16_t)len : 0xFFFFu);
+    }
+
+    return result;
+}
+
+/**
+ * @brief Compute the UBRR value of a baud rate and its error.
+ *
+ * @param[in]  baud    requested rate in bits per second
+ * @param[in]  div     clocks per bit of the mode (16 or 8)
+ * @param[out] p_error rate error in basis points
+ *
+ * @return The UBRR value.
+ */
+static u16_t baud_ubrr(u32_t baud, u8_t div, s32_t *p_error)
+{
+    u32_t bit_clocks;
+    u32_t counts;
+    u32_t actual;
+
+    /* UBRR + 1 = F_CPU / (div * baud), rounded to the nearest count */
+    bit_clocks = (u32_t)div * baud;
+    counts     = ((u32_t)F_CPU + (bit_clocks / 2u)) / bit_clocks;
+
+    if (0u == counts) {
+        counts = 1u;
+    } else if ((UBRR_MAX + 1u) < counts) {
+        counts = UBRR_MAX + 1u;
+    }
+
+    /* (F_CPU - actual) / actual with actual = div * counts * baud, in basis
+       points. |F_CPU - actual| stays below F_CPU, so the product fits. */
+    actual   = bit_clocks * counts;
+    *p_error = (((s32_t)F_CPU - (s32_t)actual) * 100) / ((s32_t)actual / 100);
+
+    return (u16_t)(counts - 1u);
+}
+
+/**
+ * @brief Time the falling edges of a sync character (uart_autobaud).
+ *
+ * Called with the first edge captured. The other edges are polled with
+ * interrupts disabled; at 500 kbit/s they are 64 cycles apart. When the timing
+ * fits a 0x55, the line is followed to its stop bit so the receiver starts on
+ * an idle line.
+ *
+ * @param[out] p_bit_cycles CPU cycles of AUTOBAUD_BITS bit times
+ *
+ * @retval E_TRUE  - the edges are those of a sync character
+ * @retval E_FALSE - another byte, noise, or a line slower than 2400 bit/s
+ */
+static bool_t autobaud_capture(u16_t *p_bit_cycles)
+{
+    u16_t  edges[AUTOBAUD_EDGES];
+    u16_t  interval;
+    u16_t  mean;
+    u16_t  waited;
+    u8_t   e;
+    bool_t in_time;
+    bool_t result;
+
+    result  = E_FALSE;
+    in_time = E_TRUE;
+    waited  = 0u;
+
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+        edges[0] = TIM1->ICR;
+        autobaud_clear_flags(TIM1_TIFR_ICF_MASK);
+
+        for (e = 1u; (e < AUTOBAUD_EDGES) && (E_TRUE == in_time); e += 1u) {
+            while ((0u == (TIM1_IRQ->TIFR & TIM1_TIFR_ICF_MASK)) && (E_TRUE == in_time)) {
+                in_time = autobaud_in_time(edges[0], &waited);
+            }
+
+            edges[e] = TIM1->ICR;
+            autobaud_clear_flags(TIM1_TIFR_ICF_MASK);
+        }
+
+        if (E_TRUE == in_time) {
+            *p_bit_cycles = (u16_t)(edges[AUTOBAUD_EDGES - 1u] - edges[0]);
+            mean          = (u16_t)(*p_bit_cycles / (AUTOBAUD_EDGES - 1u));
+            result        = (0u != mean) ? E_TRUE : E_FALSE;
+
+            for (e = 1u; e < AUTOBAUD_EDGES; e += 1u) {
+                interval = (u16_t)(edges[e] - edges[e - 1u]);
+
+                if ((mean >> AUTOBAUD_SKEW_SHIFT) <
+                    (u16_t)BAUD_ERROR_ABS((s32_t)interval - (s32_t)mean)) {
+                    result = E_FALSE;
+                }
+            }
+        }
+
+        /* Wait out bit 7 (low) for the stop bit. */
+        while ((E_TRUE == result) && (0u == (GPIO_B->PIN & ICP_PIN_MASK)) &&
+               (E_TRUE == in_time)) {
+            in_time = autobaud_in_time(edges[0], &waited);
+        }
+    }
+
+    return result;
+}
+
+/**
+ * @brief Check if a sync character still fits the 16-bit counter.
+ *
+ * The time since the first edge only grows until it wraps, a full counter
+ * period later.
+ *
+ * @param[in]    start    capture of the first edge
+ * @param[inout] p_waited cycles since the first edge at the last check
+ *
+ * @retval E_TRUE  - less than 65536 cycles since the first edge
+ * @retval E_FALSE - the counter wrapped
+ */
+static bool_t autobaud_in_time(u16_t start, u16_t *p_waited)
+{
+    u16_t  elapsed;
+    bool_t in_time;
+
+    elapsed = (u16_t)(TIM1->TCNT - start);
+    in_time = (*p_waited <= elapsed) ? E_TRUE : E_FALSE;
+    *p_waited = elapsed;
+
+    return in_time;
+}
+
+/**
+ * @brief Clear Timer1 interrupt flags that are set.
+ *
+ * The flags clear by writing a 1. Only set flags are written, so the host
+ * backend (whose register file keeps what is written) never sees a flag the
+ * hardware did not raise.
+ *
+ * @param[in] mask flags to clear
+ */
+static void autobaud_clear_flags(u8_t mask)
+{
+    u8_t set;
+
+    set = TIM1_IRQ->TIFR & mask;
+    if (0u != set) {
+        TIM1_IRQ->TIFR = set;
+    }
+}
+
+/**
+ * @brief Wait until the bytes written so far left the transmitter.
+ *
+ * @retval E_TRUE  - the transmitter is idle
+ * @retval E_FALSE - the peer holds the transmitter (XOFF or CTS) with bytes
+ *                   still queued
+ */
+static bool_t tx_drain(void)
+{
+    bool_t drained;
+
+    drained = E_TRUE;
+
+    /* The UDRE ISR also turns its interrupt off while the peer holds the
+       transmitter, so the rings tell when everything is loaded. Bytes only
+       queued (uart_queue_buf) are started here. */
+    if (E_FALSE == tx_is_empty()) {
+        uart_start_tx();
+    }
+
+    while ((E_TRUE == drained) && (E_FALSE == tx_is_empty())) {
+        if ((E_TRUE == tx_xoff) ||
+            ((E_SERIAL_FLOW_RTS_CTS == flow_mode) && (0u != (GPIO_D->PIN & CTS_PIN_MASK)))) {
+            drained = E_FALSE;
+        }
+    }
+
+    if (E_TRUE == drained) {
+        /* The UDRE ISR turns its interrupt off after loading the last byte. */
+        while (0u != (USART0->UCSRB & UART_UCSRB_UDRIE_MASK)) {
+            /* wait for the data register */
+        }
+
+        /* Then the last byte is shifted out (the TXC ISR clears the flag and
+           tx_started when the drained callback is set). */
+        while ((E_TRUE == tx_started) && (0u == (USART0->UCSRA & UART_UCSRA_TXC_MASK))) {
+            /* wait for the shift register */
+        }
+    }
+
+    return drained;
+}
+
+/**
+ * @brief Arm the space callback when the TX ring is above its mark
+ * (application).
+ *
+ * Checked with interrupts off: the ring is not empty when it is above the
+ * mark, so the UDRE ISR still has a byte to pop and see the mark with.
+ */
+static void tx_arm_space(void)
+{
+    if (NULL_PTR != tx_space_cb) {
+        ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+            if (tx_notify_fill < BYTE_RING_COUNT(tx_ring)) {
+                tx_space_armed = E_TRUE;
+            }
+        }
+    }
+}
+
+/**
+ * @brief Check if nothing waits for the transmitter.
+ *
+ * @retval E_TRUE  - the TX and echo rings are empty
+ * @retval E_FALSE - bytes are queued
+ */
+static bool_t tx_is_empty(void)
+{
+    bool_t empty;
+
+    empty = E_FALSE;
+
+    if ((E_TRUE == BYTE_RING_IS_EMPTY(tx_ring)) &&
+        (E_TRUE == SPSC_RING_IS_EMPTY(EchoRing, echo_ring)) &&
+        (E_TRUE == SPSC_RING_IS_EMPTY(AddressRing, tx_addresses))) {
+        empty = E_TRUE;
+    }
+
+    return empty;
+}
+
+/**
+ * @brief Add a received byte to the line being filled (RX ISR).
+ *
+ * @param[in] data the received byte
+ */
+static void line_receive(u8_t data)
+{
+    if (LINE_END == data) {
+        if (E_TRUE == line_discard) {
+            line_discard = E_FALSE;
+            rx_drop(data);
+        } else {
+            /* Seal the line and move on to the other buffer. */
+            line_buf[line_fill][line_fill_len] = '\0';
+            line_len[line_fill]   = line_fill_len;
+            line_ready[line_fill] = E_TRUE;
+            line_fill    ^= 1u;
+            line_fill_len = 0u;
+            TRACE(E_TRACE_UART_RX, data);
+
+            /* Both buffers are with the application. */
+            if (E_TRUE == line_ready[line_fill]) {
+                rx_pause();
+            }
+
+            echo_byte(LINE_END);
+            echo_byte('\r');
+        }
+    } else if (LINE_IGNORED == data) {
+        /* terminals send CR LF */
+    } else if ((LINE_BACKSPACE == data) || (LINE_DELETE == data)) {
+        if (0u != line_fill_len) {
+            line_fill_len -= 1u;
+
+            echo_byte(LINE_BACKSPACE);
+            echo_byte(' ');
+            echo_byte(LINE_BACKSPACE);
+        }
+    } else if (LINE_CONTROL_END > data) {
+        /* Out of band control bytes go to the application as before. */
+        if (E_TRUE == BYTE_RING_PUSH(rx_ring, data)) {
+            TRACE(E_TRACE_UART_RX, data);
+            STATS_PEAK(rx_peak, BYTE_RING_COUNT(rx_ring));
+        } else {
+            rx_drop(data);
+        }
+    } else if ((E_TRUE == line_discard) || (E_TRUE == line_ready[line_fill])) {
+        /* Both buffers are with the application; the line is lost. */
+        line_discard = E_TRUE;
+        rx_drop(data);
+    } else if ((UART_LINE_SIZE - 1u) <= line_fill_len) {
+        /* Keep room for the NULL. */
+        rx_drop(data);
+    } else {
+        line_buf[line_fill][line_fill_len] = data;
+        line_fill_len += 1u;
+        TRACE(E_TRACE_UART_RX, data);
+        echo_byte(data);
+    }
+}
+
+/**
+ * @brief Decode a received byte into the frame being filled (RX ISR).
+ *
+ * @param[in] data the received byte
+ */
+static void frame_receive(u8_t data)
+{
+    CobsStatus_t status;
+
+    if (COBS_DELIMITER == data) {
+        if (E_TRUE == line_discard) {
+            /* The dropped frame ends; the decoder never saw it. */
+            line_discard = E_FALSE;
+            rx_drop(data);
+        } else {
+            status = cobs_decode(&frame_decoder, data);
+
+            if (E_COBS_FRAME == status) {
+                /* Seal the frame and move on to the other buffer. */
+                line_len[line_fill]   = (u8_t)frame_decoder.len;
+                line_ready[line_fill] = E_TRUE;
+                line_fill            ^= 1u;
+                cobs_decoder_init(&frame_decoder, line_buf[line_fill], UART_LINE_SIZE);
+                TRACE(E_TRACE_UART_RX, data);
+
+                /* Both buffers are with the application. */
+                if (E_TRUE == line_ready[line_fill]) {
+                    rx_pause();
+                }
+            } else if (E_COBS_ERROR == status) {
+                STATS_COUNT(rx_frame_errors, 1u);
+            } else {
+                /* back to back delimiters */
+            }
+        }
+    } else if ((E_TRUE == line_discard) || (E_TRUE == line_ready[line_fill])) {
+        /* Both buffers are with the application; the frame is lost. */
+        line_discard = E_TRUE;
+        rx_drop(data);
+    } else {
+        (void)cobs_decode(&frame_decoder, data);
+        TRACE(E_TRACE_UART_RX, data);
+    }
+}
+
+/**
+ * @brief COBS encoder sink of uart_write_frame (the room was checked).
+ */
+static void frame_put(void *p_ctx, const u8_t *p_data, size_t len)
+{
+    (void)p_ctx;
+    (void)BYTE_RING_WRITE(tx_ring, p_data, len);
+}
+
+/**
+ * @brief Count the receive errors flagged with a byte (RX ISR).
+ *
+ * @param[in] status UCSRA read before the byte
+ */
+static void rx_errors(u8_t status)
+{
+    if (0u != (status & UART_UCSRA_DOR_MASK)) {
+        STATS_COUNT(rx_overruns, 1u);
+    }
+
+    if (0u != (status & UART_UCSRA_FE_MASK)) {
+        STATS_COUNT(rx_framing_errors, 1u);
+    }
+
+    if (0u != (status & UART_UCSRA_UPE_MASK)) {
+        STATS_COUNT(rx_parity_errors, 1u);
+    }
+}
+
+/**
+ * @brief Count a received byte the driver had no room for (RX ISR).
+ *
+ * @param[in] data the lost byte
+ */
+static void rx_drop(u8_t data)
+{
+    TRACE(E_TRACE_UART_RX_DROP, data);
+    STATS_COUNT(rx_drops, 1u);
+}
+
+/**
+ * @brief Tell the sender to stop (RX ISR).
+ */
+static void rx_pause(void)
+{
+    if ((E_FALSE == rx_paused) && (E_SERIAL_FLOW_NONE != flow_mode)) {
+        rx_paused = E_TRUE;
+        STATS_COUNT(rx_pauses, 1u);
+
+        if (E_SERIAL_FLOW_XON_XOFF == flow_mode) {
+            send_flow_byte(FLOW_XOFF);
+        } else {
+            GPIO_D->PORT |= RTS_PIN_MASK;
+        }
+    }
+}
+
+/**
+ * @brief Let the sender go on (interrupts disabled).
+ */
+static void rx_resume(void)
+{
+    rx_paused = E_FALSE;
+
+    if (E_SERIAL_FLOW_XON_XOFF == flow_mode) {
+        send_flow_byte(FLOW_XON);
+    } else {
+        GPIO_D->PORT &= (u8_t)~RTS_PIN_MASK;
+    }
+}
+
+/**
+ * @brief Resume the sender once the application made room (application).
+ */
+static void rx_check_resume(void)
+{
+    bool_t room;
+
+    if (E_TRUE == rx_paused) {
+        ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+            if ((E_TRUE == line_mode) || (E_TRUE == frame_mode)) {
+                room = (E_FALSE == line_ready[line_fill]) ? E_TRUE : E_FALSE;
+            } else {
+                room = (BYTE_RING_COUNT(rx_ring) <= flow_low) ? E_TRUE : E_FALSE;
+            }
+
+            if ((E_TRUE == rx_paused) && (E_TRUE == room)) {
+                rx_resume();
+            }
+        }
+    }
+}
+
+/**
+ * @brief Send XON or XOFF ahead of everything else (interrupts disabled).
+ *
+ * @param[in] data XON or XOFF
+ */
+static void send_flow_byte(u8_t data)
+{
+    flow_byte      = data;
+    USART0->UCSRB |= UART_UCSRB_UDRIE_MASK;
+}
+
+/**
+ * @brief Check if the peer paused the transmitter (UDRE ISR).
+ *
+ * @retval E_TRUE  - hold the data until XON or the CTS edge
+ * @retval E_FALSE - send
+ */
+static bool_t tx_held(void)
+{
+    bool_t held;
+
+    held = tx_xoff;
+
+    if ((E_FALSE == held) && (E_SERIAL_FLOW_RTS_CTS == flow_mode) &&
+        (0u != (GPIO_D->PIN & CTS_PIN_MASK))) {
+        /* Arm the CTS edge, then look again in case it came before. */
+        EXT_IRQ->EIFR   = EXT_IRQ_INT1_MASK;
+        EXT_IRQ->EIMSK |= EXT_IRQ_INT1_MASK;
+
+        held = (0u != (GPIO_D->PIN & CTS_PIN_MASK)) ? E_TRUE : E_FALSE;
+    }
+
+    return held;
+}
+
+/**
+ * @brief Queue an echo byte (RX ISR).
+ *
+ * @param[in] data byte to echo
+ */
+static void echo_byte(u8_t data)
+{
+    if (E_TRUE == line_echo) {
+        (void)SPSC_RING_PUSH(EchoRing, echo_ring, data);
+        USART0->UCSRB |= UART_UCSRB_UDRIE_MASK;
+    }
+}
+
+/**
+ * @brief Follow an address frame of the multi-drop bus (RX ISR).
+ *
+ * Addressed, the receiver takes the data frames that follow; otherwise MPCM
+ * has the hardware drop them until the next address frame.
+ *
+ * @param[in] address the received address
+ */
+static void multidrop_address(u8_t address)
+{
+    if ((node_address == address) || (BSP_SERIAL_BROADCAST == address)) {
+        USART0->UCSRA = (u8_t)(USART0->UCSRA & UART_UCSRA_U2X_MASK);
+    } else {
+        USART0->UCSRA = (u8_t)((USART0->UCSRA & UART_UCSRA_U2X_MASK) | UART_UCSRA_MPCM_MASK);
+    }
+}
+
+/**
+ * @brief Take the next address frame once the TX ring reached its position
+ * (UDRE ISR).
+ *
+ * @param[out] p_address the address to send
+ *
+ * @retval E_TRUE  - an address frame goes out next
+ * @retval E_FALSE - a data frame goes out next, if any
+ */
+static bool_t tx_address_due(u8_t *p_address)
+{
+    TxAddress_t mark;
+    bool_t      due;
+
+    due = E_FALSE;
+
+    if ((E_TRUE == SPSC_RING_PEEK(AddressRing, tx_addresses, &mark)) &&
+        (BYTE_RING_READ_POS(tx_ring) == mark.at)) {
+        (void)SPSC_RING_POP(AddressRing, tx_addresses, &mark);
+        *p_address = mark.address;
+        due        = E_TRUE;
+    }
+
+    return due;
+}
+
+ISR(USART_RX_vect)
+{
+    u8_t status;
+    u8_t control;
+    u8_t data;
+    u8_t fill;
+
+    /* Read the data regardless of the ring state to clear the interrupt. The
+       error flags and the 9th bit (RXB8) are only valid before UDR is read. */
+    status  = USART0->UCSRA;
+    control = USART0->UCSRB;
+    data    = USART0->UDR;
+
+    if (0u != (status & RX_ERROR_MASK)) {
+        rx_errors(status);
+    }
+
+    if ((E_TRUE == multidrop) && (0u != (control & UART_UCSRB_RXB8_MASK))) {
+        multidrop_address(data);
+    } else if (E_TRUE == frame_mode) {
+        frame_receive(data);
+    } else if ((E_SERIAL_FLOW_XON_XOFF == flow_mode) && ((FLOW_XON == data) || (FLOW_XOFF == data))) {
+        /* The peer pauses or resumes the transmitter. */
+        tx_xoff = (FLOW_XOFF == data) ? E_TRUE : E_FALSE;
+        USART0->UCSRB |= UART_UCSRB_UDRIE_MASK;
+    } else if (E_TRUE == line_mode) {
+        line_receive(data);
+    } else if (E_TRUE == BYTE_RING_PUSH(rx_ring, data)) {
+        TRACE(E_TRACE_UART_RX, data);
+        fill = BYTE_RING_COUNT(rx_ring);
+        STATS_PEAK(rx_peak, fill);
+
+        if (flow_high <= fill) {
+            rx_pause();
+        }
+    } else {
+        /* The byte is lost when the ring is full. */
+        rx_drop(data);
+    }
+}
+
+ISR(USART_UDRE_vect)
+{
+    u8_t   data;
+    bool_t loaded;
+    bool_t address;
+
+    data    = 0u;
+    loaded  = E_FALSE;
+    address = E_FALSE;
+
+    /* A pending XON or XOFF goes out even while the peer holds us. The echo
+       goes out next, so it keeps up with the typing. */
+    if (0u != flow_byte) {
+        data      = flow_byte;
+        flow_byte = 0u;
+        loaded    = E_TRUE;
+    } else if (E_TRUE == tx_held()) {
+        /* XON or the CTS edge turns the interrupt back on */
+    } else if (E_TRUE == SPSC_RING_POP(EchoRing, echo_ring, &data)) {
+        loaded = E_TRUE;
+    } else if (E_TRUE == tx_address_due(&data)) {
+        loaded  = E_TRUE;
+        address = E_TRUE;
+    } else if (E_TRUE == BYTE_RING_POP(tx_ring, &data)) {
+        loaded = E_TRUE;
+    }
+
+    if (E_TRUE == loaded) {
+        /* On the bus the 9th bit must be in place before UDR is written. */
+        if (E_TRUE == multidrop) {
+            if (E_TRUE == address) {
+                USART0->UCSRB |= UART_UCSRB_TXB8_MASK;
+            } else {
+                USART0->UCSRB &= (u8_t)~UART_UCSRB_TXB8_MASK;
+            }
+        }
+
+        USART0->UDR = data;
+
+        /* Clear TXC (by writing a 1) once the last queued byte is loaded, so it
+           marks the end of that byte. TXC is only read once everything is
+           sent, so a flag left from a gap in the middle of the stream does not
+           matter and the bytes before the last skip the read-modify-write.
+           UDR holds the byte, so TXC cannot be set again before it is out. */
+        if ((E_TRUE == tx_is_empty()) && (0u == flow_byte)) {
+            USART0->UCSRA = (u8_t)((USART0->UCSRA & (UART_UCSRA_U2X_MASK | UART_UCSRA_MPCM_MASK)) |
+                                   UART_UCSRA_TXC_MASK);
+        }
+        tx_started = E_TRUE;
+        TRACE(E_TRACE_UART_TX, data);
+
+        if ((E_TRUE == tx_space_armed) && (BYTE_RING_COUNT(tx_ring) <= tx_notify_fill)) {
+            tx_space_armed = E_FALSE;
+            tx_space_cb();
+        }
+    } else {
+        USART0->UCSRB &= ~UART_UCSRB_UDRIE_MASK;
+
+        /* TXC marks the end of the last byte loaded. */
+        if ((NULL_PTR != tx_drained_cb) && (E_TRUE == tx_started)) {
+            USART0->UCSRB |= UART_UCSRB_TXCIE_MASK;
+        }
+    }
+}
+
+ISR(USART_TX_vect)
+{
+    /* Entering the vector cleared TXC; the line is idle. */
+    USART0->UCSRB &= ~UART_UCSRB_TXCIE_MASK;
+    tx_started     = E_FALSE;
+
+    /* A write since the UDRE ISR ran out restarts the transmitter. */
+    if ((E_TRUE == tx_is_empty()) && (0u == (USART0->UCSRB & UART_UCSRB_UDRIE_MASK)) &&
+        (NULL_PTR != tx_drained_cb)) {
+        tx_drained_cb();
+    }
+}
+
+ISR(INT1_vect)
+{
+    /* CTS was asserted, restart the transmitter (hardware flow control). */
+    EXT_IRQ->EIMSK &= (u8_t)~EXT_IRQ_INT1_MASK;
+    USART0->UCSRB  |= UART_UCSRB_UDRIE_MASK;
+}
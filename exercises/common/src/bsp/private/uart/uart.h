@@ -1,16 +1,48 @@
 #ifndef UART_H
 #define UART_H
 
+#include "bsp/bsp.h"
 #include "types.h"
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
+#define UART_DEFAULT_BAUD   (19200ul)   /* rate of the exercises                */
+#define UART_BAUD_MAX_ERROR (200)       /* 2.00 % in basis points (0.01 %)      */
+
+#define UART_FLOW_HIGH      (192u)      /* default RX ring fill that pauses     */
+#define UART_FLOW_LOW       (64u)       /* default RX ring fill that resumes    */
+
+#define UART_LINES          (2u)    /* line mode buffers (ping-pong)           */
+#define UART_LINE_SIZE      (64u)   /* bytes of a line buffer, including NULL  */
+#define UART_FRAME_CRC_SIZE (2u)    /* CRC-16 at the end of a frame            */
+
 void uart_init(void);
+bool_t uart_set_baud(u32_t baud, s32_t *p_error);
+bool_t uart_autobaud(u16_t timeout_msec, u32_t *p_baud);
 bool_t uart_data_available(void);
 u8_t uart_read(void);
 bool_t uart_write(u8_t byte);
+size_t uart_read_buf(u8_t *p_buf, size_t len);
+size_t uart_queue_buf(const u8_t *p_buf, size_t len);
+size_t uart_queue_P(const u8_t *p_flash, size_t len);
+void uart_start_tx(void);
+size_t uart_write_buf(const u8_t *p_buf, size_t len);
+size_t uart_write_async(const u8_t *p_buf, size_t len);
+size_t uart_tx_space(void);
+bool_t uart_tx_idle(void);
+void uart_set_tx_notify(u8_t space, IsrCallback_t on_space, IsrCallback_t on_drained);
+void uart_get_stats(BspSerialStats_t *p_stats, bool_t clear);
+bool_t uart_set_flow_control(BspSerialFlow_t mode, u8_t high, u8_t low);
+bool_t uart_set_multidrop(bool_t enable, u8_t address);
+bool_t uart_send_to(u8_t address, const u8_t *p_buf, size_t len);
+void uart_set_line_mode(bool_t enable, bool_t echo);
+bool_t uart_get_line(char **pp_line, size_t *p_len);
+void uart_release_line(void);
+void uart_set_frame_mode(bool_t enable);
+bool_t uart_get_frame(u8_t **pp_frame, size_t *p_len);
+bool_t uart_write_frame(const u8_t *p_data, size_t len);
 
 #ifdef __cplusplus
 }
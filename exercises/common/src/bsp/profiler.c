@@ -0,0 +1,254 @@
+#include "bsp/profiler.h"
+
+#include <avr/interrupt.h>
+#include <avr/pgmspace.h>
+
+#include "bsp/bsp.h"
+#include "bsp/private/processor/reg_io.h"
+#include "types.h"
+
+/* Timer2 clock select (CS2[2:0]). The prescalers differ from timers 0 and 1. */
+#define TIM2_CS_MASK        (0x07u)
+#define TIM2_CS_32          (0x03u)     /* 256 * 32 / 16 MHz = 512 usec period */
+
+/* Timer2 overflow interrupt enable/flag bit */
+#define TIM2_TOV_MASK       (1u << 0u)
+
+#define COUNT_MAX           (0xFFFFu)
+
+/* Byte address one past the end of the program code (linker script) */
+extern u8_t _etext;
+
+void profiler_sample__(u16_t pc);
+
+static u16_t histogram[PROFILER_BINS];  /* samples per bin of code addresses */
+static u16_t outside;                   /* samples past the last bin         */
+static u8_t  bin_shift;                 /* log2 of the bytes per bin         */
+
+static void write_c_str(const char *c_str);
+static void write_c_str_P(const char *c_str);
+static void write_hex(u16_t num);
+
+/**
+ * @brief Initialize the sampling profiler.
+ *
+ * The program code is split into PROFILER_BINS bins of a power of two bytes
+ * each. Timer2 is configured for a 512 usec overflow but not started.
+ */
+void profiler_init(void)
+{
+    u16_t text_end;
+
+    text_end  = (u16_t)&_etext;
+    bin_shift = 0u;
+
+    while ((u16_t)(text_end >> bin_shift) >= PROFILER_BINS) {
+        bin_shift += 1u;
+    }
+
+    profiler_reset();
+
+    /* Normal mode, stopped, overflow interrupt only */
+    TIM2->TCCRB     = 0x00u;
+    TIM2->TCCRA     = 0x00u;
+    TIM2->TCNT      = 0x00u;
+    TIM2_IRQ->TIFR  = TIM2_TOV_MASK;    /* write 1 to clear */
+    TIM2_IRQ->TIMSK = TIM2_TOV_MASK;
+}
+
+/**
+ * @brief Start (or resume) sampling.
+ *
+ * Only code running with interrupts enabled is sampled. Time spent in other
+ * interrupt service routines shows up on the instruction they return to.
+ */
+void profiler_start(void)
+{
+    TIM2->TCCRB = (TIM2->TCCRB & ~TIM2_CS_MASK) | TIM2_CS_32;
+}
+
+/**
+ * @brief Stop sampling. The histogram is kept.
+ */
+void profiler_stop(void)
+{
+    TIM2->TCCRB &= ~TIM2_CS_MASK;
+}
+
+/**
+ * @brief Clear the histogram.
+ */
+void profiler_reset(void)
+{
+    u8_t sreg;
+    u8_t b;
+
+    sreg = SREG;
+    cli();
+
+    for (b = 0u; b < PROFILER_BINS; b += 1u) {
+        histogram[b] = 0u;
+    }
+    outside = 0u;
+
+    SREG = sreg;
+}
+
+/**
+ * @brief Write the histogram to the serial port.
+ *
+ * Sampling is paused for the dump so the report is a consistent snapshot. The
+ * report is text, one non-empty bin per line with hexadecimal fields:
+ *
+ *     PROFILE-BEGIN <bin shift>
+ *     <bin byte address> <samples>
+ *     ...
+ *     PROFILE-END <samples outside the bins>
+ *
+ * scripts/profile_report.py maps the bins to functions. Interrupts must be
+ * enabled since the serial writes wait for room in the transmit buffer.
+ */
+void profiler_dump(void)
+{
+    u8_t cs;
+    u8_t b;
+
+    cs = TIM2->TCCRB & TIM2_CS_MASK;
+    profiler_stop();
+
+    write_c_str_P(PSTR("\nPROFILE-BEGIN "));
+    write_hex(bin_shift);
+    write_c_str_P(PSTR("\n"));
+
+    for (b = 0u; b < PROFILER_BINS; b += 1u) {
+        if (0u != histogram[b]) {
+            write_hex((u16_t)b << bin_shift);
+            write_c_str_P(PSTR(" "));
+            write_hex(histogram[b]);
+            write_c_str_P(PSTR("\n"));
+        }
+    }
+
+    write_c_str_P(PSTR("PROFILE-END "));
+    write_hex(outside);
+    write_c_str_P(PSTR("\n"));
+
+    TIM2->TCCRB |= cs;
+}
+
+/**
+ * @brief Count one sample (called from the Timer2 overflow ISR).
+ *
+ * Counts saturate instead of wrapping so a long run can't hide a hot spot.
+ *
+ * @param[in] pc interrupted program counter (word address)
+ */
+void profiler_sample__(u16_t pc)
+{
+    u16_t bin;
+
+    bin = (u16_t)(pc << 1u) >> bin_shift;
+
+    if (bin < PROFILER_BINS) {
+        if (COUNT_MAX != histogram[bin]) {
+            histogram[bin] += 1u;
+        }
+    } else if (COUNT_MAX != outside) {
+        outside += 1u;
+    }
+}
+
+static void write_c_str(const char *c_str)
+{
+    const char *p_c;
+
+    for (p_c = c_str; '\0' != *p_c; p_c += 1) {
+        while (E_FALSE == bsp_serial_write((u8_t)*p_c)) {
+            /* wait for the transmitter to make room */
+        }
+    }
+}
+
+/* The literals stay in flash (PSTR) and are read a byte at a time. */
+static void write_c_str_P(const char *c_str)
+{
+    const char *p_c;
+    char        c;
+
+    for (p_c = c_str; '\0' != (c = (char)pgm_read_byte(p_c)); p_c += 1) {
+        while (E_FALSE == bsp_serial_write((u8_t)c)) {
+            /* wait for the transmitter to make room */
+        }
+    }
+}
+
+static void write_hex(u16_t num)
+{
+    static const char HEX_DIGITS[] PROGMEM = "0123456789ABCDEF";
+
+    char c_str[5];
+    u8_t i;
+
+    for (i = 0u; i < 4u; i += 1u) {
+        c_str[3u - i] = (char)pgm_read_byte(&HEX_DIGITS[num & 0x0Fu]);
+        num >>= 4u;
+    }
+    c_str[4] = '\0';
+
+    write_c_str(c_str);
+}
+
+/*
+ * INTERRUPT SERVICE ROUTINES
+ */
+
+/*
+ * The return address is read at a known offset from the stack pointer, which
+ * needs a prologue the compiler does not choose. The stub saves the registers
+ * a C call may clobber (15 bytes), so the interrupted PC sits above them: high
+ * byte at SP+16, low byte at SP+17 (the AVR pushes the PC low byte first).
+ */
+ISR(TIMER2_OVF_vect, ISR_NAKED)
+{
+    __asm__ __volatile__ (
+        "    push r1                    \n"
+        "    push r0                    \n"
+        "    in   r0, __SREG__          \n"
+        "    push r0                    \n"
+        "    clr  r1                    \n"
+        "    push r18                   \n"
+        "    push r19                   \n"
+        "    push r20                   \n"
+        "    push r21                   \n"
+        "    push r22                   \n"
+        "    push r23                   \n"
+        "    push r24                   \n"
+        "    push r25                   \n"
+        "    push r26                   \n"
+        "    push r27                   \n"
+        "    push r30                   \n"
+        "    push r31                   \n"
+        "    in   r30, __SP_L__         \n"
+        "    in   r31, __SP_H__         \n"
+        "    ldd  r25, Z+16             \n"
+        "    ldd  r24, Z+17             \n"
+        "    call profiler_sample__     \n"
+        "    pop  r31                   \n"
+        "    pop  r30                   \n"
+        "    pop  r27                   \n"
+        "    pop  r26                   \n"
+        "    pop  r25                   \n"
+        "    pop  r24                   \n"
+        "    pop  r23                   \n"
+        "    pop  r22                   \n"
+        "    pop  r21                   \n"
+        "    pop  r20                   \n"
+        "    pop  r19                   \n"
+        "    pop  r18                   \n"
+        "    pop  r0                    \n"
+        "    out  __SREG__, r0          \n"
+        "    pop  r0                    \n"
+        "    pop  r1                    \n"
+        "    reti                       \n"
+    );
+}
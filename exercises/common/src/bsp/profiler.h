@@ -0,0 +1,38 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include "types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * The profiler is compiled in with the BSP_PROFILER CMake option. Without it
+ * the calls below compile to nothing and Timer2 stays off.
+ */
+#if defined(BSP_PROFILER)
+
+#define PROFILER_BINS   (128u)
+
+void profiler_init(void);
+void profiler_start(void);
+void profiler_stop(void);
+void profiler_reset(void);
+void profiler_dump(void);
+
+#else
+
+#define profiler_init()
+#define profiler_start()
+#define profiler_stop()
+#define profiler_reset()
+#define profiler_dump()
+
+#endif /* BSP_PROFILER */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* PROFILER_H */
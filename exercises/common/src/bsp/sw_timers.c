@@ -18,20 +18,16 @@ typedef struct sw_timer
 
 
 /* Ring buffer infrastructure */
-#define PRIVATE_RING_SIZE MAX_SW_TIMERS
-#include "utils/private_ring.h"
+#include "utils/spsc_ring.h"
 
-PRIVATE_RING_DECLARATIONS(SwTimers, SwTimerHandle_t) /* create ring type of timer handles */
-PRIVATE_RING_DECLARE(static SwTimers, handle_ring);  /* instances of timer handle ring    */
-static SwTimer_t timer_mem[MAX_SW_TIMERS];           /* backing storage for handles       */
+SPSC_RING_DECLARATIONS(SwTimers, SwTimerHandle_t, MAX_SW_TIMERS) /* create ring type of timer handles */
+SPSC_RING_DECLARE(static SwTimers, handle_ring);                 /* instances of timer handle ring    */
+static SwTimer_t timer_mem[MAX_SW_TIMERS];                       /* backing storage for handles       */
 
-/* Readability macros for private ring functions */
-#define TIMER_RING_INIT(var_name)       PRIVATE_RING_INIT(SwTimers, var_name)
-#define TIMER_RING_IS_EMPTY(var_name)   PRIVATE_RING_IS_EMPTY(SwTimers, var_name)
-#define TIMER_RING_IS_FULL(var_name)    PRIVATE_RING_IS_FULL(SwTimers, var_name)
-#define TIMER_RING_PUSH(var_name, data) PRIVATE_RING_PUSH(SwTimers, var_name, data)
-#define TIMER_RING_POP(var_name)        PRIVATE_RING_POP(SwTimers, var_name)
-#define TIMER_RING_PEEK(var_name)       PRIVATE_RING_PEEK(SwTimers, var_name)
+/* Readability macros for the ring functions */
+#define TIMER_RING_INIT(var_name)         SPSC_RING_INIT(SwTimers, var_name)
+#define TIMER_RING_PUSH(var_name, data)   SPSC_RING_PUSH(SwTimers, var_name, data)
+#define TIMER_RING_POP(var_name, p_data)  SPSC_RING_POP(SwTimers, var_name, p_data)
 
 
 static void init_hw_timer(void);
@@ -49,7 +45,7 @@ void sw_timer_init(void)
     /* Reset all timer instances and enqueue their handles in the ring */
     for (t = 0; t < MAX_SW_TIMERS; t += 1) {
         sw_timer_reset(&timer_mem[t]);
-        TIMER_RING_PUSH(handle_ring, &timer_mem[t]);
+        (void)TIMER_RING_PUSH(handle_ring, &timer_mem[t]);
     }
 }
 
@@ -74,11 +70,10 @@ SwTimerHandle_t sw_timer_acquire(void)
 {
     SwTimerHandle_t handle;
 
-    if (E_TRUE == TIMER_RING_IS_EMPTY(handle_ring)) {
-        handle  = SW_TIMER_NO_TIMER;
-    } else {
-        handle = TIMER_RING_POP(handle_ring);
+    if (E_TRUE == TIMER_RING_POP(handle_ring, &handle)) {
         sw_timer_reset(handle);
+    } else {
+        handle = SW_TIMER_NO_TIMER;
     }
 
     return handle;
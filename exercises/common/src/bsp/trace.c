@@ -0,0 +1,136 @@
+#include "bsp/trace.h"
+
+#include <avr/interrupt.h>
+
+#include "bsp/bsp.h"
+#include "bsp/private/processor/reg_io.h"
+#include "types.h"
+
+/* TIM0 overflow interrupt enable bit (TIMSK0) */
+#define TIM0_TOIE_MASK  (1u << 0u)
+
+/* Drain frame header: sync, sync, record count, timestamp low, timestamp high */
+#define SYNC_0          (0xA5u)
+#define SYNC_1          (0x5Au)
+#define HEADER_LEN      (5u)
+#define RECORD_LEN      (4u)
+
+TraceRecord_t trace_ring__[TRACE_RECORDS];
+u8_t          trace_head__;
+u8_t          trace_count__;
+u8_t          trace_paused__;
+volatile u8_t trace_ovf__;
+
+static void write_byte(u8_t byte);
+
+/**
+ * @brief Initialize the trace.
+ *
+ * Timestamps come from TIM0, the free running 64 usec timer of the software
+ * timers. The TIM0 overflow interrupt extends it to 16 bits. The timer is
+ * started with the software timer configuration if it is not running yet.
+ */
+void trace_init(void)
+{
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+        trace_head__   = 0u;
+        trace_count__  = 0u;
+        trace_paused__ = 0u;
+        trace_ovf__    = 0u;
+
+        if (0u == (TIM0->TCCRB & 0x07u)) {
+            TIM0->TCCRA = 0x00u;
+            TIM0->TCCRB = 0x05u;    /* CLK_io / 1024 */
+        }
+
+        TIM0_IRQ->TIMSK |= TIM0_TOIE_MASK;
+    }
+}
+
+/**
+ * @brief Stream the trace out of the serial port and empty it.
+ *
+ * The frames are binary (see scripts/trace_decode.py):
+ *
+ *     0xA5 0x5A <count> <now lo> <now hi> <count records of id arg ts-lo ts-hi>
+ *
+ * Records are sent oldest first. A call never waits for the transmitter: it
+ * sends one frame once the rest of the trace fits in the transmit buffer, or
+ * once the transmitter is idle and the frame takes as many records as fit, so a
+ * full trace goes out in two frames. Recording is paused until the trace is
+ * empty so the serial traffic of the drain does not overwrite the records.
+ *
+ * @retval E_TRUE  - the trace is empty
+ * @retval E_FALSE - records are left, call again
+ */
+bool_t trace_drain(void)
+{
+    TraceRecord_t *p_rec;
+    bool_t         drained;
+    size_t         space;
+    u8_t           count;
+    u8_t           idx;
+    u8_t           i;
+    u16_t          now;
+
+    drained = E_FALSE;
+
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+        now            = trace_timestamp__();
+        trace_paused__ = 1u;
+    }
+
+    count = trace_count__;
+    space = bsp_serial_tx_space();
+
+    if (((HEADER_LEN + ((size_t)count * RECORD_LEN)) <= space) ||
+        (E_TRUE == bsp_serial_tx_idle())) {
+        if (((space - HEADER_LEN) / RECORD_LEN) < count) {
+            count = (u8_t)((space - HEADER_LEN) / RECORD_LEN);
+        }
+
+        idx = (trace_head__ - trace_count__) & (TRACE_RECORDS - 1u);
+
+        write_byte(SYNC_0);
+        write_byte(SYNC_1);
+        write_byte(count);
+        write_byte((u8_t)now);
+        write_byte((u8_t)(now >> 8u));
+
+        for (i = 0u; i < count; i += 1u) {
+            p_rec = &trace_ring__[idx];
+
+            write_byte(p_rec->id);
+            write_byte(p_rec->arg);
+            write_byte((u8_t)p_rec->ts);
+            write_byte((u8_t)(p_rec->ts >> 8u));
+
+            idx = (idx + 1u) & (TRACE_RECORDS - 1u);
+        }
+
+        ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+            trace_count__ -= count;
+
+            if (0u == trace_count__) {
+                trace_paused__ = 0u;
+                drained        = E_TRUE;
+            }
+        }
+    }
+
+    return drained;
+}
+
+static void write_byte(u8_t byte)
+{
+    /* The room for the whole frame was checked before it was started. */
+    (void)bsp_serial_write(byte);
+}
+
+/*
+ * INTERRUPT SERVICE ROUTINES
+ */
+ISR(TIMER0_OVF_vect)
+{
+    trace_ovf__ += 1u;
+}
@@ -0,0 +1,125 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include "types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Trace event identifiers.
+ *
+ * Identifiers from E_TRACE_APP up are free for applications.
+ * scripts/trace_decode.py has the matching names.
+ */
+typedef enum trace_id
+{
+    E_TRACE_UART_RX = 1,    /* arg: received byte                  */
+    E_TRACE_UART_RX_DROP,   /* arg: byte lost to a full RX ring    */
+    E_TRACE_UART_TX,        /* arg: byte moved to the transmitter  */
+    E_TRACE_UART_TX_DROP,   /* arg: byte refused by a full TX ring */
+    E_TRACE_MORSE_STATE,    /* arg: new morse task state           */
+    E_TRACE_ERROR_TRAP,     /* arg: 0                              */
+    E_TRACE_APP = 0x80,
+} TraceId_t;
+
+/*
+ * The trace is compiled in with the BSP_TRACE CMake option. Without it the
+ * hooks below compile to nothing.
+ */
+#if defined(BSP_TRACE)
+
+#include <util/atomic.h>
+
+#include "bsp/private/processor/reg_io.h"
+
+#define TRACE_RECORDS   (64u)   /* must be a power of 2 */
+
+/**
+ * @brief A trace record.
+ *
+ * The timestamp counts the 64 usec ticks of the free running TIM0 and wraps
+ * every 4.2 seconds.
+ */
+typedef struct trace_record
+{
+    u8_t  id;
+    u8_t  arg;
+    u16_t ts;
+} TraceRecord_t;
+
+/* Trace state shared with the inline recorder. Not for direct use. */
+extern TraceRecord_t trace_ring__[TRACE_RECORDS];
+extern u8_t          trace_head__;
+extern u8_t          trace_count__;
+extern u8_t          trace_paused__;
+extern volatile u8_t trace_ovf__;
+
+void trace_init(void);
+bool_t trace_drain(void);
+
+/**
+ * @brief Current 16-bit trace timestamp. Call with interrupts disabled.
+ */
+static inline u16_t trace_timestamp__(void)
+{
+    u8_t ticks;
+    u8_t ovf;
+
+    ticks = TIM0->TCNT;
+    ovf   = trace_ovf__;
+
+    /* An overflow that is pending (interrupts are off) has not been counted
+       yet. */
+    if ((0u != (TIM0_IRQ->TIFR & 0x01u)) && (ticks < 0x80u)) {
+        ovf += 1u;
+    }
+
+    return ((u16_t)ovf << 8u) | ticks;
+}
+
+/**
+ * @brief Record an event.
+ *
+ * Safe from interrupt service routines and the main loop. The newest record
+ * overwrites the oldest once the ring is full, so the ring always holds what
+ * led up to the last event.
+ *
+ * @param[in] id  event identifier
+ * @param[in] arg event argument
+ */
+static inline void trace_record(u8_t id, u8_t arg)
+{
+    TraceRecord_t *p_rec;
+
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+        if (0u == trace_paused__) {
+            p_rec        = &trace_ring__[trace_head__];
+            p_rec->id    = id;
+            p_rec->arg   = arg;
+            p_rec->ts    = trace_timestamp__();
+            trace_head__ = (trace_head__ + 1u) & (TRACE_RECORDS - 1u);
+
+            if (trace_count__ < TRACE_RECORDS) {
+                trace_count__ += 1u;
+            }
+        }
+    }
+}
+
+#define TRACE(id, arg)  trace_record((u8_t)(id), (u8_t)(arg))
+
+#else
+
+#define trace_init()
+#define trace_drain()   (E_TRUE)
+#define TRACE(id, arg)
+
+#endif /* BSP_TRACE */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* TRACE_H */
@@ -11,7 +11,7 @@
 /**
  * @brief Morse code alphabet lookup table
  */
-const MorseChar_t MORSE_ALPHA_TABLE[26] = {
+const MorseChar_t MORSE_ALPHA_TABLE[26] PROGMEM = {
     [A_2_IDX('A')] = { .symbol = {DOT,  DASH}             },
     [A_2_IDX('B')] = { .symbol = {DASH, DOT,  DOT,  DOT}  },
     [A_2_IDX('C')] = { .symbol = {DASH, DOT,  DASH, DOT}  },
@@ -43,7 +43,7 @@ const MorseChar_t MORSE_ALPHA_TABLE[26] = {
 /**
  * @brief Morse code arabic number lookup table
  */
-const MorseChar_t MORSE_NUMERIC_TABLE[10] = {
+const MorseChar_t MORSE_NUMERIC_TABLE[10] PROGMEM = {
     [N_2_IDX('0')] = { .symbol = {DASH, DASH, DASH, DASH, DASH} },
     [N_2_IDX('1')] = { .symbol = {DOT,  DASH, DASH, DASH, DASH} },
     [N_2_IDX('2')] = { .symbol = {DOT,  DOT,  DASH, DASH, DASH} },
@@ -1,6 +1,8 @@
 #ifndef MORSE_PRIVATE_ALPHABET_H
 #define MORSE_PRIVATE_ALPHABET_H
 
+#include <avr/pgmspace.h>
+
 #include "types.h"
 
 #ifdef __cplusplus
@@ -53,11 +55,13 @@ typedef struct morse_character
     u8_t symbol[11];
 } MorseChar_t;
 
-/* The alphabet of morse code characters. Use ALPHA_CHAR_TO_IDX for access. */
-extern const MorseChar_t MORSE_ALPHA_TABLE[26];
+/* The alphabet of morse code characters. Use ALPHA_CHAR_TO_IDX for access.
+   The table is in flash, read the symbols with pgm_read_byte. */
+extern const MorseChar_t MORSE_ALPHA_TABLE[26] PROGMEM;
 
-/* 0 - 9 of morse code characters. Use NUM_CHAR_TO_IDX for access. */
-extern const MorseChar_t MORSE_NUMERIC_TABLE[10];
+/* 0 - 9 of morse code characters. Use NUM_CHAR_TO_IDX for access. The table
+   is in flash, read the symbols with pgm_read_byte. */
+extern const MorseChar_t MORSE_NUMERIC_TABLE[10] PROGMEM;
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,106 @@
+#include "morse/private/parse.h"
+
+#include "utils/ascii_char.h"
+#include "types.h"
+
+#include "morse/private/alphabet.h"
+#include "morse/private/timings.h"
+
+/**
+ * @brief Parse a C-style string into morse code LED flash wait times.
+ *
+ * @param[out] p_waits wait time buffer of MORSE_MAX_WAIT_TIMES entries
+ * @param[in] c_str C-style string to parse
+ */
+void morse_cstr_to_waits(u8_t *p_waits, const char * const c_str)
+{
+    /*
+     * NOTE: This function does no error checking. It is the caller's
+     *       responsibility to ensure the output will fit in the buffer
+     *       pointed to by p_waits.
+     */
+
+    size_t       idx;       /* index into the waits array                */
+    const char  *curr_char; /* pointer to the current C string character */
+    const char  *next_char; /* pointer to the current C string character */
+
+    curr_char = c_str;
+    next_char = curr_char + 1;
+    idx       = 0;
+    while (*curr_char != '\0') {
+
+        if (E_TRUE == ascii_char_is_alphanum(*curr_char)) {
+            idx += morse_pack_alphanum(*curr_char, &p_waits[idx]);
+
+            /* If the next character is another alphanumeric add the inter
+               character gap. */
+            if ('\0' != *next_char && E_TRUE == ascii_char_is_alphanum(*next_char)) {
+                p_waits[idx] = MORSE_TIMING_CHAR_GAP;
+                idx += 1;
+            }
+        } else if (E_TRUE == ascii_char_is_whitespace(*curr_char)) {
+            p_waits[idx] = MORSE_TIMING_WORD_GAP;
+            idx += 1;
+        } else if (E_TRUE == ascii_char_is_terminal_punctuation(*curr_char)) {
+            p_waits[idx] = MORSE_TIMING_SENTENCE_GAP;
+            idx += 1;
+        } else {
+            /* Ignore all other characters (e.g. comma, carriage return, non-
+               printables, etc.) */
+        }
+
+        curr_char += 1;
+        next_char += 1;
+    }
+}
+
+/**
+ * @brief Pack morse code alphanumeric character wait times into a buffer of
+ * wait times.
+ *
+ * @param[in] c character to parse
+ * @param[out] out_times pointer to buffer holding morse code timings.
+ *
+ * @return number of timing values added to output buffer
+ */
+size_t morse_pack_alphanum(char c, u8_t* out_times)
+{
+    size_t             sym_idx;       /* symbol time loop counter  */
+    size_t             time_idx;      /* out time loop counter     */
+    const MorseChar_t *p_morse_char;  /* converted Morse character */
+    u8_t               symbol;        /* current symbol time       */
+
+    if (E_TRUE == ascii_char_is_alpha(c)) {
+        p_morse_char = &MORSE_ALPHA_TABLE[ALPHA_CHAR_TO_IDX(c)];
+    } else if (E_TRUE == ascii_char_is_numeric(c)) {
+        p_morse_char = &MORSE_NUMERIC_TABLE[NUM_CHAR_TO_IDX(c)];
+    } else {
+        p_morse_char = NULL_PTR;
+    }
+
+    /* The tables are in flash. Each symbol is read once; the look ahead for
+       the gap is the next symbol. */
+    sym_idx  = 0;
+    time_idx = 0;
+    symbol   = MORSE_CHAR_TERMINATOR;
+    if (NULL_PTR != p_morse_char) {
+        symbol = pgm_read_byte(&p_morse_char->symbol[0]);
+    }
+
+    while (MORSE_CHAR_TERMINATOR != symbol) {
+        out_times[time_idx] = symbol;
+        time_idx += 1;
+
+        symbol = pgm_read_byte(&p_morse_char->symbol[sym_idx + 1]);
+
+        /* Only put an inter-symbol gap if there is a next symbol */
+        if (MORSE_CHAR_TERMINATOR != symbol) {
+            out_times[time_idx] = MORSE_TIMING_SYM_GAP;
+            time_idx += 1;
+        }
+
+        sym_idx += 1;
+    }
+
+    return time_idx;
+}
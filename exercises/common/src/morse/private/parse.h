@@ -0,0 +1,28 @@
+#ifndef MORSE_PRIVATE_PARSE_H
+#define MORSE_PRIVATE_PARSE_H
+
+#include "types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define MORSE_MAX_C_STR_LEN     (40)    /* handle strings of up to 40 chars */
+
+/* In the worst case, a C string of all characters that have 5 symbols could be
+   passed. For characters with 5 symbols, there will be 4 inter-symbol gaps plus
+   a letter, word, or sentence gap.
+
+   10 = 5 symbols + 4 inter-symbol gaps + 1  */
+#define MORSE_MAX_WAIT_TIMES    (MORSE_MAX_C_STR_LEN * 10)
+
+/* String parser of the morse task. Private to the morse library, exposed for
+   the host benchmarks. */
+void morse_cstr_to_waits(u8_t *p_waits, const char * const c_str);
+size_t morse_pack_alphanum(char c, u8_t *out_times);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* MORSE_PRIVATE_PARSE_H */
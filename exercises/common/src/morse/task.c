@@ -1,20 +1,10 @@
 #include "morse/task.h"
 
 #include "bsp/bsp.h"
-#include "utils/ascii_char.h"
+#include "bsp/trace.h"
 #include "types.h"
 
-#include "morse/private/alphabet.h"
-#include "morse/private/timings.h"
-
-#define MAX_C_STR_LEN   (40)    /* handle strings of up to 40 chars */
-
-/* In the worst case, a C string of all characters that have 5 symbols could be
-   passed. For characters with 5 symbols, there will be 4 inter-symbol gaps plus
-   a letter, word, or sentence gap.
-
-   10 = 5 symbols + 4 inter-symbol gaps + 1  */
-#define MAX_WAIT_TIMES (MAX_C_STR_LEN * 10)
+#include "morse/private/parse.h"
 
 /* The wait time buffer terminator value. When the processing loop hits this
    value, it knows that it has fully iterated through the wait time buffer */
@@ -42,17 +32,15 @@ typedef enum morse_states
  */
 typedef struct module_context
 {
-    bool_t repeat;                  /* do or don't repeat encoded message */
-    u8_t   waits[MAX_WAIT_TIMES];   /* message as morse code wait times   */
-    size_t waits_idx;               /* index into wait times array        */
-    u8_t   ticks_left;              /* ticks left until index increments  */
+    bool_t repeat;                      /* do or don't repeat encoded message */
+    u8_t   waits[MORSE_MAX_WAIT_TIMES]; /* message as morse code wait times   */
+    size_t waits_idx;                   /* index into wait times array        */
+    u8_t   ticks_left;                  /* ticks left until index increments  */
 } Context_t;
 
 static State_t curr_state;
 static Context_t ctx;
 
-static void cstr_to_waits(Context_t *p_ctx, const char * const c_str);
-static size_t pack_alphanum(char c, u8_t* wait_times);
 static void reset_counters(Context_t *p_ctx);
 static void reset_waits(Context_t *p_ctx);
 static State_t idle_state(const Context_t *p_ctx);
@@ -75,6 +63,10 @@ void morse_task_init(void)
  */
 void morse_task(void)
 {
+    State_t prev_state;
+
+    prev_state = curr_state;
+
     switch (curr_state)
     {
         case E_STATE_IDLE:
@@ -89,6 +81,10 @@ void morse_task(void)
             curr_state = E_STATE_IDLE;
             break;
     }
+
+    if (prev_state != curr_state) {
+        TRACE(E_TRACE_MORSE_STATE, curr_state);
+    }
 }
 
 /**
@@ -105,11 +101,12 @@ void morse_task_encode(const char * c_str_msg, bool_t repeat)
     reset_waits(&ctx);
 
     /* Convert the message string into wait times. */
-    cstr_to_waits(&ctx, c_str_msg);
+    morse_cstr_to_waits(ctx.waits, c_str_msg);
     ctx.repeat = repeat;
 
     /* Begin conversion */
     curr_state = E_STATE_ENCODE;
+    TRACE(E_TRACE_MORSE_STATE, curr_state);
 }
 
 /**
@@ -203,7 +200,7 @@ static State_t encode_state(Context_t *p_ctx)
            within the wait time array), set the ticks left and move the index
            for the next time.
            */
-        if (p_ctx->waits_idx >= MAX_WAIT_TIMES || 0 == p_ctx->waits[p_ctx->waits_idx]) {
+        if (p_ctx->waits_idx >= MORSE_MAX_WAIT_TIMES || 0 == p_ctx->waits[p_ctx->waits_idx]) {
             bsp_set_builtin_led(E_OFF);
             reset_counters(p_ctx);
 
@@ -220,95 +217,6 @@ static State_t encode_state(Context_t *p_ctx)
     return next_state;
 }
 
-/**
- * @brief Parse a C-style string into morse code LED flash wait times.
- *
- * @param[inout] p_ctx pointer a module context structure
- * @param[in] c_str C-style string to parse
- */
-static void cstr_to_waits(Context_t *p_ctx, const char * const c_str)
-{
-    /*
-     * NOTE: This function does no error checking. It is the caller's
-     *       responsibility to ensure the output will fit in the buffer
-     *       pointed to by the context's wait array.
-     */
-
-    size_t       idx;       /* index into the waits array                */
-    const char  *curr_char; /* pointer to the current C string character */
-    const char  *next_char; /* pointer to the current C string character */
-
-    curr_char = c_str;
-    next_char = curr_char + 1;
-    idx       = 0;
-    while (*curr_char != '\0') {
-
-        if (E_TRUE == ascii_char_is_alphanum(*curr_char)) {
-            idx += pack_alphanum(*curr_char, &p_ctx->waits[idx]);
-
-            /* If the next character is another alphanumeric add the inter
-               character gap. */
-            if ('\0' != *next_char && E_TRUE == ascii_char_is_alphanum(*next_char)) {
-                p_ctx->waits[idx] = MORSE_TIMING_CHAR_GAP;
-                idx += 1;
-            }
-        } else if (E_TRUE == ascii_char_is_whitespace(*curr_char)) {
-            p_ctx->waits[idx] = MORSE_TIMING_WORD_GAP;
-            idx += 1;
-        } else if (E_TRUE == ascii_char_is_terminal_punctuation(*curr_char)) {
-            p_ctx->waits[idx] = MORSE_TIMING_SENTENCE_GAP;
-            idx += 1;
-        } else {
-            /* Ignore all other characters (e.g. comma, carriage return, non-
-               printables, etc.) */
-        }
-
-        curr_char += 1;
-        next_char += 1;
-    }
-}
-
-/**
- * @brief Pack morse code alphanumeric character wait times into a buffer of
- * wait times.
- *
- * @param[in] c character to parse
- * @param[out] out_times pointer to buffer holding morse code timings.
- *
- * @return number of timing values added to output buffer
- */
-static size_t pack_alphanum(char c, u8_t* out_times)
-{
-    size_t             sym_idx;       /* symbol time loop counter  */
-    size_t             time_idx;      /* out time loop counter     */
-    const MorseChar_t *p_morse_char;  /* converted Morse character */
-
-    if (E_TRUE == ascii_char_is_alpha(c)) {
-        p_morse_char = &MORSE_ALPHA_TABLE[ALPHA_CHAR_TO_IDX(c)];
-    } else if (E_TRUE == ascii_char_is_numeric(c)) {
-        p_morse_char = &MORSE_NUMERIC_TABLE[NUM_CHAR_TO_IDX(c)];
-    } else {
-        p_morse_char = NULL_PTR;
-    }
-
-    sym_idx  = 0;
-    time_idx = 0;
-    while (NULL_PTR != p_morse_char && MORSE_CHAR_TERMINATOR != p_morse_char->symbol[sym_idx]) {
-        out_times[time_idx] = p_morse_char->symbol[sym_idx];
-        time_idx += 1;
-
-        /* Only put an inter-symbol gap if there is a next symbol */
-        if (MORSE_CHAR_TERMINATOR != p_morse_char->symbol[sym_idx + 1]) {
-            out_times[time_idx] = MORSE_TIMING_SYM_GAP;
-            time_idx += 1;
-        }
-
-        sym_idx += 1;
-    }
-
-    return time_idx;
-}
-
 /**
  * @brief Reset morse code context counters
  *
@@ -334,7 +242,7 @@ void reset_waits(Context_t *p_ctx)
     size_t i;   /* loop counter */
 
     /* Initialize wait time buffer. */
-    for (i = 0; i < MAX_WAIT_TIMES; i += 1) {
+    for (i = 0; i < MORSE_MAX_WAIT_TIMES; i += 1) {
         p_ctx->waits[i] = 0;
     }
 }
\ No newline at end of file
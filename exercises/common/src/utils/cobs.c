@@ -0,0 +1,193 @@
+#include "utils/cobs.h"
+
+#include "types.h"
+
+static size_t run_length(const u8_t *p_src, size_t len, const u8_t *p_tail, size_t tail_len,
+                         size_t start);
+static void put_run(const u8_t *p_src, size_t len, const u8_t *p_tail,
+                    size_t start, size_t run, CobsPut_t put, void *p_ctx);
+static void append(CobsDecoder_t *p_dec, u8_t byte);
+
+/**
+ * @brief COBS encode a message into a sink.
+ *
+ * The message is the source followed by an optional tail (e.g. a CRC), which
+ * saves the caller from copying both into one buffer. The delimiter is not
+ * part of the output.
+ *
+ * @param[in] p_src    message bytes
+ * @param[in] len      number of message bytes
+ * @param[in] p_tail   bytes encoded after the message (NULL_PTR for none)
+ * @param[in] tail_len number of tail bytes
+ * @param[in] put      output sink
+ * @param[in] p_ctx    context passed to the sink
+ *
+ * @return The number of encoded bytes (at most COBS_ENCODED_MAX of the total).
+ */
+size_t cobs_encode(const u8_t *p_src, size_t len, const u8_t *p_tail, size_t tail_len,
+                   CobsPut_t put, void *p_ctx)
+{
+    size_t total;
+    size_t start;
+    size_t run;
+    size_t count;
+    u8_t   code;
+    bool_t more;
+
+    total = len + tail_len;
+    start = 0u;
+    count = 0u;
+    more  = E_TRUE;
+
+    while (E_TRUE == more) {
+        run  = run_length(p_src, len, p_tail, tail_len, start);
+        code = (u8_t)(run + 1u);
+
+        put(p_ctx, &code, 1u);
+        put_run(p_src, len, p_tail, start, run, put, p_ctx);
+
+        count += run + 1u;
+        start += run;
+
+        if (total <= start) {
+            more = E_FALSE;
+        } else if (COBS_RUN_MAX > run) {
+            /* The zero that ended the block is the code byte's to imply. A
+               message that ends in a zero gets an empty last block. */
+            start += 1u;
+        }
+    }
+
+    return count;
+}
+
+/**
+ * @brief Start a decoder on an empty buffer.
+ *
+ * Call it again after E_COBS_FRAME to decode the next frame into another
+ * buffer.
+ *
+ * @param[out] p_dec decoder
+ * @param[in]  p_buf buffer of the decoded frame
+ * @param[in]  size  size of the buffer
+ */
+void cobs_decoder_init(CobsDecoder_t *p_dec, u8_t *p_buf, size_t size)
+{
+    p_dec->p_buf = p_buf;
+    p_dec->size  = size;
+    p_dec->len   = 0u;
+    p_dec->code  = 0u;
+    p_dec->left  = 0u;
+    p_dec->error = E_FALSE;
+}
+
+/**
+ * @brief Feed a received byte to the decoder.
+ *
+ * After E_COBS_FRAME the frame is p_dec->len bytes at p_dec->p_buf. Any
+ * delimiter resynchronizes the decoder, so a frame lost in the middle costs
+ * only that frame.
+ *
+ * @param[inout] p_dec decoder
+ * @param[in]    byte  received byte
+ *
+ * @return E_COBS_FRAME at the delimiter of a good frame, E_COBS_ERROR at the
+ * delimiter of a bad one, and E_COBS_MORE otherwise.
+ */
+CobsStatus_t cobs_decode(CobsDecoder_t *p_dec, u8_t byte)
+{
+    CobsStatus_t status;
+
+    status = E_COBS_MORE;
+
+    if (COBS_DELIMITER == byte) {
+        if ((E_TRUE == p_dec->error) || (0u != p_dec->left)) {
+            status = E_COBS_ERROR;
+        } else if (0u != p_dec->code) {
+            status = E_COBS_FRAME;
+        } else {
+            /* back to back delimiters */
+        }
+
+        p_dec->code  = 0u;
+        p_dec->left  = 0u;
+        p_dec->error = E_FALSE;
+    } else if (0u == p_dec->left) {
+        if (0u == p_dec->code) {
+            /* First code byte of a frame */
+            p_dec->len = 0u;
+        } else if (0xFFu != p_dec->code) {
+            /* The previous block ended in an implied zero. */
+            append(p_dec, COBS_DELIMITER);
+        } else {
+            /* a full block has no zero */
+        }
+
+        p_dec->code = byte;
+        p_dec->left = (u8_t)(byte - 1u);
+    } else {
+        append(p_dec, byte);
+        p_dec->left -= 1u;
+    }
+
+    return status;
+}
+
+/**
+ * @brief Count the non-zero bytes from start (at most COBS_RUN_MAX).
+ */
+static size_t run_length(const u8_t *p_src, size_t len, const u8_t *p_tail, size_t tail_len,
+                         size_t start)
+{
+    size_t i;
+    size_t run;
+    u8_t   byte;
+
+    run = 0u;
+
+    for (i = start; (i < (len + tail_len)) && (COBS_RUN_MAX > run); i += 1u) {
+        byte = (i < len) ? p_src[i] : p_tail[i - len];
+        if (COBS_DELIMITER == byte) {
+            break;
+        }
+
+        run += 1u;
+    }
+
+    return run;
+}
+
+/**
+ * @brief Hand a run to the sink, in two parts if it crosses into the tail.
+ */
+static void put_run(const u8_t *p_src, size_t len, const u8_t *p_tail,
+                    size_t start, size_t run, CobsPut_t put, void *p_ctx)
+{
+    size_t head;
+
+    head = 0u;
+    if (start < len) {
+        head = len - start;
+        if (run < head) {
+            head = run;
+        }
+
+        if (0u != head) {
+            put(p_ctx, &p_src[start], head);
+        }
+    }
+
+    if (head < run) {
+        put(p_ctx, &p_tail[(start + head) - len], run - head);
+    }
+}
+
+static void append(CobsDecoder_t *p_dec, u8_t byte)
+{
+    if (p_dec->len < p_dec->size) {
+        p_dec->p_buf[p_dec->len] = byte;
+        p_dec->len += 1u;
+    } else {
+        p_dec->error = E_TRUE;
+    }
+}
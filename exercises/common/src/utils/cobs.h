@@ -0,0 +1,74 @@
+#ifndef COBS_H
+#define COBS_H
+
+#include "types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Consistent Overhead Byte Stuffing.
+ *
+ * COBS removes every 0x00 from a message, so 0x00 can delimit the frames on
+ * the wire. The message is split into blocks at its zeros and each block is
+ * led by a code byte: the distance to the next zero (a block without one has
+ * 254 bytes and code 0xFF). The overhead is 1 byte per 254 at most.
+ *
+ * The encoder hands its output to a sink in runs straight from the message,
+ * so the message is not copied. The decoder takes one byte at a time, which
+ * suits a receive interrupt.
+ */
+
+/* Frame delimiter on the wire */
+#define COBS_DELIMITER      (0x00u)
+
+/* Longest run of non-zero bytes in a block */
+#define COBS_RUN_MAX        (254u)
+
+/* Longest encoding of len message bytes (without the delimiter) */
+#define COBS_ENCODED_MAX(len)   ((len) + ((len) / COBS_RUN_MAX) + 1u)
+
+/**
+ * @brief Output sink of the encoder.
+ *
+ * @param[in] p_ctx  caller context given to cobs_encode
+ * @param[in] p_data next encoded bytes
+ * @param[in] len    number of bytes
+ */
+typedef void (*CobsPut_t)(void *p_ctx, const u8_t *p_data, size_t len);
+
+/**
+ * @brief Result of feeding a byte to the decoder.
+ */
+typedef enum cobs_status
+{
+    E_COBS_MORE = 0,    /* inside a frame, or an empty frame ended      */
+    E_COBS_FRAME,       /* a frame ended, its bytes are in the buffer   */
+    E_COBS_ERROR,       /* a frame ended that was malformed or too long */
+} CobsStatus_t;
+
+/**
+ * @brief Incremental decoder state.
+ */
+typedef struct cobs_decoder
+{
+    u8_t  *p_buf;   /* decoded bytes                                */
+    size_t size;    /* size of the buffer                           */
+    size_t len;     /* decoded length (the frame's after E_COBS_FRAME) */
+    u8_t   code;    /* code byte of the block (0: at a frame start) */
+    u8_t   left;    /* bytes left in the block                      */
+    bool_t error;   /* the frame is dropped at its delimiter        */
+} CobsDecoder_t;
+
+size_t cobs_encode(const u8_t *p_src, size_t len, const u8_t *p_tail, size_t tail_len,
+                   CobsPut_t put, void *p_ctx);
+
+void cobs_decoder_init(CobsDecoder_t *p_dec, u8_t *p_buf, size_t size);
+CobsStatus_t cobs_decode(CobsDecoder_t *p_dec, u8_t byte);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* COBS_H */
@@ -0,0 +1,33 @@
+#ifndef CRC16_H
+#define CRC16_H
+
+#include "types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * CRC-16/CCITT-FALSE (polynomial 0x1021, initial value 0xFFFF, no reflection,
+ * no final XOR).
+ *
+ * A CRC appended most significant byte first makes the CRC of the whole
+ * message 0, so a receiver can run the CRC over the message and its CRC and
+ * check for 0.
+ *
+ * The table driven version reads a 512 byte table from flash. Building with
+ * CRC16_BITWISE (the MinSizeRel default) computes the CRC bit by bit instead,
+ * which is about 8 times slower but needs no table.
+ */
+
+/* CRC value to start a message with */
+#define CRC16_INIT      (0xFFFFu)
+
+u16_t crc16_update(u16_t crc, u8_t byte);
+u16_t crc16(u16_t crc, const u8_t *p_data, size_t len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CRC16_H */
@@ -0,0 +1,67 @@
+#include "utils/exec_stats.h"
+
+#include "types.h"
+
+#define MAX_COUNT   (0xFFFFu)
+
+/**
+ * @brief Clear the statistics.
+ *
+ * @param[out] p_stats statistics to clear
+ */
+void exec_stats_reset(ExecStats_t * const p_stats)
+{
+    p_stats->min   = 0xFFFFu;
+    p_stats->max   = 0u;
+    p_stats->sum   = 0u;
+    p_stats->count = 0u;
+}
+
+/**
+ * @brief Add one execution time to the statistics.
+ *
+ * The average is kept over the most recent executions. Once the count would
+ * overflow, the sum and count are halved so the older executions weigh less.
+ * The minimum and maximum cover every execution since the last reset.
+ *
+ * @param[inout] p_stats statistics to update
+ * @param[in]    time    execution time to add
+ */
+void exec_stats_add(ExecStats_t * const p_stats, u16_t time)
+{
+    if (time < p_stats->min) {
+        p_stats->min = time;
+    }
+
+    if (time > p_stats->max) {
+        p_stats->max = time;
+    }
+
+    if (MAX_COUNT == p_stats->count) {
+        p_stats->sum   /= 2u;
+        p_stats->count /= 2u;
+    }
+
+    /* 65535 times of at most 65535 still fit the 32-bit sum. */
+    p_stats->sum   += time;
+    p_stats->count += 1u;
+}
+
+/**
+ * @brief Average execution time.
+ *
+ * @param[in] p_stats statistics to read
+ *
+ * @return average time (0 when nothing has been added)
+ */
+u16_t exec_stats_avg(const ExecStats_t * const p_stats)
+{
+    u16_t avg;
+
+    avg = 0u;
+    if (0u != p_stats->count) {
+        avg = (u16_t)(p_stats->sum / p_stats->count);
+    }
+
+    return avg;
+}
@@ -0,0 +1,31 @@
+#ifndef EXEC_STATS_H
+#define EXEC_STATS_H
+
+#include "types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Execution time statistics of a piece of code.
+ *
+ * Times are in whatever unit the caller measures (e.g. BSP timer ticks).
+ */
+typedef struct exec_stats
+{
+    u16_t min;      /* shortest execution time */
+    u16_t max;      /* longest execution time  */
+    u32_t sum;      /* sum of count times      */
+    u16_t count;    /* number of executions    */
+} ExecStats_t;
+
+void exec_stats_reset(ExecStats_t * const p_stats);
+void exec_stats_add(ExecStats_t * const p_stats, u16_t time);
+u16_t exec_stats_avg(const ExecStats_t * const p_stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* EXEC_STATS_H */
@@ -0,0 +1,412 @@
+#include "utils/format.h"
+
+#include <avr/pgmspace.h>
+
+#include "types.h"
+
+/* Digits of the longest numbers (4294967295 and ffffffff) */
+#define DEC_DIGITS_MAX  (10u)
+#define HEX_DIGITS_MAX  (8u)
+
+/**
+ * @brief Powers of ten for the decimal conversion.
+ *
+ * A digit is the number of times its power can be subtracted, which is cheaper
+ * than the 32-bit division library call on the AVR.
+ */
+static const u32_t POW10[DEC_DIGITS_MAX] PROGMEM = {
+    1ul,
+    10ul,
+    100ul,
+    1000ul,
+    10000ul,
+    100000ul,
+    1000000ul,
+    10000000ul,
+    100000000ul,
+    1000000000ul,
+};
+
+/**
+ * @brief Sink and character count of one format call.
+ */
+typedef struct format_out
+{
+    FormatPutc_t putc;
+    void        *p_ctx;
+    size_t       count;
+} FormatOut_t;
+
+/**
+ * @brief Conversion arguments of one format call: a va_list, or an array of
+ * 16-bit values (see format_args_P).
+ */
+typedef struct format_args
+{
+    va_list      va;
+    const u16_t *p_array;   /* NULL_PTR: the arguments are in va */
+    u8_t         count;     /* values in p_array                 */
+    u8_t         next;      /* next value of p_array             */
+} FormatArgs_t;
+
+static size_t format_run(FormatOut_t *p_out, const char *p_fmt, FormatArgs_t *p_args);
+static u32_t arg_unsigned(FormatArgs_t *p_args, bool_t is_long);
+static s32_t arg_signed(FormatArgs_t *p_args, bool_t is_long);
+static const char* arg_c_str(FormatArgs_t *p_args);
+static void put(FormatOut_t *p_out, char c);
+static void put_pad(FormatOut_t *p_out, char pad, u8_t width, u8_t len);
+static void put_dec(FormatOut_t *p_out, u32_t num, bool_t negative, char pad, u8_t width);
+static void put_hex(FormatOut_t *p_out, u32_t num, char pad, u8_t width);
+static void put_c_str(FormatOut_t *p_out, const char *c_str, u8_t width);
+
+/**
+ * @brief Format into a putc sink.
+ *
+ * See utils/format.h for the conversions.
+ *
+ * @param[in] putc  output sink
+ * @param[in] p_ctx context passed to the sink
+ * @param[in] p_fmt format string in program memory
+ *
+ * @return The number of characters produced.
+ */
+size_t format_P(FormatPutc_t putc, void *p_ctx, const char *p_fmt, ...)
+{
+    va_list args;
+    size_t  count;
+
+    va_start(args, p_fmt);
+    count = format_va_P(putc, p_ctx, p_fmt, args);
+    va_end(args);
+
+    return count;
+}
+
+/**
+ * @brief Format into a putc sink (va_list version of format_P).
+ *
+ * Unknown conversions are printed as they are.
+ *
+ * @param[in] putc  output sink
+ * @param[in] p_ctx context passed to the sink
+ * @param[in] p_fmt format string in program memory
+ * @param[in] args  conversion arguments
+ *
+ * @return The number of characters produced.
+ */
+size_t format_va_P(FormatPutc_t putc, void *p_ctx, const char *p_fmt, va_list args)
+{
+    FormatOut_t  out;
+    FormatArgs_t fargs;
+    size_t       count;
+
+    out.putc      = putc;
+    out.p_ctx     = p_ctx;
+    out.count     = 0u;
+    fargs.p_array = NULL_PTR;
+    fargs.count   = 0u;
+    fargs.next    = 0u;
+
+    va_copy(fargs.va, args);
+    count = format_run(&out, p_fmt, &fargs);
+    va_end(fargs.va);
+
+    return count;
+}
+
+/**
+ * @brief Format into a putc sink with the arguments in an array.
+ *
+ * Every argument is a 16-bit value: %d takes it as signed, %l is ignored, and
+ * %s prints nothing since the value cannot hold a pointer on every target. A
+ * missing argument is 0. This is the form the text path of LOG (bsp/log.h)
+ * passes its arguments in.
+ *
+ * @param[in] putc    output sink
+ * @param[in] p_ctx   context passed to the sink
+ * @param[in] p_fmt   format string in program memory
+ * @param[in] p_array arguments (NULL_PTR when there are none)
+ * @param[in] count   number of arguments
+ *
+ * @return The number of characters produced.
+ */
+size_t format_args_P(FormatPutc_t putc, void *p_ctx, const char *p_fmt,
+                     const u16_t *p_array, u8_t count)
+{
+    static const u16_t NO_ARGS[1] = { 0u };
+
+    FormatOut_t  out;
+    FormatArgs_t fargs;
+
+    out.putc      = putc;
+    out.p_ctx     = p_ctx;
+    out.count     = 0u;
+    fargs.p_array = (NULL_PTR != p_array) ? p_array : NO_ARGS;
+    fargs.count   = (NULL_PTR != p_array) ? count : 0u;
+    fargs.next    = 0u;
+
+    return format_run(&out, p_fmt, &fargs);
+}
+
+/**
+ * @brief Format engine shared by the format functions.
+ *
+ * @param[in] p_out  output sink and count
+ * @param[in] p_fmt  format string in program memory
+ * @param[in] p_args conversion arguments
+ *
+ * @return The number of characters produced.
+ */
+static size_t format_run(FormatOut_t *p_out, const char *p_fmt, FormatArgs_t *p_args)
+{
+    const char *p_c;
+    char        c;
+    char        pad;
+    u8_t        width;
+    bool_t      is_long;
+    s32_t       snum;
+
+    p_c = p_fmt;
+    c   = (char)pgm_read_byte(p_c);
+
+    while ('\0' != c) {
+        p_c += 1;
+
+        if ('%' != c) {
+            put(p_out, c);
+        } else {
+            pad     = ' ';
+            width   = 0u;
+            is_long = E_FALSE;
+            c       = (char)pgm_read_byte(p_c);
+
+            if ('0' == c) {
+                pad  = '0';
+                p_c += 1;
+                c    = (char)pgm_read_byte(p_c);
+            }
+
+            while (('0' <= c) && ('9' >= c)) {
+                width = (u8_t)((width * 10u) + (u8_t)(c - '0'));
+                p_c  += 1;
+                c     = (char)pgm_read_byte(p_c);
+            }
+
+            if ('l' == c) {
+                is_long = E_TRUE;
+                p_c    += 1;
+                c       = (char)pgm_read_byte(p_c);
+            }
+
+            /* The conversion character (a '%' at the very end has none) */
+            if ('\0' != c) {
+                p_c += 1;
+            }
+
+            switch (c)
+            {
+                case 'u':
+                    put_dec(p_out, arg_unsigned(p_args, is_long), E_FALSE, pad, width);
+                    break;
+
+                case 'd':
+                    snum = arg_signed(p_args, is_long);
+                    if (snum < 0) {
+                        put_dec(p_out, (u32_t)0u - (u32_t)snum, E_TRUE, pad, width);
+                    } else {
+                        put_dec(p_out, (u32_t)snum, E_FALSE, pad, width);
+                    }
+                    break;
+
+                case 'x':
+                    put_hex(p_out, arg_unsigned(p_args, is_long), pad, width);
+                    break;
+
+                case 's':
+                    put_c_str(p_out, arg_c_str(p_args), width);
+                    break;
+
+                case 'c':
+                    /* A character of value 0 prints nothing, which lets an
+                       output carry an optional character. */
+                    c = (char)arg_unsigned(p_args, E_FALSE);
+                    if ('\0' != c) {
+                        put(p_out, c);
+                    }
+                    break;
+
+                case '%':
+                    put(p_out, '%');
+                    break;
+
+                case '\0':
+                    put(p_out, '%');
+                    break;
+
+                default:
+                    put(p_out, '%');
+                    put(p_out, c);
+                    break;
+            }
+        }
+
+        c = (char)pgm_read_byte(p_c);
+    }
+
+    return p_out->count;
+}
+
+/**
+ * @brief Take the next argument of %u, %x or %c.
+ */
+static u32_t arg_unsigned(FormatArgs_t *p_args, bool_t is_long)
+{
+    u32_t num;
+
+    num = 0u;
+
+    if (NULL_PTR != p_args->p_array) {
+        if (p_args->next < p_args->count) {
+            num = p_args->p_array[p_args->next];
+        }
+        p_args->next += 1u;
+    } else if (E_TRUE == is_long) {
+        num = (u32_t)va_arg(p_args->va, unsigned long);
+    } else {
+        num = va_arg(p_args->va, unsigned int);
+    }
+
+    return num;
+}
+
+/**
+ * @brief Take the next argument of %d.
+ */
+static s32_t arg_signed(FormatArgs_t *p_args, bool_t is_long)
+{
+    s32_t num;
+
+    if (NULL_PTR != p_args->p_array) {
+        num = (s16_t)arg_unsigned(p_args, E_FALSE);
+    } else if (E_TRUE == is_long) {
+        num = (s32_t)va_arg(p_args->va, long);
+    } else {
+        num = va_arg(p_args->va, int);
+    }
+
+    return num;
+}
+
+/**
+ * @brief Take the next argument of %s.
+ */
+static const char* arg_c_str(FormatArgs_t *p_args)
+{
+    const char *c_str;
+
+    if (NULL_PTR != p_args->p_array) {
+        (void)arg_unsigned(p_args, E_FALSE);
+        c_str = NULL_PTR;
+    } else {
+        c_str = va_arg(p_args->va, const char*);
+    }
+
+    return c_str;
+}
+
+static void put(FormatOut_t *p_out, char c)
+{
+    p_out->putc(p_out->p_ctx, c);
+    p_out->count += 1u;
+}
+
+static void put_pad(FormatOut_t *p_out, char pad, u8_t width, u8_t len)
+{
+    while (len < width) {
+        put(p_out, pad);
+        len += 1u;
+    }
+}
+
+static void put_dec(FormatOut_t *p_out, u32_t num, bool_t negative, char pad, u8_t width)
+{
+    u8_t  len;
+    u8_t  i;
+    u32_t pow;
+    char  digit;
+
+    /* Count the digits first for the padding. */
+    len = 1u;
+    while ((len < DEC_DIGITS_MAX) && (num >= pgm_read_dword(&POW10[len]))) {
+        len += 1u;
+    }
+
+    /* The sign goes before zeros and after spaces. */
+    if (E_TRUE == negative) {
+        if ('0' == pad) {
+            put(p_out, '-');
+        }
+        put_pad(p_out, pad, width, (u8_t)(len + 1u));
+        if ('0' != pad) {
+            put(p_out, '-');
+        }
+    } else {
+        put_pad(p_out, pad, width, len);
+    }
+
+    for (i = (u8_t)(len - 1u); 0u != i; i -= 1u) {
+        pow   = pgm_read_dword(&POW10[i]);
+        digit = '0';
+
+        while (num >= pow) {
+            num   -= pow;
+            digit += 1;
+        }
+
+        put(p_out, digit);
+    }
+
+    put(p_out, (char)('0' + (char)num));
+}
+
+static void put_hex(FormatOut_t *p_out, u32_t num, char pad, u8_t width)
+{
+    u8_t len;
+    u8_t nibble;
+
+    len = 1u;
+    while ((len < HEX_DIGITS_MAX) && (0u != (num >> (4u * len)))) {
+        len += 1u;
+    }
+
+    put_pad(p_out, pad, width, len);
+
+    while (0u != len) {
+        len   -= 1u;
+        nibble = (u8_t)(num >> (4u * len)) & 0x0Fu;
+        if (nibble < 10u) {
+            put(p_out, (char)('0' + nibble));
+        } else {
+            put(p_out, (char)('a' + (nibble - 10u)));
+        }
+    }
+}
+
+static void put_c_str(FormatOut_t *p_out, const char *c_str, u8_t width)
+{
+    const char *p_c;
+    u8_t        len;
+
+    if (NULL_PTR != c_str) {
+        len = 0u;
+        for (p_c = c_str; ('\0' != *p_c) && (len < width); p_c += 1) {
+            len += 1u;
+        }
+
+        put_pad(p_out, ' ', width, len);
+
+        for (p_c = c_str; '\0' != *p_c; p_c += 1) {
+            put(p_out, *p_c);
+        }
+    }
+}
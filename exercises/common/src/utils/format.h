@@ -0,0 +1,49 @@
+#ifndef FORMAT_H
+#define FORMAT_H
+
+#include <stdarg.h>
+
+#include "types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Formatted output (a printf subset).
+ *
+ * The format string is in program memory (PSTR or PROGMEM) and every character
+ * is handed to a putc sink as it is produced, so there is no output buffer.
+ * Conversions:
+ *
+ *     %u   unsigned int            %lu  unsigned long
+ *     %d   int                     %ld  long
+ *     %x   unsigned int in hex     %lx  unsigned long in hex
+ *     %s   C string in RAM         %c   character (0 prints nothing)
+ *     %%   percent sign
+ *
+ * The long conversions print the low 32 bits. u32_t is unsigned long on the
+ * AVR only, so pass (unsigned long) casts where the code also builds on a host.
+ *
+ * A field width right-aligns the conversion with spaces, or with zeros when it
+ * starts with 0 (e.g. %5u, %04x). Numbers are converted without division.
+ */
+
+/**
+ * @brief Output sink of the formatter.
+ *
+ * @param[in] p_ctx caller context given to format_P
+ * @param[in] c     next output character
+ */
+typedef void (*FormatPutc_t)(void *p_ctx, char c);
+
+size_t format_P(FormatPutc_t putc, void *p_ctx, const char *p_fmt, ...);
+size_t format_va_P(FormatPutc_t putc, void *p_ctx, const char *p_fmt, va_list args);
+size_t format_args_P(FormatPutc_t putc, void *p_ctx, const char *p_fmt,
+                     const u16_t *p_array, u8_t count);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* FORMAT_H */
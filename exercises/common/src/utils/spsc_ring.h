@@ -0,0 +1,248 @@
+/**
+ * @file spsc_ring.h
+ * @brief Lock-free single producer, single consumer ring buffer that is meant
+ * to be private to a C module
+ *
+ * The ring is shared by exactly one producer and one consumer, typically an
+ * interrupt handler and the main loop. The producer only writes the head and
+ * the consumer only writes the tail. Both are 8-bit free running counters, so
+ * every index access is a single (atomic) load or store on the AVR and no
+ * critical section is needed. The element index is the counter masked by the
+ * size, and the fill is the counter difference.
+ *
+ * The size is a power of 2 up to 256. A ring holds SIZE elements, except a 256
+ * element ring which holds 255 (a full ring would look empty).
+ *
+ * Usage (one instance per ring type and size):
+ *
+ *   SPSC_RING_DECLARATIONS(ByteRing, u8_t, 64u)
+ *   SPSC_RING_DECLARE(static ByteRing, rx_ring);
+ *
+ *   SPSC_RING_INIT(ByteRing, rx_ring);
+ *   if (E_FALSE == SPSC_RING_PUSH(ByteRing, rx_ring, byte)) { ...full... }
+ *   if (E_TRUE == SPSC_RING_POP(ByteRing, rx_ring, &byte))  { ...byte... }
+ *
+ * SPSC_RING_WRITE and SPSC_RING_READ move as many elements as fit (or are
+ * there) in one pass and publish them with a single head or tail store.
+ *
+ * SPSC_RING_WRITE_POS and SPSC_RING_READ_POS return the head and the tail to
+ * code that tracks places in the stream, e.g. the producer marks where the
+ * next element goes in and the consumer acts once its read position gets
+ * there. The positions are the free running counters and wrap every 256
+ * elements.
+ *
+ * utils/spsc_ring.hpp is the same ring as a C++17 class template.
+ */
+
+#ifndef SPSC_RING_H
+#define SPSC_RING_H
+
+#include "types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Compiler barrier. The element must be in the buffer before the head that
+ * publishes it is stored, and read out before the tail that frees its slot is
+ * stored. The AVR executes in order, so keeping the compiler from moving the
+ * accesses is enough there.
+ */
+#define SPSC_RING_BARRIER()     __asm__ __volatile__ ("" ::: "memory")
+
+/*
+ * Counter accesses across the two sides. The other side's counter is loaded
+ * with acquire and a side's own counter is stored with release. Host builds
+ * may run the sides on two threads (see tests/host), so they use the GCC
+ * atomic builtins, which also order the CPU; the AVR uses plain byte
+ * accesses behind the compiler barrier.
+ */
+#if defined(BSP_HOST)
+
+#define SPSC_RING_LOAD(counter)             __atomic_load_n(&(counter), __ATOMIC_ACQUIRE)
+#define SPSC_RING_STORE(counter, value)     __atomic_store_n(&(counter), (value), __ATOMIC_RELEASE)
+
+#else
+
+static inline u8_t spsc_ring_load__(const volatile u8_t *p_counter)
+{
+    u8_t value;
+
+    value = *p_counter;
+    SPSC_RING_BARRIER();
+
+    return value;
+}
+
+static inline void spsc_ring_store__(volatile u8_t *p_counter, u8_t value)
+{
+    SPSC_RING_BARRIER();
+    *p_counter = value;
+}
+
+#define SPSC_RING_LOAD(counter)             spsc_ring_load__(&(counter))
+#define SPSC_RING_STORE(counter, value)     spsc_ring_store__(&(counter), (value))
+
+#endif /* BSP_HOST */
+
+#define SPSC_RING_CAPACITY(size)    (((size) < 256u) ? (size) : 255u)
+
+#define SPSC_RING_DECLARATIONS(T_RING, T, SIZE)                                         \
+typedef char T_RING ## _size_check[((0u < (SIZE)) && ((SIZE) <= 256u) &&                \
+                                    (0u == ((SIZE) & ((SIZE) - 1u)))) ? 1 : -1];        \
+                                                                                        \
+typedef struct T_RING ## spsc_ring                                                      \
+{                                                                                       \
+    volatile u8_t head;     /* next element to write (producer only) */                 \
+    volatile u8_t tail;     /* next element to read (consumer only)  */                 \
+    T data[SIZE];                                                                       \
+} T_RING ## SpscRing_t;                                                                 \
+                                                                                        \
+static inline void T_RING ## spsc_ring_init(T_RING ## SpscRing_t *p_ring)               \
+{                                                                                       \
+    p_ring->head = 0u;                                                                  \
+    p_ring->tail = 0u;                                                                  \
+}                                                                                       \
+                                                                                        \
+static inline u8_t T_RING ## spsc_ring_count(const T_RING ## SpscRing_t *p_ring)        \
+{                                                                                       \
+    return (u8_t)(SPSC_RING_LOAD(p_ring->head) - SPSC_RING_LOAD(p_ring->tail));         \
+}                                                                                       \
+                                                                                        \
+static inline bool_t T_RING ## spsc_ring_is_empty(const T_RING ## SpscRing_t *p_ring)   \
+{                                                                                       \
+    u8_t count = T_RING ## spsc_ring_count(p_ring);                                     \
+    return (0u == count) ? E_TRUE : E_FALSE;                                            \
+}                                                                                       \
+                                                                                        \
+static inline bool_t T_RING ## spsc_ring_is_full(const T_RING ## SpscRing_t *p_ring)    \
+{                                                                                       \
+    u8_t count = T_RING ## spsc_ring_count(p_ring);                                     \
+    return (SPSC_RING_CAPACITY(SIZE) == count) ? E_TRUE : E_FALSE;                      \
+}                                                                                       \
+                                                                                        \
+static inline u8_t T_RING ## spsc_ring_write_pos(const T_RING ## SpscRing_t *p_ring)    \
+{                                                                                       \
+    return SPSC_RING_LOAD(p_ring->head);                                                \
+}                                                                                       \
+                                                                                        \
+static inline u8_t T_RING ## spsc_ring_read_pos(const T_RING ## SpscRing_t *p_ring)     \
+{                                                                                       \
+    return SPSC_RING_LOAD(p_ring->tail);                                                \
+}                                                                                       \
+                                                                                        \
+static inline bool_t T_RING ## spsc_ring_push(T_RING ## SpscRing_t *p_ring, T d)        \
+{                                                                                       \
+    u8_t   head;                                                                        \
+    bool_t pushed;                                                                      \
+                                                                                        \
+    head = p_ring->head;                                                                \
+    if (SPSC_RING_CAPACITY(SIZE) == (u8_t)(head - SPSC_RING_LOAD(p_ring->tail))) {      \
+        pushed = E_FALSE;                                                               \
+    } else {                                                                            \
+        p_ring->data[head & ((SIZE) - 1u)] = d;                                         \
+        SPSC_RING_STORE(p_ring->head, (u8_t)(head + 1u));                               \
+        pushed = E_TRUE;                                                                \
+    }                                                                                   \
+                                                                                        \
+    return pushed;                                                                      \
+}                                                                                       \
+                                                                                        \
+static inline bool_t T_RING ## spsc_ring_pop(T_RING ## SpscRing_t *p_ring, T *p_d)      \
+{                                                                                       \
+    u8_t   tail;                                                                        \
+    bool_t popped;                                                                      \
+                                                                                        \
+    tail = p_ring->tail;                                                                \
+    if (SPSC_RING_LOAD(p_ring->head) == tail) {                                         \
+        popped = E_FALSE;                                                               \
+    } else {                                                                            \
+        *p_d = p_ring->data[tail & ((SIZE) - 1u)];                                      \
+        SPSC_RING_STORE(p_ring->tail, (u8_t)(tail + 1u));                               \
+        popped = E_TRUE;                                                                \
+    }                                                                                   \
+                                                                                        \
+    return popped;                                                                      \
+}                                                                                       \
+                                                                                        \
+static inline bool_t T_RING ## spsc_ring_peek(const T_RING ## SpscRing_t *p_ring, T *p_d) \
+{                                                                                       \
+    u8_t   tail;                                                                        \
+    bool_t peeked;                                                                      \
+                                                                                        \
+    tail = p_ring->tail;                                                                \
+    if (SPSC_RING_LOAD(p_ring->head) == tail) {                                         \
+        peeked = E_FALSE;                                                               \
+    } else {                                                                            \
+        *p_d = p_ring->data[tail & ((SIZE) - 1u)];                                      \
+        peeked = E_TRUE;                                                                \
+    }                                                                                   \
+                                                                                        \
+    return peeked;                                                                      \
+}                                                                                       \
+                                                                                        \
+static inline size_t T_RING ## spsc_ring_write(T_RING ## SpscRing_t *p_ring,            \
+                                               const T *p_src, size_t len)              \
+{                                                                                       \
+    u8_t head;                                                                          \
+    u8_t space;                                                                         \
+    u8_t i;                                                                             \
+                                                                                        \
+    head  = p_ring->head;                                                               \
+    space = (u8_t)(head - SPSC_RING_LOAD(p_ring->tail));                                \
+    space = (u8_t)(SPSC_RING_CAPACITY(SIZE) - space);                                   \
+    if (len < space) {                                                                  \
+        space = (u8_t)len;                                                              \
+    }                                                                                   \
+                                                                                        \
+    for (i = 0u; i < space; i += 1u) {                                                  \
+        p_ring->data[(u8_t)(head + i) & ((SIZE) - 1u)] = p_src[i];                      \
+    }                                                                                   \
+                                                                                        \
+    SPSC_RING_STORE(p_ring->head, (u8_t)(head + space));                                \
+                                                                                        \
+    return space;                                                                       \
+}                                                                                       \
+                                                                                        \
+static inline size_t T_RING ## spsc_ring_read(T_RING ## SpscRing_t *p_ring,             \
+                                              T *p_dst, size_t len)                     \
+{                                                                                       \
+    u8_t tail;                                                                          \
+    u8_t avail;                                                                         \
+    u8_t i;                                                                             \
+                                                                                        \
+    tail  = p_ring->tail;                                                               \
+    avail = (u8_t)(SPSC_RING_LOAD(p_ring->head) - tail);                                \
+    if (len < avail) {                                                                  \
+        avail = (u8_t)len;                                                              \
+    }                                                                                   \
+                                                                                        \
+    for (i = 0u; i < avail; i += 1u) {                                                  \
+        p_dst[i] = p_ring->data[(u8_t)(tail + i) & ((SIZE) - 1u)];                      \
+    }                                                                                   \
+                                                                                        \
+    SPSC_RING_STORE(p_ring->tail, (u8_t)(tail + avail));                                \
+                                                                                        \
+    return avail;                                                                       \
+}
+
+#define SPSC_RING_DECLARE(T_RING, var_name)            T_RING ## SpscRing_t var_name
+
+#define SPSC_RING_INIT(T_RING, var_name)               T_RING ## spsc_ring_init(&var_name)
+#define SPSC_RING_COUNT(T_RING, var_name)              T_RING ## spsc_ring_count(&var_name)
+#define SPSC_RING_IS_EMPTY(T_RING, var_name)           T_RING ## spsc_ring_is_empty(&var_name)
+#define SPSC_RING_IS_FULL(T_RING, var_name)            T_RING ## spsc_ring_is_full(&var_name)
+#define SPSC_RING_WRITE_POS(T_RING, var_name)          T_RING ## spsc_ring_write_pos(&var_name)
+#define SPSC_RING_READ_POS(T_RING, var_name)           T_RING ## spsc_ring_read_pos(&var_name)
+#define SPSC_RING_PUSH(T_RING, var_name, data)         T_RING ## spsc_ring_push(&var_name, data)
+#define SPSC_RING_POP(T_RING, var_name, p_data)        T_RING ## spsc_ring_pop(&var_name, p_data)
+#define SPSC_RING_PEEK(T_RING, var_name, p_data)       T_RING ## spsc_ring_peek(&var_name, p_data)
+#define SPSC_RING_WRITE(T_RING, var_name, p_src, len)  T_RING ## spsc_ring_write(&var_name, p_src, len)
+#define SPSC_RING_READ(T_RING, var_name, p_dst, len)   T_RING ## spsc_ring_read(&var_name, p_dst, len)
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SPSC_RING_H */
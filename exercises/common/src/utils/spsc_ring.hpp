@@ -0,0 +1,200 @@
+/**
+ * @file spsc_ring.hpp
+ * @brief Lock-free single producer, single consumer ring buffer (C++17)
+ *
+ * The class template version of utils/spsc_ring.h with the same layout and
+ * rules: one producer writes the head, one consumer writes the tail, both are
+ * 8-bit free running counters, and SIZE is a power of 2 up to 256 (a 256
+ * element ring holds 255 elements). The counters go through the same
+SPSC_RING_LOAD/SPSC_RING_STORE accesses, so host builds get acquire/release
+ordering between threads.
+ *
+ *   static SpscRing<u8_t, 64u> rx_ring;
+ *
+ *   if (false == rx_ring.push(byte)) { ...full... }
+ *   if (true == rx_ring.pop(byte))   { ...byte... }
+ */
+
+#ifndef SPSC_RING_HPP
+#define SPSC_RING_HPP
+
+#include "utils/spsc_ring.h"
+
+template <typename T, unsigned int SIZE>
+class SpscRing
+{
+    static_assert((0u < SIZE) && (SIZE <= 256u) && (0u == (SIZE & (SIZE - 1u))),
+                  "SIZE must be a power of 2 up to 256");
+
+public:
+    static constexpr u8_t CAPACITY = SPSC_RING_CAPACITY(SIZE);
+
+    SpscRing() : head(0u), tail(0u), data() {}
+
+    SpscRing(const SpscRing &) = delete;
+    SpscRing &operator=(const SpscRing &) = delete;
+
+    void init()
+    {
+        head = 0u;
+        tail = 0u;
+    }
+
+    u8_t count() const
+    {
+        return static_cast<u8_t>(SPSC_RING_LOAD(head) - SPSC_RING_LOAD(tail));
+    }
+
+    bool is_empty() const
+    {
+        return 0u == count();
+    }
+
+    bool is_full() const
+    {
+        return CAPACITY == count();
+    }
+
+    /**
+     * @brief Position the next element is written at (see SPSC_RING_WRITE_POS).
+     */
+    u8_t write_pos() const
+    {
+        return SPSC_RING_LOAD(head);
+    }
+
+    /**
+     * @brief Position the next element is read from (see SPSC_RING_READ_POS).
+     */
+    u8_t read_pos() const
+    {
+        return SPSC_RING_LOAD(tail);
+    }
+
+    /**
+     * @brief Add an element (producer only).
+     *
+     * @retval true  - the element was added
+     * @retval false - the ring is full
+     */
+    bool push(const T &d)
+    {
+        u8_t h;
+        bool pushed;
+
+        h = head;
+        if (CAPACITY == static_cast<u8_t>(h - SPSC_RING_LOAD(tail))) {
+            pushed = false;
+        } else {
+            data[h & (SIZE - 1u)] = d;
+            SPSC_RING_STORE(head, static_cast<u8_t>(h + 1u));
+            pushed = true;
+        }
+
+        return pushed;
+    }
+
+    /**
+     * @brief Remove the oldest element (consumer only).
+     *
+     * @retval true  - d holds the element
+     * @retval false - the ring is empty
+     */
+    bool pop(T &d)
+    {
+        u8_t t;
+        bool popped;
+
+        t = tail;
+        if (SPSC_RING_LOAD(head) == t) {
+            popped = false;
+        } else {
+            d = data[t & (SIZE - 1u)];
+            SPSC_RING_STORE(tail, static_cast<u8_t>(t + 1u));
+            popped = true;
+        }
+
+        return popped;
+    }
+
+    /**
+     * @brief Read the oldest element without removing it (consumer only).
+     *
+     * @retval true  - d holds the element
+     * @retval false - the ring is empty
+     */
+    bool peek(T &d) const
+    {
+        u8_t t;
+        bool peeked;
+
+        t = tail;
+        if (SPSC_RING_LOAD(head) == t) {
+            peeked = false;
+        } else {
+            d = data[t & (SIZE - 1u)];
+            peeked = true;
+        }
+
+        return peeked;
+    }
+
+    /**
+     * @brief Add up to len elements and publish them at once (producer only).
+     *
+     * @return The number of elements added.
+     */
+    size_t write(const T *p_src, size_t len)
+    {
+        u8_t h;
+        u8_t space;
+        u8_t i;
+
+        h     = head;
+        space = static_cast<u8_t>(CAPACITY - static_cast<u8_t>(h - SPSC_RING_LOAD(tail)));
+        if (len < space) {
+            space = static_cast<u8_t>(len);
+        }
+
+        for (i = 0u; i < space; i += 1u) {
+            data[static_cast<u8_t>(h + i) & (SIZE - 1u)] = p_src[i];
+        }
+
+        SPSC_RING_STORE(head, static_cast<u8_t>(h + space));
+
+        return space;
+    }
+
+    /**
+     * @brief Remove up to len of the oldest elements at once (consumer only).
+     *
+     * @return The number of elements removed.
+     */
+    size_t read(T *p_dst, size_t len)
+    {
+        u8_t t;
+        u8_t avail;
+        u8_t i;
+
+        t     = tail;
+        avail = static_cast<u8_t>(SPSC_RING_LOAD(head) - t);
+        if (len < avail) {
+            avail = static_cast<u8_t>(len);
+        }
+
+        for (i = 0u; i < avail; i += 1u) {
+            p_dst[i] = data[static_cast<u8_t>(t + i) & (SIZE - 1u)];
+        }
+
+        SPSC_RING_STORE(tail, static_cast<u8_t>(t + avail));
+
+        return avail;
+    }
+
+private:
+    volatile u8_t head;     /* next element to write (producer only) */
+    volatile u8_t tail;     /* next element to read (consumer only)  */
+    T             data[SIZE];
+};
+
+#endif /* SPSC_RING_HPP */
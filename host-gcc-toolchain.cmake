@@ -0,0 +1,29 @@
+#
+# Host (native) toolchain
+#
+# Builds the libraries and exercises as native executables against the host BSP
+# backend (exercises/common/src/bsp/private/host). The AVR build is unaffected;
+# it is still selected with avr-gcc-toolchain.cmake.
+#
+set(BSP_HOST ON)
+
+set(CMAKE_C_COMPILER gcc)
+set(CMAKE_CXX_COMPILER g++)
+set(CMAKE_OBJDUMP objdump)
+set(CMAKE_SIZE size)
+
+set(CMAKE_C_FLAGS_DEBUG_INIT "-g3 -Og -DDEBUG")
+set(CMAKE_C_FLAGS_DEBUG "${CMAKE_C_FLAGS_DEBUG_INIT}" CACHE STRING "" FORCE)
+set(CMAKE_C_FLAGS_RELEASE_INIT "-g -O3")
+set(CMAKE_C_FLAGS_RELEASE "${CMAKE_C_FLAGS_RELEASE_INIT}" CACHE STRING "" FORCE)
+set(CMAKE_C_FLAGS_MINSIZEREL_INIT "-g -Os")
+set(CMAKE_C_FLAGS_MINSIZEREL "${CMAKE_C_FLAGS_MINSIZEREL_INIT}" CACHE STRING "" FORCE)
+
+function(generate_artifacts exe_name)
+    add_custom_command(TARGET ${exe_name} POST_BUILD
+        COMMAND
+            ${CMAKE_OBJDUMP} -dCSw $<TARGET_FILE:${exe_name}> > ${exe_name}.lss
+        COMMAND
+            ${CMAKE_SIZE} -A -t $<TARGET_FILE:${exe_name}> > ${exe_name}.size.txt
+    )
+endfunction()
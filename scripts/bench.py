@@ -0,0 +1,289 @@
+#!/usr/bin/env python
+
+""" Micro-benchmark runner
+
+Runs the bench_avr firmware in simavr and collects the cycle counts it reports
+over the UART. Every case is one line:
+
+    BENCH <name> <calls> <cycles|overflow>
+
+and the run ends with BENCH-END. The results are stored as JSON so they can be
+compared against a committed baseline:
+
+    bench.py run --output result.json bench_avr.elf
+    bench.py compare baseline.json result.json
+    bench.py baseline result.json bench/avr/baseline/Release.json
+
+The cycle counts are exact (simavr is cycle accurate for the instructions the
+firmware uses), so any change is a real change. The comparison threshold only
+decides what is worth failing the build over.
+
+The host benchmarks (bench_host, Google Benchmark) are run the same way and
+measure nanoseconds per corpus character. Every host result is also added to a
+history file under the commit it was measured at, so a rewrite of the text
+processing paths can be followed commit by commit:
+
+    bench.py host --output result.json --history history.jsonl bench_host
+    bench.py history history.jsonl
+"""
+
+import argparse
+import json
+import re
+import shutil
+import subprocess
+import sys
+import time
+
+ANSI_ESCAPE = re.compile(r'\x1b\[[0-9;]*m')
+BENCH_LINE  = re.compile(r'BENCH (\S+) (\d+) (\d+|overflow)')
+BENCH_END   = 'BENCH-END'
+
+
+def parse_args():
+    """Parse the command line into a subcommand namespace."""
+    parser = argparse.ArgumentParser(
+        description='Run and compare the simavr and host micro-benchmarks.',
+    )
+    sub = parser.add_subparsers(dest='command', required=True)
+
+    run = sub.add_parser('run', help='Run the benchmark firmware in simavr.')
+    run.add_argument('--simavr', default='simavr',
+        help='simavr executable (default: simavr).')
+    run.add_argument('--mcu', default='atmega328p',
+        help='Simulated part (default: atmega328p).')
+    run.add_argument('--freq', type=int, default=16000000,
+        help='Simulated clock in Hz (default: 16000000).')
+    run.add_argument('--timeout', type=float, default=60.0,
+        help='Real seconds before the run is abandoned (default: 60).')
+    run.add_argument('--output', default=None,
+        help='JSON result file (default: stdout).')
+    run.add_argument('elf')
+
+    host = sub.add_parser('host', help='Run the host throughput benchmarks.')
+    host.add_argument('--min-time', type=float, default=0.5,
+        help='Seconds each case runs at least (default: 0.5).')
+    host.add_argument('--output', default=None,
+        help='JSON result file (default: stdout).')
+    host.add_argument('--history', default=None,
+        help='JSON lines file the result is added to under the current commit.')
+    host.add_argument('executable')
+
+    history = sub.add_parser('history', help='Print the host results per commit.')
+    history.add_argument('--last', type=int, default=8,
+        help='Number of commits shown (default: 8).')
+    history.add_argument('history')
+
+    compare = sub.add_parser('compare', help='Compare a result to a baseline.')
+    compare.add_argument('--threshold', type=float, default=2.0,
+        help='Percent increase in cycles (or nsec) per call that fails (default: 2).')
+    compare.add_argument('baseline')
+    compare.add_argument('result')
+
+    baseline = sub.add_parser('baseline', help='Make a result the new baseline.')
+    baseline.add_argument('result')
+    baseline.add_argument('baseline')
+
+    return parser.parse_args()
+
+
+def parse_output(text):
+    """Return {name: {calls, cycles, cycles_per_call}} from the firmware output."""
+    cases = {}
+    finished = False
+
+    for line in ANSI_ESCAPE.sub('', text).splitlines():
+        match = BENCH_LINE.search(line)
+        if match:
+            name, calls, cycles = match.groups()
+            calls = int(calls)
+
+            if cycles == 'overflow':
+                cases[name] = {'calls': calls, 'cycles': None, 'cycles_per_call': None}
+            else:
+                cycles = int(cycles)
+                cases[name] = {
+                    'calls': calls,
+                    'cycles': cycles,
+                    'cycles_per_call': round(cycles / calls, 2),
+                }
+        elif BENCH_END in line:
+            finished = True
+
+    if not finished:
+        sys.exit('bench: the firmware did not report BENCH-END')
+
+    return cases
+
+
+def run(args):
+    """Run the firmware and write the results."""
+    cmd = [args.simavr, '-m', args.mcu, '-f', str(args.freq), args.elf]
+
+    try:
+        proc = subprocess.run(cmd, capture_output=True, text=True,
+                              errors='replace', timeout=args.timeout)
+    except subprocess.TimeoutExpired as e:
+        out = e.stdout or b''
+        sys.stderr.write(out.decode(errors='replace') if isinstance(out, bytes) else out)
+        sys.exit(f'bench: simavr did not finish in {args.timeout} s')
+
+    # simavr prints the UART on stdout or stderr depending on its version.
+    result = {'cases': parse_output(proc.stdout + proc.stderr)}
+    text = json.dumps(result, indent=4, sort_keys=True) + '\n'
+
+    if args.output:
+        with open(args.output, 'w') as f:
+            f.write(text)
+    else:
+        sys.stdout.write(text)
+
+    return 0
+
+
+def current_commit():
+    """Short hash of HEAD, marked -dirty when the tree has changes."""
+    def git(*args):
+        return subprocess.run(['git', *args], capture_output=True, text=True)
+
+    proc = git('rev-parse', '--short', 'HEAD')
+    if proc.returncode != 0:
+        return 'unknown'
+
+    commit = proc.stdout.strip()
+    if git('diff', '--quiet', 'HEAD').returncode != 0:
+        commit += '-dirty'
+
+    return commit
+
+
+def host(args):
+    """Run bench_host and write its characters per second per case."""
+    cmd = [args.executable, '--benchmark_format=json',
+           f'--benchmark_min_time={args.min_time}']
+    proc = subprocess.run(cmd, capture_output=True, text=True)
+
+    if proc.returncode != 0:
+        sys.stderr.write(proc.stderr)
+        sys.exit(f'bench: {args.executable} exited with {proc.returncode}')
+
+    cases = {}
+    for bench in json.loads(proc.stdout)['benchmarks']:
+        rate = bench['items_per_second']
+        cases[bench['name']] = {
+            'chars_per_second': round(rate),
+            'nsec_per_call': round(1e9 / rate, 3),
+        }
+
+    result = {'commit': current_commit(), 'date': time.strftime('%Y-%m-%d %H:%M:%S'),
+              'cases': cases}
+    text = json.dumps(result, indent=4, sort_keys=True) + '\n'
+
+    if args.output:
+        with open(args.output, 'w') as f:
+            f.write(text)
+    else:
+        sys.stdout.write(text)
+
+    if args.history:
+        add_to_history(args.history, result)
+
+    return 0
+
+
+def read_history(path):
+    try:
+        with open(path) as f:
+            return [json.loads(line) for line in f if line.strip()]
+    except FileNotFoundError:
+        return []
+
+
+def add_to_history(path, result):
+    """Append a result, replacing an earlier run at the same commit."""
+    entries = [e for e in read_history(path) if e['commit'] != result['commit']]
+    entries.append(result)
+
+    with open(path, 'w') as f:
+        for entry in entries:
+            f.write(json.dumps(entry, sort_keys=True) + '\n')
+
+
+def history(args):
+    """Print the characters per second of every case for the last commits."""
+    entries = read_history(args.history)[-args.last:]
+    if not entries:
+        print(f'bench: no history in {args.history}')
+        return 0
+
+    names = sorted({name for e in entries for name in e['cases']})
+
+    print(f'{"case (Mchar/s)":<44}' + ''.join(f' {e["commit"]:>14}' for e in entries))
+    for name in names:
+        row = ''
+        for entry in entries:
+            case = entry['cases'].get(name)
+            row += f' {case["chars_per_second"] / 1e6:>14.2f}' if case else f' {"-":>14}'
+        print(f'{name:<44}{row}')
+
+    return 0
+
+
+def load(path):
+    with open(path) as f:
+        return json.load(f)['cases']
+
+
+def cost(case):
+    """Cycles per call of a simavr case, nanoseconds per call of a host case."""
+    return case.get('cycles_per_call', case.get('nsec_per_call'))
+
+
+def compare(args):
+    """Print a table of changes and fail on regressions above the threshold."""
+    try:
+        base = load(args.baseline)
+    except FileNotFoundError:
+        print(f'bench: no baseline at {args.baseline}, nothing to compare')
+        return 0
+
+    result = load(args.result)
+    failed = []
+
+    print(f'{"case":<40} {"base":>10} {"new":>10} {"change":>8}')
+
+    for name in sorted(set(base) | set(result)):
+        old = cost(base.get(name, {}))
+        new = cost(result.get(name, {}))
+
+        if old is None or new is None:
+            print(f'{name:<40} {str(old):>10} {str(new):>10} {"":>8}')
+            if old is not None:
+                failed.append(name)
+            continue
+
+        change = ((new - old) / old * 100.0) if old else 0.0
+        flag = ''
+        if change > args.threshold:
+            flag = '  REGRESSION'
+            failed.append(name)
+
+        print(f'{name:<40} {old:>10} {new:>10} {change:>+7.1f}%{flag}')
+
+    if failed:
+        print(f'bench: {len(failed)} case(s) regressed more than {args.threshold}%')
+        return 1
+
+    return 0
+
+
+def baseline(args):
+    shutil.copyfile(args.result, args.baseline)
+    return 0
+
+
+if __name__ == "__main__":
+    cli_args = parse_args()
+    commands = {'run': run, 'host': host, 'history': history,
+                'compare': compare, 'baseline': baseline}
+    sys.exit(commands[cli_args.command](cli_args))
@@ -0,0 +1,149 @@
+#!/usr/bin/env python
+
+""" Host backend session driver
+
+Runs an exercise built with host-gcc-toolchain.cmake as a native process and
+talks to its UART through the pseudo-terminal the host BSP backend opens. This
+is the scripting entry point for driving the exercises without hardware:
+
+1. start the executable at the requested virtual clock speed
+2. send the input text over the UART
+3. print everything the firmware transmits until the run time expires
+
+The run time is virtual: the executable exits by itself once it has received
+nothing for --duration virtual seconds (BSP_HOST_EXIT_SEC). With --speed max
+the virtual clock is not tied to real time at all, and the run takes as long
+as the host needs to step the firmware through it.
+
+The LED trace can be kept with --led-trace (one "<usec> <cycles> <ON|OFF>"
+line per transition).
+"""
+
+import argparse
+import os
+import select
+import subprocess
+import sys
+import tempfile
+import time
+
+from dataclasses import dataclass
+
+@dataclass
+class CliArgs:
+    """Container class for command line parameters"""
+    executable: str
+    speed: str
+    duration: float
+    input: str
+    led_trace: str
+
+
+    def __init__(self):
+        parser = argparse.ArgumentParser(
+            description='Drive a host backend exercise over its UART.',
+        )
+
+        parser.add_argument('-s', '--speed', type=parse_speed, default='1',
+            help='Virtual seconds per real second, or max (default: 1).')
+
+        parser.add_argument('-t', '--duration', type=float, default=1.0,
+            help='Virtual seconds to run after the input is received (default: 1).')
+
+        parser.add_argument('-i', '--input', default=None,
+            help='File sent over the UART (default: stdin, "-" for none).')
+
+        parser.add_argument('-l', '--led-trace', default=None,
+            help='Write the LED trace to this file.')
+
+        parser.add_argument('executable')
+
+        args = parser.parse_args()
+
+        self.executable = args.executable
+        self.speed      = args.speed
+        self.duration   = args.duration
+        self.input      = args.input
+        self.led_trace  = args.led_trace
+
+
+def parse_speed(text):
+    """Accept a positive speed factor or max."""
+    if text != 'max' and not float(text) > 0:
+        raise argparse.ArgumentTypeError(f'invalid speed: {text}')
+
+    return text
+
+
+def read_input(path):
+    """Return the bytes to send over the UART."""
+    if path == '-':
+        return b''
+
+    if path is None:
+        return sys.stdin.buffer.read()
+
+    with open(path, 'rb') as f:
+        return f.read()
+
+
+def open_uart(link, proc):
+    """Wait for the backend to publish its pty and open it."""
+    while not os.path.exists(link):
+        if proc.poll() is not None:
+            sys.exit(f'{proc.args[0]} exited with {proc.returncode}')
+        time.sleep(0.01)
+
+    return os.open(link, os.O_RDWR | os.O_NOCTTY | os.O_NONBLOCK)
+
+
+def pump(fd, tx, proc):
+    """Send tx and echo everything received until the executable exits."""
+    out = sys.stdout.buffer
+
+    while True:
+        wlist = [fd] if tx else []
+        readable, writable, _ = select.select([fd], wlist, [], 0.1)
+
+        if writable:
+            tx = tx[os.write(fd, tx):]
+
+        if readable:
+            try:
+                data = os.read(fd, 4096)
+            except BlockingIOError:
+                continue
+            except OSError:
+                break
+
+            # The executable closed its side of the pty.
+            if not data:
+                break
+
+            out.write(data)
+            out.flush()
+        elif proc.poll() is not None:
+            break
+
+
+if __name__ == "__main__":
+    cli_arg = CliArgs()
+    tx = read_input(cli_arg.input)
+
+    with tempfile.TemporaryDirectory() as tmp:
+        link = os.path.join(tmp, 'uart')
+        env = dict(os.environ, BSP_HOST_PTY=link, BSP_HOST_SPEED=cli_arg.speed,
+                   BSP_HOST_EXIT_SEC=str(cli_arg.duration))
+
+        if cli_arg.led_trace:
+            env['BSP_HOST_LED_TRACE'] = cli_arg.led_trace
+
+        proc = subprocess.Popen([cli_arg.executable], env=env,
+                                stderr=subprocess.DEVNULL)
+        try:
+            fd = open_uart(link, proc)
+            pump(fd, tx, proc)
+            os.close(fd)
+        finally:
+            proc.kill()
+            proc.wait()
@@ -0,0 +1,190 @@
+#!/usr/bin/env python
+
+""" Deferred log decoder
+
+With the BSP_LOG_DEFERRED option the LOG macros of bsp/log.h send a binary
+record instead of the message text:
+
+    0xFF <id lo> <id hi> <arg0 lo> <arg0 hi> ...
+
+The id is the offset of the format string in the .logfmt section of the .elf
+and the number of arguments follows from the conversions in the format. This
+script reads the formats from the .elf and turns a serial capture (or a live
+stream on stdin) back into text. Every other byte is passed through, so the
+plain text the firmware writes is kept in place.
+"""
+
+import argparse
+import re
+import struct
+import sys
+
+from dataclasses import dataclass
+
+SYNC = 0xFF
+SECTION = '.logfmt'
+CONVERSION = re.compile(r'%(.)', re.DOTALL)
+
+
+@dataclass
+class CliArgs:
+    """Container class for command line parameters"""
+    elf: str
+    capture: str
+
+
+    def __init__(self):
+        parser = argparse.ArgumentParser(
+            description='Decode deferred log records in serial output.',
+        )
+
+        parser.add_argument('--elf', required=True,
+            help='Executable the log formats are read from.')
+
+        parser.add_argument('capture', nargs='?', default=None,
+            help='Capture of the serial output (default: stdin).')
+
+        args = parser.parse_args()
+
+        self.elf     = args.elf
+        self.capture = args.capture
+
+
+def read_formats(elf):
+    """Return {id: format} from the .logfmt section of a 32-bit ELF file."""
+    with open(elf, 'rb') as f:
+        data = f.read()
+
+    if data[:4] != b'\x7fELF' or data[4] != 1:
+        sys.exit(f'log: {elf} is not a 32-bit ELF file')
+
+    endian = '<' if data[5] == 1 else '>'
+    shoff, = struct.unpack_from(endian + 'I', data, 0x20)
+    shentsize, shnum, shstrndx = struct.unpack_from(endian + 'HHH', data, 0x2E)
+
+    def section(index):
+        # name, type, flags, addr, offset, size
+        return struct.unpack_from(endian + 'IIIIII', data, shoff + index * shentsize)
+
+    names_offset = section(shstrndx)[4]
+
+    for index in range(shnum):
+        name, _, _, _, offset, size = section(index)
+        end = data.index(b'\0', names_offset + name)
+
+        if data[names_offset + name:end].decode() == SECTION:
+            return split_formats(data[offset:offset + size])
+
+    sys.exit(f'log: {elf} has no {SECTION} section (built without BSP_LOG_DEFERRED?)')
+
+
+def split_formats(blob):
+    """Return {offset: format} of the NUL terminated strings in blob."""
+    formats = {}
+    offset = 0
+
+    while offset < len(blob):
+        end = blob.find(b'\0', offset)
+        if end < 0:
+            end = len(blob)
+
+        formats[offset] = blob[offset:end].decode('ascii', errors='replace')
+        offset = end + 1
+
+    return formats
+
+
+def count_args(fmt):
+    """Return the number of arguments a format consumes."""
+    return sum(1 for m in CONVERSION.finditer(fmt) if m.group(1) != '%')
+
+
+def render(fmt, args):
+    """Format a message the same way log_text__() does on the target."""
+    args = iter(args)
+
+    def convert(match):
+        kind = match.group(1)
+        if kind == '%':
+            return '%'
+
+        arg = next(args, 0)
+        if kind == 'u':
+            return str(arg)
+        if kind == 'd':
+            return str(arg - 0x10000 if arg & 0x8000 else arg)
+        if kind == 'x':
+            return f'{arg:x}'
+        if kind == 'c':
+            return chr(arg) if arg else ''
+        return match.group(0)
+
+    return CONVERSION.sub(convert, fmt)
+
+
+class Decoder:
+    """Incremental decoder of a serial stream."""
+
+    def __init__(self, formats):
+        self.formats = formats
+        self.pending = bytearray()
+
+    def feed(self, data):
+        """Return the decoded bytes of data (a record may span calls)."""
+        self.pending += data
+        out = bytearray()
+
+        while self.pending:
+            pos = self.pending.find(SYNC)
+            if pos < 0:
+                out += self.pending
+                self.pending.clear()
+                break
+
+            out += self.pending[:pos]
+            del self.pending[:pos]
+
+            if len(self.pending) < 3:
+                break
+
+            msg_id = self.pending[1] | (self.pending[2] << 8)
+            fmt = self.formats.get(msg_id)
+
+            if fmt is None:
+                out += f'<log: unknown id 0x{msg_id:04x}>'.encode()
+                del self.pending[:3]
+                continue
+
+            size = 3 + 2 * count_args(fmt)
+            if len(self.pending) < size:
+                break
+
+            args = [self.pending[a] | (self.pending[a + 1] << 8)
+                    for a in range(3, size, 2)]
+            out += render(fmt, args).encode()
+            del self.pending[:size]
+
+        return bytes(out)
+
+
+if __name__ == "__main__":
+    cli_arg = CliArgs()
+    decoder = Decoder(read_formats(cli_arg.elf))
+    out = sys.stdout.buffer
+
+    if cli_arg.capture:
+        stream = open(cli_arg.capture, 'rb')
+    else:
+        stream = sys.stdin.buffer
+
+    with stream:
+        while True:
+            chunk = stream.read1(4096)
+            if not chunk:
+                break
+
+            out.write(decoder.feed(chunk))
+            out.flush()
+
+    if decoder.pending:
+        sys.exit('log: capture ends inside a record')
@@ -0,0 +1,283 @@
+#!/usr/bin/env python
+
+""" Morse timing verification
+
+Decodes the builtin LED (PB5) VCD traces that tools/sim/avr_led_trace records
+and checks every on and off interval against the MORSE_TIMING_* constants of
+morse/private/timings.h:
+
+    morse_timing.py analyze --output result.json 02_sos=02_sos.vcd ...
+    morse_timing.py compare baseline.json result.json
+    morse_timing.py baseline result.json tools/sim/baseline/morse_timing.json
+
+Each interval is matched to the closest timing of its polarity (DOT and DASH
+while the LED is on, the gaps while it is off). Per timing the report shows the
+mean error, the jitter (standard deviation and peak to peak) and the intervals
+that are off by more than half a tick, which are missed or extra ticks. The
+drift is the total error of all matched intervals relative to their expected
+length. The first interval (from reset) and the last (cut off by the end of
+the run) are not counted, and neither are off intervals longer than twice the
+longest timing. Those are application pauses between messages (the 3 second
+delay of 04_morse_c_str), not morse timing.
+"""
+
+import argparse
+import json
+import math
+import re
+import shutil
+import sys
+
+DEFINE = re.compile(r'^#define\s+MORSE_TIMING_(\w+)\s+(.*?)\s*(?:/\*.*)?$')
+ON_TIMINGS = ('DOT', 'DASH')
+TIMESCALE_NSEC = {'s': 1e9, 'ms': 1e6, 'us': 1e3, 'ns': 1.0, 'ps': 1e-3, 'fs': 1e-6}
+
+
+def parse_args():
+    """Parse the command line into a subcommand namespace."""
+    parser = argparse.ArgumentParser(
+        description='Check LED traces against the morse timings.',
+    )
+    sub = parser.add_subparsers(dest='command', required=True)
+
+    analyze = sub.add_parser('analyze', help='Decode LED traces.')
+    analyze.add_argument('--timings', default='exercises/common/src/morse/private/timings.h',
+        help='Header with the MORSE_TIMING_* constants.')
+    analyze.add_argument('--tick-msec', type=float, default=100.0,
+        help='Length of one timing unit in msec (default: 100).')
+    analyze.add_argument('--signal', default='PB5',
+        help='VCD signal of the LED (default: PB5).')
+    analyze.add_argument('--output', default=None,
+        help='JSON result file.')
+    analyze.add_argument('traces', nargs='+', metavar='NAME=VCD',
+        help='Exercise name and its LED trace.')
+
+    compare = sub.add_parser('compare', help='Compare a result to a baseline.')
+    compare.add_argument('--threshold', type=float, default=50.0,
+        help='Increase in usec of |mean error| or jitter that fails (default: 50).')
+    compare.add_argument('baseline')
+    compare.add_argument('result')
+
+    baseline = sub.add_parser('baseline', help='Make a result the new baseline.')
+    baseline.add_argument('result')
+    baseline.add_argument('baseline')
+
+    return parser.parse_args()
+
+
+def read_timings(path, tick_usec):
+    """Return {name: usec} of the MORSE_TIMING_* constants."""
+    exprs = {}
+
+    with open(path) as f:
+        for line in f:
+            match = DEFINE.match(line.strip())
+            if match:
+                exprs[match.group(1)] = match.group(2)
+
+    values = {}
+
+    def evaluate(name):
+        if name not in values:
+            expr = re.sub(r'MORSE_TIMING_(\w+)', lambda m: str(evaluate(m.group(1))),
+                          exprs[name])
+            expr = re.sub(r'(\d+)[uUlL]+', r'\1', expr)
+            values[name] = eval(expr, {'__builtins__': {}})
+        return values[name]
+
+    return {name: evaluate(name) * tick_usec for name in exprs}
+
+
+def read_vcd(path, signal):
+    """Return [(usec, level), ...] of the signal's transitions."""
+    with open(path) as f:
+        tokens = f.read().split()
+
+    scale = 1.0
+    ident = None
+    pos = 0
+
+    # Header: $keyword ... $end
+    while pos < len(tokens) and tokens[pos] != '$enddefinitions':
+        if tokens[pos] == '$timescale':
+            spec = ''
+            pos += 1
+            while tokens[pos] != '$end':
+                spec += tokens[pos]
+                pos += 1
+            number, unit = re.match(r'(\d+)\s*(\w+)', spec).groups()
+            scale = int(number) * TIMESCALE_NSEC[unit] / 1000.0
+        elif tokens[pos] == '$var':
+            # $var wire <size> <id> <name> $end
+            if tokens[pos + 4] == signal:
+                ident = tokens[pos + 3]
+        pos += 1
+
+    if ident is None:
+        sys.exit(f'morse_timing: no {signal} signal in {path}')
+
+    transitions = []
+    now = 0.0
+    level = None
+
+    for token in tokens[pos:]:
+        if token.startswith('#'):
+            now = int(token[1:]) * scale
+        elif token[1:] == ident and token[0] in '01xz':
+            new = token[0]
+            if new in '01' and new != level:
+                transitions.append((now, new == '1'))
+            level = new
+
+    return transitions
+
+
+def analyze_trace(transitions, timings, tick_usec):
+    """Return {timing: stats} and the overall drift of a trace."""
+    on_set = {n: v for n, v in timings.items() if n in ON_TIMINGS}
+    off_set = {n: v for n, v in timings.items() if n not in ON_TIMINGS}
+    errors = {name: [] for name in timings}
+    outliers = {name: 0 for name in timings}
+    total_actual = 0.0
+    total_expected = 0.0
+    max_gap = 2 * max(timings.values())
+
+    for (start, level), (end, _) in zip(transitions[1:], transitions[2:]):
+        length = end - start
+        if not level and length > max_gap:
+            continue
+
+        candidates = on_set if level else off_set
+        name = min(candidates, key=lambda n: abs(candidates[n] - length))
+        error = length - candidates[name]
+
+        errors[name].append(error)
+        total_actual += length
+        total_expected += candidates[name]
+
+        if abs(error) > tick_usec / 2:
+            outliers[name] += 1
+
+    stats = {}
+    for name, errs in errors.items():
+        if not errs:
+            continue
+
+        mean = sum(errs) / len(errs)
+        stats[name] = {
+            'count': len(errs),
+            'expected_usec': timings[name],
+            'mean_error_usec': round(mean, 1),
+            'min_error_usec': round(min(errs), 1),
+            'max_error_usec': round(max(errs), 1),
+            'jitter_usec': round(math.sqrt(sum((e - mean) ** 2 for e in errs) / len(errs)), 1),
+            'missed_ticks': outliers[name],
+        }
+
+    drift = ((total_actual - total_expected) / total_expected * 1e6) if total_expected else 0.0
+
+    return stats, round(drift, 1)
+
+
+def print_result(result):
+    print(f'{"exercise":<18} {"timing":<14} {"count":>6} {"expected":>9} {"mean err":>9} '
+          f'{"min err":>9} {"max err":>9} {"jitter":>8} {"missed":>6}  (usec)')
+
+    for exercise, entry in sorted(result.items()):
+        for name, s in sorted(entry['timings'].items(), key=lambda i: i[1]['expected_usec']):
+            print(f'{exercise:<18} {name:<14} {s["count"]:>6} {s["expected_usec"]:>9.0f} '
+                  f'{s["mean_error_usec"]:>9} {s["min_error_usec"]:>9} '
+                  f'{s["max_error_usec"]:>9} {s["jitter_usec"]:>8} {s["missed_ticks"]:>6}')
+        print(f'{exercise:<18} drift {entry["drift_ppm"]:+.1f} ppm')
+
+
+def analyze(args):
+    tick_usec = args.tick_msec * 1000.0
+    timings = read_timings(args.timings, tick_usec)
+    result = {}
+
+    for trace in args.traces:
+        name, _, path = trace.partition('=')
+        transitions = read_vcd(path, args.signal)
+
+        if len(transitions) < 3:
+            sys.exit(f'morse_timing: {path} has no complete interval')
+
+        stats, drift = analyze_trace(transitions, timings, tick_usec)
+        result[name] = {'timings': stats, 'drift_ppm': drift}
+
+    print_result(result)
+
+    if args.output:
+        with open(args.output, 'w') as f:
+            f.write(json.dumps({'exercises': result}, indent=4, sort_keys=True) + '\n')
+
+    missed = sum(s['missed_ticks'] for e in result.values() for s in e['timings'].values())
+    if missed:
+        print(f'morse_timing: {missed} interval(s) off by more than half a tick')
+        return 1
+
+    return 0
+
+
+def load(path):
+    with open(path) as f:
+        return json.load(f)['exercises']
+
+
+def compare(args):
+    """Fail when the error or jitter of a timing grew more than the threshold."""
+    try:
+        base = load(args.baseline)
+    except FileNotFoundError:
+        print(f'morse_timing: no baseline at {args.baseline}, nothing to compare')
+        return 0
+
+    result = load(args.result)
+    failed = []
+
+    print(f'{"exercise":<18} {"timing":<14} {"|err| base":>10} {"new":>8} '
+          f'{"jitter base":>11} {"new":>8}')
+
+    for exercise in sorted(set(base) | set(result)):
+        old_timings = base.get(exercise, {}).get('timings', {})
+        new_timings = result.get(exercise, {}).get('timings', {})
+
+        for name in sorted(set(old_timings) | set(new_timings)):
+            old = old_timings.get(name)
+            new = new_timings.get(name)
+
+            if old is None or new is None:
+                print(f'{exercise:<18} {name:<14} {"missing in " + ("result" if new is None else "baseline")}')
+                if new is None:
+                    failed.append(f'{exercise}/{name}')
+                continue
+
+            old_err, new_err = abs(old['mean_error_usec']), abs(new['mean_error_usec'])
+            old_jit, new_jit = old['jitter_usec'], new['jitter_usec']
+            flag = ''
+
+            if (new_err - old_err > args.threshold or new_jit - old_jit > args.threshold
+                    or new['missed_ticks'] > old['missed_ticks']):
+                flag = '  REGRESSION'
+                failed.append(f'{exercise}/{name}')
+
+            print(f'{exercise:<18} {name:<14} {old_err:>10} {new_err:>8} '
+                  f'{old_jit:>11} {new_jit:>8}{flag}')
+
+    if failed:
+        print(f'morse_timing: {len(failed)} timing(s) regressed')
+        return 1
+
+    return 0
+
+
+def baseline(args):
+    shutil.copyfile(args.result, args.baseline)
+    return 0
+
+
+if __name__ == "__main__":
+    cli_args = parse_args()
+    commands = {'analyze': analyze, 'compare': compare, 'baseline': baseline}
+    sys.exit(commands[cli_args.command](cli_args))
@@ -0,0 +1,164 @@
+#!/usr/bin/env python
+
+""" Profiler report
+
+Maps the histogram that bsp/profiler.c dumps over the UART onto the functions
+of the executable it was captured from:
+
+    PROFILE-BEGIN <bin shift>
+    <bin byte address> <samples>
+    ...
+    PROFILE-END <samples outside the bins>
+
+All fields are hexadecimal. Each bin covers 2^shift bytes of code. A bin that
+straddles functions is split between them by the bytes each one covers.
+
+Function boundaries come from the .lss artifact. With --elf the hottest bins
+are also annotated with their source lines (addr2line).
+"""
+
+import argparse
+import re
+import subprocess
+import sys
+
+from dataclasses import dataclass
+
+FUNCTION_LINE = re.compile(r'^([0-9a-f]+) <([^>]+)>:$')
+
+
+@dataclass
+class CliArgs:
+    """Container class for command line parameters"""
+    dump: str
+    lss: str
+    elf: str
+    addr2line: str
+    bins: int
+
+
+    def __init__(self):
+        parser = argparse.ArgumentParser(
+            description='Symbolize a profiler histogram dump.',
+        )
+
+        parser.add_argument('--lss', required=True,
+            help='Disassembly of the profiled executable.')
+
+        parser.add_argument('--elf', default=None,
+            help='Profiled executable, for source lines of the hottest bins.')
+
+        parser.add_argument('--addr2line', default='avr-addr2line',
+            help='addr2line used with --elf (default: avr-addr2line).')
+
+        parser.add_argument('-n', '--bins', type=int, default=10,
+            help='Hottest bins to list (default: 10).')
+
+        parser.add_argument('dump', nargs='?', default=None,
+            help='Captured serial output (default: stdin).')
+
+        args = parser.parse_args()
+
+        self.dump      = args.dump
+        self.lss       = args.lss
+        self.elf       = args.elf
+        self.addr2line = args.addr2line
+        self.bins      = args.bins
+
+
+def read_dump(text):
+    """Return (shift, {address: samples}, outside) of the last dump in text."""
+    dump = None
+
+    for line in text.splitlines():
+        fields = line.split()
+
+        if len(fields) == 2 and fields[0] == 'PROFILE-BEGIN':
+            dump = (int(fields[1], 16), {}, 0)
+        elif dump is None:
+            continue
+        elif len(fields) == 2 and fields[0] == 'PROFILE-END':
+            return dump[0], dump[1], int(fields[1], 16)
+        elif len(fields) == 2:
+            try:
+                dump[1][int(fields[0], 16)] = int(fields[1], 16)
+            except ValueError:
+                pass
+
+    sys.exit('profile: no complete PROFILE-BEGIN/PROFILE-END dump found')
+
+
+def read_functions(lss):
+    """Return a sorted list of (start, name) from the disassembly."""
+    functions = []
+
+    with open(lss) as f:
+        for line in f:
+            match = FUNCTION_LINE.match(line.rstrip('\n'))
+            if match:
+                functions.append((int(match.group(1), 16), match.group(2)))
+
+    return sorted(set(functions))
+
+
+def attribute(functions, shift, bins):
+    """Return {function: samples} with each bin split by the bytes covered."""
+    per_function = {}
+    size = 1 << shift
+
+    for address, samples in bins.items():
+        end = address + size
+
+        for i, (start, name) in enumerate(functions):
+            stop = functions[i + 1][0] if i + 1 < len(functions) else end
+            overlap = min(stop, end) - max(start, address)
+
+            if overlap > 0:
+                share = samples * overlap / size
+                per_function[name] = per_function.get(name, 0.0) + share
+
+    return per_function
+
+
+def source_lines(addr2line, elf, addresses):
+    """Return {address: 'function at file:line'} from addr2line."""
+    cmd = [addr2line, '-f', '-C', '-e', elf] + [hex(a) for a in addresses]
+    out = subprocess.run(cmd, capture_output=True, text=True, check=True).stdout
+    lines = out.splitlines()
+
+    return {a: f'{lines[2 * i]} at {lines[2 * i + 1]}' for i, a in enumerate(addresses)}
+
+
+if __name__ == "__main__":
+    cli_arg = CliArgs()
+
+    if cli_arg.dump:
+        with open(cli_arg.dump, errors='replace') as f:
+            text = f.read()
+    else:
+        text = sys.stdin.read()
+
+    shift, bins, outside = read_dump(text)
+    functions = read_functions(cli_arg.lss)
+    per_function = attribute(functions, shift, bins)
+
+    total = sum(bins.values()) + outside
+    if total == 0:
+        sys.exit('profile: the dump has no samples')
+
+    print(f'{total} samples, {1 << shift} bytes per bin')
+    print()
+    print(f'{"samples":>9} {"%":>6}  function')
+    for name, samples in sorted(per_function.items(), key=lambda f: -f[1]):
+        print(f'{samples:>9.1f} {samples * 100 / total:>6.1f}  {name}')
+    if outside:
+        print(f'{outside:>9} {outside * 100 / total:>6.1f}  (outside the profiled range)')
+
+    hottest = sorted(bins, key=lambda a: -bins[a])[:cli_arg.bins]
+    if cli_arg.elf and hottest:
+        where = source_lines(cli_arg.addr2line, cli_arg.elf, hottest)
+
+        print()
+        print(f'{"bin":>6} {"samples":>9}  location')
+        for address in hottest:
+            print(f'{address:06x} {bins[address]:>9}  {where[address]}')
@@ -0,0 +1,296 @@
+#!/usr/bin/env python
+
+""" Worst case RAM report
+
+Combines the per function stack usage that -fstack-usage writes next to every
+object file (.su) with the call graph of the linked image (.lss disassembly) to
+bound the stack of an AVR executable:
+
+1. the deepest call chain from main
+2. plus the deepest call chain of any interrupt vector (__vector_N)
+
+Interrupts do not nest in this code base (no ISR_NOBLOCK), so only one vector is
+added on top of the main path. Indirect calls (icall/eicall) are assumed to
+reach every function whose address is taken in one of the objects, which is
+found from the R_AVR_*_GS / R_AVR_16_PM relocations. That covers the BSP timer
+callbacks that the TIMER1_COMPA vector calls through a function pointer.
+
+The stack bound is printed next to the static RAM (.data, .bss, .noinit) from
+the .size.txt artifact. With --budget the script fails when static RAM plus the
+worst case stack does not fit.
+"""
+
+import argparse
+import pathlib
+import re
+import subprocess
+import sys
+
+from dataclasses import dataclass
+
+# Bytes of the return address pushed by (r)call on a 16-bit PC part. It is the
+# only stack cost assumed for functions without a .su entry (libgcc and
+# avr-libc assembly routines).
+RETURN_ADDRESS_SIZE = 2
+
+FUNCTION_LINE = re.compile(r'^[0-9a-f]+ <([^>]+)>:$')
+CALL_LINE     = re.compile(r'\t(call|rcall|jmp|rjmp)\t.*<([^>]+)>\s*$')
+ICALL_LINE    = re.compile(r'\t(e?icall|e?ijmp)\b')
+VECTOR_NAME   = re.compile(r'^__vector_[0-9]+$')
+CODE_RELOC    = re.compile(r'\sR_AVR_(?:\w+_GS|16_PM)\s+(\S+)')
+
+
+@dataclass
+class CliArgs:
+    """Container class for command line parameters"""
+    lss: str
+    size: str
+    objdump: str
+    budget: int
+    objects: list
+
+
+    def __init__(self):
+        parser = argparse.ArgumentParser(
+            description='Report the worst case RAM use of an AVR executable.',
+        )
+
+        parser.add_argument('--lss', required=True,
+            help='Disassembly of the linked executable (objdump -d).')
+
+        parser.add_argument('--size', required=True,
+            help='Section sizes of the executable (size -A).')
+
+        parser.add_argument('--objdump', default='avr-objdump',
+            help='objdump used to read object relocations.')
+
+        parser.add_argument('--budget', type=int, default=0,
+            help='RAM budget in bytes (0 to only report).')
+
+        parser.add_argument('objects', nargs='+',
+            help='Object files linked into the executable.')
+
+        args = parser.parse_args()
+
+        self.lss     = args.lss
+        self.size    = args.size
+        self.objdump = args.objdump
+        self.budget  = args.budget
+        self.objects = args.objects
+
+
+def base_name(name):
+    """Strip GCC clone suffixes (foo.constprop.0 -> foo)."""
+    return name.split('.', 1)[0]
+
+
+def read_stack_usage(objects):
+    """Return {function: (bytes, qualifier)} from the .su file of each object.
+
+    Static functions of the same name in different objects are merged to the
+    larger frame, which keeps the bound safe.
+    """
+    usage = {}
+
+    for obj in objects:
+        su = pathlib.Path(obj).with_suffix('.su')
+        if not su.exists():
+            continue
+
+        for line in su.read_text().splitlines():
+            location, size, qualifier = line.split('\t')
+            name = location.rsplit(':', 1)[1]
+            size = int(size)
+
+            if name not in usage or usage[name][0] < size:
+                usage[name] = (size, qualifier)
+
+    return usage
+
+
+def read_address_taken(objdump, objects):
+    """Return the functions whose address is taken in the given objects."""
+    taken = set()
+
+    for obj in objects:
+        out = subprocess.run([objdump, '-r', obj], capture_output=True,
+                             text=True, check=True).stdout
+
+        for match in CODE_RELOC.finditer(out):
+            symbol = match.group(1).split('+', 1)[0]
+
+            # With -ffunction-sections a static function is referenced through
+            # its section symbol.
+            if symbol.startswith('.text.'):
+                symbol = symbol[len('.text.'):]
+
+            taken.add(symbol)
+
+    return taken
+
+
+def read_call_graph(lss):
+    """Return ({function: set(callees)}, set(functions with indirect calls))."""
+    graph = {}
+    indirect = set()
+    current = None
+
+    with open(lss) as f:
+        for line in f:
+            line = line.rstrip('\n')
+
+            match = FUNCTION_LINE.match(line)
+            if match:
+                current = match.group(1)
+                graph.setdefault(current, set())
+                continue
+
+            if current is None:
+                continue
+
+            match = CALL_LINE.search(line)
+            if match:
+                target = match.group(2)
+
+                # Branches inside a function show up as <name+0x..>. A jump to
+                # the start of another function is a tail call.
+                if '+' not in target and target != current:
+                    graph[current].add(target)
+                elif match.group(1).endswith('call') and target == current:
+                    graph[current].add(target)
+                continue
+
+            if ICALL_LINE.search(line):
+                indirect.add(current)
+
+    return graph, indirect
+
+
+def read_static_ram(size):
+    """Return {section: bytes} of the RAM sections from size -A output."""
+    ram = {'.data': 0, '.bss': 0, '.noinit': 0}
+
+    with open(size) as f:
+        for line in f:
+            fields = line.split()
+            if len(fields) >= 2 and fields[0] in ram:
+                ram[fields[0]] = int(fields[1])
+
+    return ram
+
+
+class StackAnalysis:
+    """Depth first search of the worst case stack of each call chain."""
+
+    def __init__(self, graph, indirect, taken, usage):
+        self.graph    = graph
+        self.indirect = indirect
+        self.taken    = sorted(t for t in taken if t in graph)
+        self.usage    = usage
+        self.unknown  = set()
+        self.dynamic  = {}
+        self.cycles   = set()
+        self.memo     = {}
+
+    def frame(self, name):
+        entry = self.usage.get(name) or self.usage.get(base_name(name))
+
+        if entry is None:
+            self.unknown.add(name)
+            return RETURN_ADDRESS_SIZE
+
+        size, qualifier = entry
+        if qualifier != 'static':
+            self.dynamic[name] = qualifier
+
+        return size
+
+    def callees(self, name):
+        callees = set(self.graph.get(name, ()))
+
+        if name in self.indirect:
+            callees.update(self.taken)
+
+        return callees
+
+    def depth(self, name, path=()):
+        """Return (bytes, chain) of the deepest call chain starting at name."""
+        if name in self.memo:
+            return self.memo[name]
+
+        if name in path:
+            self.cycles.add(' -> '.join(path[path.index(name):] + (name,)))
+            return 0, [name]
+
+        best, chain = 0, []
+        for callee in sorted(self.callees(name)):
+            size, sub_chain = self.depth(callee, path + (name,))
+            if size > best:
+                best, chain = size, sub_chain
+
+        result = (self.frame(name) + best, [name] + chain)
+        self.memo[name] = result
+
+        return result
+
+
+if __name__ == "__main__":
+    cli_arg = CliArgs()
+
+    usage = read_stack_usage(cli_arg.objects)
+    taken = read_address_taken(cli_arg.objdump, cli_arg.objects)
+    graph, indirect = read_call_graph(cli_arg.lss)
+    ram = read_static_ram(cli_arg.size)
+
+    analysis = StackAnalysis(graph, indirect, taken, usage)
+
+    main_size, main_chain = analysis.depth('main')
+
+    isr_size, isr_chain = 0, []
+    for vector in sorted(f for f in graph if VECTOR_NAME.match(f)):
+        size, chain = analysis.depth(vector)
+        if size > isr_size:
+            isr_size, isr_chain = size, chain
+
+    static_ram = sum(ram.values())
+    stack = main_size + isr_size
+    total = static_ram + stack
+
+    name = pathlib.Path(cli_arg.lss).stem
+    print(f'RAM report for {name}')
+    for section, size in ram.items():
+        print(f'  {section:<8} {size:>5} bytes')
+    print(f'  {"main":<8} {main_size:>5} bytes  {" -> ".join(main_chain)}')
+    print(f'  {"isr":<8} {isr_size:>5} bytes  {" -> ".join(isr_chain)}')
+    print(f'  {"total":<8} {total:>5} bytes', end='')
+    if cli_arg.budget:
+        print(f' of {cli_arg.budget} ({total * 100 // cli_arg.budget}%)')
+    else:
+        print()
+
+    if analysis.unknown:
+        print(f'  assumed {RETURN_ADDRESS_SIZE} bytes (no .su): '
+              + ', '.join(sorted(analysis.unknown)))
+
+    failed = False
+
+    # A bounded dynamic frame is included in the .su size, an unbounded one
+    # (alloca, variable length arrays) is not.
+    for function, qualifier in sorted(analysis.dynamic.items()):
+        if qualifier == 'dynamic':
+            print(f'  error: unbounded dynamic stack frame: {function}')
+            failed = True
+        else:
+            print(f'  note: {qualifier} stack frame: {function}')
+
+    if analysis.cycles:
+        for cycle in sorted(analysis.cycles):
+            print(f'  error: recursion is unbounded: {cycle}')
+        failed = True
+
+    if cli_arg.budget and total > cli_arg.budget:
+        print(f'  error: {name} exceeds its RAM budget by '
+              f'{total - cli_arg.budget} bytes')
+        failed = True
+
+    sys.exit(1 if failed else 0)
@@ -0,0 +1,125 @@
+#!/usr/bin/env python
+
+""" Event trace decoder
+
+Finds the binary frames that trace_drain() (bsp/trace.c) writes to the serial
+port in a capture of the serial output and prints them as a timeline:
+
+    0xA5 0x5A <count> <now lo> <now hi> <count records of id arg ts-lo ts-hi>
+
+Timestamps are 64 usec ticks of TIM0 that wrap every 4.2 seconds. Each record
+is shown relative to the drain (the "now" of the frame), which is exact as long
+as the record is younger than one wrap.
+"""
+
+import argparse
+import sys
+
+from dataclasses import dataclass
+
+SYNC = b'\xA5\x5A'
+HEADER_SIZE = 5
+RECORD_SIZE = 4
+MAX_RECORDS = 64
+USEC_PER_TICK = 64
+
+# Must match TraceId_t in bsp/trace.h
+EVENTS = {
+    1: 'UART_RX',
+    2: 'UART_RX_DROP',
+    3: 'UART_TX',
+    4: 'UART_TX_DROP',
+    5: 'MORSE_STATE',
+    6: 'ERROR_TRAP',
+}
+
+MORSE_STATES = {0: 'IDLE', 1: 'ENCODE'}
+
+
+@dataclass
+class CliArgs:
+    """Container class for command line parameters"""
+    capture: str
+
+
+    def __init__(self):
+        parser = argparse.ArgumentParser(
+            description='Decode event trace frames from a serial capture.',
+        )
+
+        parser.add_argument('capture', nargs='?', default=None,
+            help='Binary capture of the serial output (default: stdin).')
+
+        args = parser.parse_args()
+
+        self.capture = args.capture
+
+
+def find_frames(data):
+    """Yield (now, [(id, arg, ts), ...]) for every complete frame in data."""
+    pos = data.find(SYNC)
+
+    while pos >= 0:
+        header = data[pos:pos + HEADER_SIZE]
+        count = header[2] if len(header) == HEADER_SIZE else MAX_RECORDS + 1
+        end = pos + HEADER_SIZE + count * RECORD_SIZE
+
+        if count <= MAX_RECORDS and end <= len(data):
+            now = header[3] | (header[4] << 8)
+            records = []
+
+            for r in range(pos + HEADER_SIZE, end, RECORD_SIZE):
+                rec = data[r:r + RECORD_SIZE]
+                records.append((rec[0], rec[1], rec[2] | (rec[3] << 8)))
+
+            yield now, records
+            pos = data.find(SYNC, end)
+        else:
+            pos = data.find(SYNC, pos + 1)
+
+
+def describe(event, arg):
+    """Return a readable event name and argument."""
+    name = EVENTS.get(event, f'APP_{event:02X}' if event >= 0x80 else f'ID_{event:02X}')
+
+    if name.startswith('UART'):
+        text = repr(chr(arg)) if 0x20 <= arg < 0x7F else f'0x{arg:02X}'
+    elif name == 'MORSE_STATE':
+        text = MORSE_STATES.get(arg, str(arg))
+    else:
+        text = str(arg)
+
+    return name, text
+
+
+def print_frame(index, now, records):
+    print(f'trace frame {index}: {len(records)} records')
+    print(f'{"time (ms)":>11} {"delta (us)":>11}  event')
+
+    prev = None
+    for event, arg, ts in records:
+        age = ((now - ts) & 0xFFFF) * USEC_PER_TICK
+        delta = '' if prev is None else str(((ts - prev) & 0xFFFF) * USEC_PER_TICK)
+        name, text = describe(event, arg)
+
+        print(f'{-age / 1000:>11.3f} {delta:>11}  {name:<14} {text}')
+        prev = ts
+
+    print()
+
+
+if __name__ == "__main__":
+    cli_arg = CliArgs()
+
+    if cli_arg.capture:
+        with open(cli_arg.capture, 'rb') as f:
+            data = f.read()
+    else:
+        data = sys.stdin.buffer.read()
+
+    frames = list(find_frames(data))
+    if not frames:
+        sys.exit('trace: no trace frame found')
+
+    for index, (now, records) in enumerate(frames):
+        print_frame(index, now, records)
@@ -0,0 +1,256 @@
+#!/usr/bin/env python
+
+""" UART session capture and replay
+
+A session is the bytes an operator sent to an exercise together with their
+arrival times. It is stored as text, one received byte per line:
+
+    # uart session
+    <usec> <byte in hex>
+
+The times count from the first byte. Sessions come from a live terminal
+(against a board or a host backend executable) or from typing a text file at a
+fixed rate, and are played back into a host backend executable at their
+original timing or faster:
+
+    uart_session.py record --device /dev/ttyUSB0 operator.uts
+    uart_session.py record --executable build/host/.../08_morse_encoder operator.uts
+    uart_session.py type --cps 8 sentences.txt typed.uts
+    uart_session.py replay --speed 10 operator.uts build/host/.../08_morse_encoder
+
+tools/sim/avr_replay plays the same files into an AVR executable in simavr and
+counts the bytes the RX ring had to drop.
+"""
+
+import argparse
+import os
+import random
+import select
+import subprocess
+import sys
+import tempfile
+import termios
+import time
+import tty
+
+from host_session import open_uart
+
+HEADER   = '# uart session\n'
+QUIT_KEY = 0x1D     # Ctrl-]
+
+BAUD_RATES = {9600: termios.B9600, 19200: termios.B19200, 38400: termios.B38400,
+              57600: termios.B57600, 115200: termios.B115200}
+
+
+def parse_args():
+    """Parse the command line into a subcommand namespace."""
+    parser = argparse.ArgumentParser(
+        description='Record and replay timestamped UART sessions.',
+    )
+    sub = parser.add_subparsers(dest='command', required=True)
+
+    record = sub.add_parser('record', help='Record a live terminal session (Ctrl-] ends it).')
+    target = record.add_mutually_exclusive_group(required=True)
+    target.add_argument('--device', help='Serial device of a board.')
+    target.add_argument('--executable', help='Host backend executable.')
+    record.add_argument('--baud', type=int, default=19200, choices=sorted(BAUD_RATES),
+        help='Serial device baud rate (default: 19200).')
+    record.add_argument('session')
+
+    type_ = sub.add_parser('type', help='Make a session by typing a text file.')
+    type_.add_argument('--cps', type=float, default=8.0,
+        help='Characters per second (default: 8).')
+    type_.add_argument('--jitter', type=float, default=0.3,
+        help='Random spread of a keystroke as a fraction of its period (default: 0.3).')
+    type_.add_argument('--seed', type=int, default=1,
+        help='Seed of the jitter, so the session is reproducible (default: 1).')
+    type_.add_argument('text')
+    type_.add_argument('session')
+
+    replay = sub.add_parser('replay', help='Play a session into a host backend executable.')
+    replay.add_argument('--speed', type=float, default=1.0,
+        help='Playback speed, 10 plays ten times faster (default: 1).')
+    replay.add_argument('--duration', type=float, default=1.0,
+        help='Seconds to keep running after the last byte (default: 1).')
+    replay.add_argument('session')
+    replay.add_argument('executable')
+
+    return parser.parse_args()
+
+
+def read_session(path):
+    """Return [(usec, byte), ...] of a session file."""
+    events = []
+
+    with open(path) as f:
+        for number, line in enumerate(f, 1):
+            line = line.split('#', 1)[0].strip()
+            if not line:
+                continue
+
+            try:
+                usec, byte = line.split()
+                events.append((int(usec), int(byte, 16)))
+            except ValueError:
+                sys.exit(f'uart_session: {path}:{number}: expected "<usec> <hex byte>"')
+
+    return events
+
+
+def write_session(path, events):
+    start = events[0][0] if events else 0
+
+    with open(path, 'w') as f:
+        f.write(HEADER)
+        for usec, byte in events:
+            f.write(f'{usec - start} {byte:02x}\n')
+
+
+def open_device(path, baud):
+    """Open a serial device raw at the baud rate."""
+    fd = os.open(path, os.O_RDWR | os.O_NOCTTY | os.O_NONBLOCK)
+    tty.setraw(fd)
+
+    attrs = termios.tcgetattr(fd)
+    attrs[4] = attrs[5] = BAUD_RATES[baud]
+    termios.tcsetattr(fd, termios.TCSANOW, attrs)
+
+    return fd
+
+
+def terminal(fd, events):
+    """Forward the keyboard to fd and fd to the screen, logging the keys."""
+    stdin = sys.stdin.fileno()
+    saved = termios.tcgetattr(stdin)
+    out = sys.stdout.buffer
+    done = False
+
+    tty.setraw(stdin)
+    try:
+        while not done:
+            readable, _, _ = select.select([stdin, fd], [], [])
+
+            if stdin in readable:
+                keys = os.read(stdin, 64)
+                now = time.monotonic_ns() // 1000
+
+                if QUIT_KEY in keys:
+                    keys = keys[:keys.index(QUIT_KEY)]
+                    done = True
+
+                events.extend((now, byte) for byte in keys)
+                os.write(fd, keys)
+
+            if fd in readable:
+                try:
+                    out.write(os.read(fd, 4096))
+                    out.flush()
+                except BlockingIOError:
+                    pass
+    finally:
+        termios.tcsetattr(stdin, termios.TCSADRAIN, saved)
+
+
+def start_host(executable, tmp, speed=1.0):
+    """Start a host backend executable and open its UART."""
+    link = os.path.join(tmp, 'uart')
+    env = dict(os.environ, BSP_HOST_PTY=link, BSP_HOST_SPEED=str(speed))
+    proc = subprocess.Popen([executable], env=env, stderr=subprocess.DEVNULL)
+
+    return proc, open_uart(link, proc)
+
+
+def record(args):
+    events = []
+
+    print('recording, Ctrl-] ends the session\r')
+
+    if args.device:
+        fd = open_device(args.device, args.baud)
+        try:
+            terminal(fd, events)
+        finally:
+            os.close(fd)
+    else:
+        with tempfile.TemporaryDirectory() as tmp:
+            proc, fd = start_host(args.executable, tmp)
+            try:
+                terminal(fd, events)
+            finally:
+                os.close(fd)
+                proc.kill()
+                proc.wait()
+
+    write_session(args.session, events)
+    print(f'{len(events)} bytes recorded in {args.session}')
+
+    return 0
+
+
+def type_text(args):
+    """Type a text file at a steady rate with some human spread."""
+    with open(args.text, 'rb') as f:
+        text = f.read()
+
+    rng = random.Random(args.seed)
+    period = 1e6 / args.cps
+    events = []
+
+    for i, byte in enumerate(text):
+        usec = i * period + rng.uniform(-args.jitter, args.jitter) * period / 2
+        events.append((max(int(usec), events[-1][0] if events else 0), byte))
+
+    write_session(args.session, events)
+
+    return 0
+
+
+def replay(args):
+    """Send every byte at its time divided by the speed, print the output."""
+    events = read_session(args.session)
+    out = sys.stdout.buffer
+    late = 0
+
+    with tempfile.TemporaryDirectory() as tmp:
+        proc, fd = start_host(args.executable, tmp)
+        try:
+            start = time.monotonic()
+            end = (events[-1][0] / 1e6 / args.speed if events else 0) + args.duration
+            pending = list(events)
+
+            while True:
+                now = time.monotonic() - start
+
+                while pending and pending[0][0] / 1e6 / args.speed <= now:
+                    usec, byte = pending.pop(0)
+                    os.write(fd, bytes([byte]))
+                    late = max(late, now - usec / 1e6 / args.speed)
+
+                if now >= end and not pending:
+                    break
+
+                timeout = (pending[0][0] / 1e6 / args.speed if pending else end) - now
+                readable, _, _ = select.select([fd], [], [], max(timeout, 0))
+
+                if readable:
+                    try:
+                        out.write(os.read(fd, 4096))
+                        out.flush()
+                    except BlockingIOError:
+                        pass
+
+            os.close(fd)
+        finally:
+            proc.kill()
+            proc.wait()
+
+    print(f'\nuart_session: {len(events)} bytes at {args.speed:g}x, '
+          f'latest byte {late * 1e3:.1f} msec behind', file=sys.stderr)
+
+    return 0
+
+
+if __name__ == "__main__":
+    cli_args = parse_args()
+    commands = {'record': record, 'type': type_text, 'replay': replay}
+    sys.exit(commands[cli_args.command](cli_args))
@@ -0,0 +1,265 @@
+/**
+ * @file spsc_ring_stress.cpp
+ * @brief Producer/consumer stress test of the SPSC ring (utils/spsc_ring.h and
+ * utils/spsc_ring.hpp) on two host threads
+ *
+ * A producer thread feeds a sequence of numbers through the ring with a random
+ * mix of single pushes and bulk writes, while the consumer thread takes them
+ * out with a random mix of pops, peeks and bulk reads. The consumer checks that
+ * every number arrives once and in order, and that the fill never exceeds the
+ * capacity. Both sides also check that their ring position follows their own
+ * count. Each ring size is run with both the C macros and the C++ template.
+ *
+ * The elements are 32 bits wide so a torn or stale element cannot look right
+ * by accident, and the sequence wraps the 8-bit counters thousands of times.
+ */
+
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+
+#include "utils/spsc_ring.h"
+#include "utils/spsc_ring.hpp"
+#include "types.h"
+
+/* Numbers sent through every ring */
+#define STRESS_ITEMS        (1ul << 20)
+
+/* Longest bulk write or read (more than the largest capacity) */
+#define STRESS_CHUNK_LEN    (300u)
+
+SPSC_RING_DECLARATIONS(Ring4, u32_t, 4u)
+SPSC_RING_DECLARATIONS(Ring16, u32_t, 16u)
+SPSC_RING_DECLARATIONS(Ring256, u32_t, 256u)
+
+/*
+ * Static interface of a C macro ring, the same one CppRing has, so one
+ * stress() runs them both.
+ */
+#define C_RING_ADAPTER(T_RING, SIZE)                                            \
+SPSC_RING_DECLARE(static T_RING, T_RING ## _c);                                 \
+                                                                                \
+struct T_RING ## Adapter                                                        \
+{                                                                               \
+    static constexpr u8_t CAPACITY = SPSC_RING_CAPACITY(SIZE);                  \
+                                                                                \
+    static void init() { SPSC_RING_INIT(T_RING, T_RING ## _c); }                \
+    static u8_t count() { return SPSC_RING_COUNT(T_RING, T_RING ## _c); }       \
+    static u8_t write_pos()                                                     \
+    {                                                                           \
+        return SPSC_RING_WRITE_POS(T_RING, T_RING ## _c);                       \
+    }                                                                           \
+    static u8_t read_pos()                                                      \
+    {                                                                           \
+        return SPSC_RING_READ_POS(T_RING, T_RING ## _c);                        \
+    }                                                                           \
+    static bool push(u32_t d)                                                   \
+    {                                                                           \
+        return E_TRUE == SPSC_RING_PUSH(T_RING, T_RING ## _c, d);               \
+    }                                                                           \
+    static bool pop(u32_t &d)                                                   \
+    {                                                                           \
+        return E_TRUE == SPSC_RING_POP(T_RING, T_RING ## _c, &d);               \
+    }                                                                           \
+    static bool peek(u32_t &d)                                                  \
+    {                                                                           \
+        return E_TRUE == SPSC_RING_PEEK(T_RING, T_RING ## _c, &d);              \
+    }                                                                           \
+    static size_t write(const u32_t *p_src, size_t len)                         \
+    {                                                                           \
+        return SPSC_RING_WRITE(T_RING, T_RING ## _c, p_src, len);               \
+    }                                                                           \
+    static size_t read(u32_t *p_dst, size_t len)                                \
+    {                                                                           \
+        return SPSC_RING_READ(T_RING, T_RING ## _c, p_dst, len);                \
+    }                                                                           \
+};
+
+C_RING_ADAPTER(Ring4, 4u)
+C_RING_ADAPTER(Ring16, 16u)
+C_RING_ADAPTER(Ring256, 256u)
+
+/**
+ * @brief Static interface of a C++ ring.
+ */
+template <unsigned int SIZE>
+struct CppRing
+{
+    static constexpr u8_t CAPACITY = SpscRing<u32_t, SIZE>::CAPACITY;
+
+    static SpscRing<u32_t, SIZE> ring;
+
+    static void init() { ring.init(); }
+    static u8_t count() { return ring.count(); }
+    static u8_t write_pos() { return ring.write_pos(); }
+    static u8_t read_pos() { return ring.read_pos(); }
+    static bool push(u32_t d) { return ring.push(d); }
+    static bool pop(u32_t &d) { return ring.pop(d); }
+    static bool peek(u32_t &d) { return ring.peek(d); }
+    static size_t write(const u32_t *p_src, size_t len) { return ring.write(p_src, len); }
+    static size_t read(u32_t *p_dst, size_t len) { return ring.read(p_dst, len); }
+};
+
+template <unsigned int SIZE>
+SpscRing<u32_t, SIZE> CppRing<SIZE>::ring;
+
+/**
+ * @brief The next number of a xorshift32 sequence.
+ */
+static u32_t next_random(u32_t *p_state)
+{
+    u32_t x = *p_state;
+
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    *p_state = x;
+
+    return x;
+}
+
+/**
+ * @brief Send STRESS_ITEMS numbers in order through the ring.
+ */
+template <typename RING>
+static void produce(std::atomic<bool> *p_failed)
+{
+    u32_t  state = 0x2545f491ul;
+    u32_t  chunk[STRESS_CHUNK_LEN];
+    u32_t  next = 0ul;
+    u32_t  r;
+    size_t len;
+    size_t sent;
+    size_t i;
+
+    while ((next < STRESS_ITEMS) && (false == p_failed->load())) {
+        r = next_random(&state);
+
+        if (0ul == (r & 1ul)) {
+            sent = RING::push(next) ? 1u : 0u;
+        } else {
+            len = 1u + ((r >> 1) % STRESS_CHUNK_LEN);
+            if ((STRESS_ITEMS - next) < len) {
+                len = STRESS_ITEMS - next;
+            }
+
+            for (i = 0u; i < len; i += 1u) {
+                chunk[i] = next + static_cast<u32_t>(i);
+            }
+
+            sent = RING::write(chunk, len);
+        }
+
+        next += static_cast<u32_t>(sent);
+        if (static_cast<u8_t>(next) != RING::write_pos()) {
+            p_failed->store(true);
+        } else if (0u == sent) {
+            std::this_thread::yield();
+        }
+    }
+}
+
+/**
+ * @brief Receive the numbers and check their order.
+ *
+ * @return The first wrong number, or STRESS_ITEMS when all of them were right.
+ */
+template <typename RING>
+static u32_t consume(std::atomic<bool> *p_failed)
+{
+    u32_t  state = 0x9e3779b9ul;
+    u32_t  chunk[STRESS_CHUNK_LEN];
+    u32_t  expected = 0ul;
+    u32_t  peeked;
+    u32_t  popped;
+    u32_t  r;
+    size_t received;
+    size_t i;
+
+    while ((expected < STRESS_ITEMS) && (false == p_failed->load())) {
+        r = next_random(&state);
+        received = 0u;
+
+        if (RING::CAPACITY < RING::count()) {
+            p_failed->store(true);
+        } else if (0ul == (r % 3ul)) {
+            if (RING::pop(popped)) {
+                chunk[0] = popped;
+                received = 1u;
+            }
+        } else if (1ul == (r % 3ul)) {
+            if (RING::peek(peeked)) {
+                if ((false == RING::pop(popped)) || (peeked != popped)) {
+                    p_failed->store(true);
+                } else {
+                    chunk[0] = popped;
+                    received = 1u;
+                }
+            }
+        } else {
+            received = RING::read(chunk, 1u + ((r >> 2) % STRESS_CHUNK_LEN));
+        }
+
+        for (i = 0u; (i < received) && (false == p_failed->load()); i += 1u) {
+            if (expected != chunk[i]) {
+                p_failed->store(true);
+            } else {
+                expected += 1ul;
+            }
+        }
+
+        if (static_cast<u8_t>(expected) != RING::read_pos()) {
+            p_failed->store(true);
+        } else if ((0u == received) && (false == p_failed->load())) {
+            std::this_thread::yield();
+        }
+    }
+
+    return expected;
+}
+
+/**
+ * @brief Run the producer and the consumer of one ring on two threads.
+ *
+ * @retval true  - every number arrived once and in order
+ * @retval false - the ring lost, repeated or reordered a number
+ */
+template <typename RING>
+static bool stress(const char *name)
+{
+    std::atomic<bool> failed(false);
+    u32_t             received = 0ul;
+
+    RING::init();
+
+    std::thread producer(produce<RING>, &failed);
+    std::thread consumer([&failed, &received]() { received = consume<RING>(&failed); });
+
+    producer.join();
+    consumer.join();
+
+    if (true == failed.load()) {
+        std::printf("%-12s FAILED at item %lu of %lu (count %u)\n",
+                    name, static_cast<unsigned long>(received), STRESS_ITEMS,
+                    static_cast<unsigned int>(RING::count()));
+    } else {
+        std::printf("%-12s %lu items\n", name, STRESS_ITEMS);
+    }
+
+    return false == failed.load();
+}
+
+int main()
+{
+    bool passed = true;
+
+    passed = stress<Ring4Adapter>("C 4") && passed;
+    passed = stress<Ring16Adapter>("C 16") && passed;
+    passed = stress<Ring256Adapter>("C 256") && passed;
+    passed = stress<CppRing<4u>>("C++ 4") && passed;
+    passed = stress<CppRing<16u>>("C++ 16") && passed;
+    passed = stress<CppRing<256u>>("C++ 256") && passed;
+
+    return passed ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,255 @@
+/**
+ * @file autobaud.c
+ * @brief Automatic baud rate detection test bench.
+ *
+ * Runs an executable that calls bsp_serial_autobaud at startup (06_uart_echo
+ * built with BSP_SERIAL_AUTOBAUD_MSEC) once per rate. Each run drives the
+ * sync character 'U' bit by bit onto ICP1 (PB0), where the board has RXD
+ * wired, and then reads back the USART0 baud rate registers. A rate passes
+ * when the configured rate is within 2 % of the driven one, the limit of
+ * uart_set_baud.
+ *
+ *   avr_autobaud --rates 2400,9600,57600,250000,500000 06_uart_echo.elf
+ *
+ * A rate of the driver's own choice is counted as a mismatch too, so an
+ * executable that does not listen fails every rate.
+ */
+#include "sim.h"
+
+#include <getopt.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <simavr/avr_ioport.h>
+#include <simavr/avr_timer.h>
+#include <simavr/sim_io.h>
+
+#define ICP_PORT            ('B')
+#define ICP_PIN             (0)
+#define SYNC_BYTE           (0x55u)
+#define SYNC_REPEATS        (3u)        /* 'U's sent, a frame apart         */
+#define FRAME_BITS          (10u)       /* start, 8 data, stop              */
+#define MAX_ERROR_PERCENT   (2.0)       /* UART_BAUD_MAX_ERROR              */
+#define MAX_RATES           (16u)
+#define DEFAULT_RATES       "2400,9600,19200,38400,57600,250000,500000"
+#define DEFAULT_START_USEC  (100000ull) /* after the firmware has started   */
+#define DEFAULT_TAIL_USEC   (20000ull)  /* to set the rate after the sync   */
+
+/* USART0 registers in the data space */
+#define UCSR0A_ADDR         (0xC0u)
+#define UBRR0L_ADDR         (0xC4u)
+#define UBRR0H_ADDR         (0xC5u)
+#define U2X_MASK            (1u << 1u)
+
+static void usage(const char *prog);
+static unsigned int parse_rates(const char *list, unsigned long *p_rates);
+static int run_rate(const char *elf_path, const char *mcu, unsigned long freq,
+                    unsigned long rate, avr_cycle_count_t start, double *p_actual);
+static int line_level(unsigned long rate, unsigned long freq, avr_cycle_count_t since_start);
+
+int main(int argc, char *argv[])
+{
+    static const struct option OPTIONS[] = {
+        { "rates",    required_argument, NULL, 'r' },
+        { "start-at", required_argument, NULL, 'a' },
+        { "mcu",      required_argument, NULL, 'm' },
+        { "freq",     required_argument, NULL, 'f' },
+        { NULL,       0,                 NULL, 0   },
+    };
+
+    unsigned long      rates[MAX_RATES];
+    unsigned int       num_rates;
+    unsigned int       r;
+    unsigned int       failed;
+    const char        *list;
+    const char        *mcu;
+    unsigned long      freq;
+    avr_cycle_count_t  start;
+    double             actual;
+    double             error;
+    int                opt;
+
+    list  = DEFAULT_RATES;
+    mcu   = SIM_DEFAULT_MCU;
+    freq  = SIM_DEFAULT_FREQ;
+    start = 0;
+
+    while (-1 != (opt = getopt_long(argc, argv, "r:a:m:f:", OPTIONS, NULL))) {
+        switch (opt)
+        {
+            case 'r': list  = optarg;                       break;
+            case 'a': start = strtoull(optarg, NULL, 0);    break;
+            case 'm': mcu   = optarg;                       break;
+            case 'f': freq  = strtoul(optarg, NULL, 0);     break;
+            default:  usage(argv[0]);                       break;
+        }
+    }
+
+    num_rates = parse_rates(list, rates);
+
+    if (((optind + 1) != argc) || (0u == num_rates)) {
+        usage(argv[0]);
+    }
+
+    if (0 == start) {
+        start = (DEFAULT_START_USEC * freq) / 1000000ull;
+    }
+
+    failed = 0u;
+    printf("%10s %12s %8s\n", "driven", "configured", "error");
+
+    for (r = 0u; r < num_rates; r += 1u) {
+        if (0 != run_rate(argv[optind], mcu, freq, rates[r], start, &actual)) {
+            return EXIT_FAILURE;
+        }
+
+        error = ((actual - (double)rates[r]) * 100.0) / (double)rates[r];
+        printf("%10lu %12.0f %+7.2f%%%s\n", rates[r], actual, error,
+               ((error > MAX_ERROR_PERCENT) || (error < -MAX_ERROR_PERCENT)) ? "  FAIL" : "");
+
+        if ((error > MAX_ERROR_PERCENT) || (error < -MAX_ERROR_PERCENT)) {
+            failed += 1u;
+        }
+    }
+
+    if (0u != failed) {
+        printf("autobaud: %u of %u rate(s) not detected\n", failed, num_rates);
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
+
+static void usage(const char *prog)
+{
+    fprintf(stderr,
+        "usage: %s [options] firmware.elf\n"
+        "  -r, --rates LIST        comma separated bit rates (default: " DEFAULT_RATES ")\n"
+        "  -a, --start-at CYCLES   when to send the sync (default: 100 msec)\n"
+        "  -m, --mcu NAME          part (default: " SIM_DEFAULT_MCU ")\n"
+        "  -f, --freq HZ           clock (default: 16000000)\n",
+        prog);
+    exit(EXIT_FAILURE);
+}
+
+/**
+ * @brief Parse a comma separated list of rates.
+ *
+ * @return number of rates, 0 for an invalid list
+ */
+static unsigned int parse_rates(const char *list, unsigned long *p_rates)
+{
+    unsigned int  count;
+    char         *p_end;
+
+    count = 0u;
+
+    while ('\0' != *list) {
+        if (MAX_RATES == count) {
+            return 0u;
+        }
+
+        p_rates[count] = strtoul(list, &p_end, 0);
+        if ((p_end == list) || (0ul == p_rates[count]) ||
+            ((',' != *p_end) && ('\0' != *p_end))) {
+            return 0u;
+        }
+        count += 1u;
+
+        list = (',' == *p_end) ? (p_end + 1) : p_end;
+    }
+
+    return count;
+}
+
+/**
+ * @brief Run the executable, drive the sync characters at a rate, and read
+ * the rate the USART was set to.
+ *
+ * @param[out] p_actual configured rate in bits per second
+ *
+ * @return 0, or -1 when the firmware crashed
+ */
+static int run_rate(const char *elf_path, const char *mcu, unsigned long freq,
+                    unsigned long rate, avr_cycle_count_t start, double *p_actual)
+{
+    avr_t             *avr;
+    avr_irq_t         *pin;
+    avr_irq_t         *icp;
+    avr_cycle_count_t  end;
+    unsigned int       ubrr;
+    unsigned int       div;
+    int                level;
+    int                state;
+
+    avr = sim_open(elf_path, mcu, freq);
+    sim_uart_quiet(avr);
+
+    /* Drive the pin, and the capture unit in case the part model does not
+       route the pin to it. */
+    pin = avr_io_getirq(avr, AVR_IOCTL_IOPORT_GETIRQ(ICP_PORT), ICP_PIN);
+    icp = avr_io_getirq(avr, AVR_IOCTL_TIMER_GETIRQ('1'), TIMER_IRQ_IN_ICP);
+
+    avr_raise_irq(pin, 1);
+    avr_raise_irq(icp, 1);
+
+    end = start + ((SYNC_REPEATS * 2u * FRAME_BITS * (avr_cycle_count_t)freq) / rate) +
+          (DEFAULT_TAIL_USEC * freq) / 1000000ull;
+
+    state = cpu_Running;
+    while ((avr->cycle < end) && (cpu_Done != state) && (cpu_Crashed != state)) {
+        state = avr_run(avr);
+
+        level = (avr->cycle < start) ? 1 : line_level(rate, freq, avr->cycle - start);
+        if ((int)pin->value != level) {
+            avr_raise_irq(pin, (uint32_t)level);
+            avr_raise_irq(icp, (uint32_t)level);
+        }
+    }
+
+    if (cpu_Crashed == state) {
+        fprintf(stderr, "autobaud: the firmware crashed at cycle %llu\n",
+                (unsigned long long)avr->cycle);
+        return -1;
+    }
+
+    ubrr = ((avr->data[UBRR0H_ADDR] & 0x0Fu) << 8u) | avr->data[UBRR0L_ADDR];
+    div  = (0u != (avr->data[UCSR0A_ADDR] & U2X_MASK)) ? 8u : 16u;
+
+    *p_actual = (double)freq / ((double)div * (ubrr + 1u));
+
+    return 0;
+}
+
+/**
+ * @brief Level of the RX line while the sync characters are sent.
+ *
+ * Each 'U' takes one frame and the line idles for another one after it.
+ *
+ * @param[in] rate        bits per second
+ * @param[in] freq        clock in Hz
+ * @param[in] since_start cycles since the first start bit
+ *
+ * @return 0 or 1
+ */
+static int line_level(unsigned long rate, unsigned long freq, avr_cycle_count_t since_start)
+{
+    avr_cycle_count_t bit;
+    int               level;
+
+    bit   = (since_start * rate) / freq;
+    level = 1;
+
+    if (bit < (SYNC_REPEATS * 2u * FRAME_BITS)) {
+        bit %= 2u * FRAME_BITS;
+
+        if (0u == bit) {
+            level = 0;                                          /* start bit */
+        } else if (bit <= 8u) {
+            level = (int)((SYNC_BYTE >> (bit - 1u)) & 1u);      /* LSB first */
+        }
+    }
+
+    return level;
+}
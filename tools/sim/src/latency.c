@@ -0,0 +1,478 @@
+/**
+ * @file latency.c
+ * @brief Interrupt latency test bench.
+ *
+ * Runs an exercise executable in simavr and measures, for every watched
+ * interrupt vector, the cycles from the moment the hardware raises the
+ * interrupt flag to the first useful instruction of its handler (the first
+ * instruction after the register saving prologue, see sim_isr_body).
+ *
+ * Each measurement is filed under what was running when the flag was raised:
+ * the main loop, the main loop with interrupts disabled, or another interrupt
+ * handler. The latency of a vector raised during another handler includes the
+ * rest of that handler, which is the number that limits the baud rate and the
+ * timer tick.
+ *
+ * Events are injected with:
+ *
+ *   --every CYCLES[+JITTER]:ACTION   every CYCLES (plus a random 0..JITTER)
+ *   --during VECTOR[+DELAY]:ACTION   DELAY cycles after VECTOR's handler starts
+ *
+ * where ACTION is rx:BYTE (a byte arriving on the UART) or irq:VECTOR (the
+ * flag of VECTOR raised directly, e.g. irq:TIMER1_COMPA for a compare match).
+ * A raised USART_RX vector reads an empty data register, so use rx:BYTE for
+ * the real receive path.
+ */
+#include "sim.h"
+
+#include <getopt.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <simavr/avr_uart.h>
+
+#define MAX_WATCHES         (8)
+#define MAX_ACTIONS         (8)
+#define MAX_NESTING         (8)
+#define NUM_VECTOR_CTX      (32)                /* contexts 1..31 are vectors  */
+#define CTX_MAIN            (0)                 /* main loop                   */
+#define CTX_MASKED          (NUM_VECTOR_CTX)    /* main loop, interrupts off   */
+#define NUM_CONTEXTS        (NUM_VECTOR_CTX + 1)
+#define DEFAULT_SECONDS     (2ull)
+
+typedef struct latency_stats
+{
+    unsigned long      count;
+    avr_cycle_count_t  min;
+    avr_cycle_count_t  max;
+    unsigned long long sum;
+} LatencyStats_t;
+
+typedef struct watch
+{
+    int               vector;
+    avr_flashaddr_t   body;         /* first useful handler instruction */
+    int               pending;      /* raised and not reached yet       */
+    avr_cycle_count_t raised_at;    /* cycle the flag was raised        */
+    int               raised_ctx;   /* context the flag was raised in   */
+    LatencyStats_t    stats[NUM_CONTEXTS];
+} Watch_t;
+
+typedef enum action_kind
+{
+    E_ACTION_RX,
+    E_ACTION_IRQ,
+} ActionKind_t;
+
+typedef struct action
+{
+    ActionKind_t      kind;
+    unsigned int      value;        /* byte or vector                     */
+    int               during;       /* trigger vector (or SIM_NO_VECTOR)  */
+    avr_cycle_count_t every;        /* period of a periodic action        */
+    avr_cycle_count_t spread;       /* jitter or delay                    */
+    avr_cycle_count_t due;          /* next cycle to act (0 = not armed)  */
+    unsigned long     count;        /* times the action was taken         */
+} Action_t;
+
+static avr_t     *avr;
+static Watch_t    watches[MAX_WATCHES];
+static int        num_watches;
+static Action_t   actions[MAX_ACTIONS];
+static int        num_actions;
+static int        running[MAX_NESTING];     /* handlers being executed */
+static int        running_depth;
+static avr_irq_t *uart_input;
+static unsigned   rand_state = 0x2545F491u;
+
+static void usage(const char *prog);
+static void add_watch(const char *name);
+static void add_action(const char *spec, int periodic);
+static int parse_vector(const char *name);
+static int current_context(void);
+static avr_cycle_count_t random_spread(avr_cycle_count_t spread);
+static void run_actions(void);
+static void check_watches(void);
+static void print_report(const char *elf_path, avr_cycle_count_t cycles);
+static void pending_notify(avr_irq_t *irq, uint32_t value, void *param);
+static void running_notify(avr_irq_t *irq, uint32_t value, void *param);
+
+int main(int argc, char *argv[])
+{
+    static const struct option OPTIONS[] = {
+        { "every",  required_argument, NULL, 'e' },
+        { "during", required_argument, NULL, 'd' },
+        { "watch",  required_argument, NULL, 'w' },
+        { "cycles", required_argument, NULL, 'c' },
+        { "mcu",    required_argument, NULL, 'm' },
+        { "freq",   required_argument, NULL, 'f' },
+        { NULL,     0,                 NULL, 0   },
+    };
+
+    const char        *mcu;
+    unsigned long      freq;
+    avr_cycle_count_t  cycles;
+    avr_irq_t         *irq;
+    int                opt;
+    int                state;
+    int                v;
+
+    mcu    = SIM_DEFAULT_MCU;
+    freq   = SIM_DEFAULT_FREQ;
+    cycles = 0;
+
+    while (-1 != (opt = getopt_long(argc, argv, "e:d:w:c:m:f:", OPTIONS, NULL))) {
+        switch (opt)
+        {
+            case 'e': add_action(optarg, 1);                     break;
+            case 'd': add_action(optarg, 0);                     break;
+            case 'w': add_watch(optarg);                         break;
+            case 'c': cycles = strtoull(optarg, NULL, 0);        break;
+            case 'm': mcu    = optarg;                           break;
+            case 'f': freq   = strtoul(optarg, NULL, 0);         break;
+            default:  usage(argv[0]);                            break;
+        }
+    }
+
+    if ((optind + 1) != argc) {
+        usage(argv[0]);
+    }
+
+    if (0 == num_watches) {
+        add_watch("USART_RX");
+        add_watch("USART_UDRE");
+        add_watch("TIMER1_COMPA");
+    }
+
+    if (0 == cycles) {
+        cycles = DEFAULT_SECONDS * freq;
+    }
+
+    avr = sim_open(argv[optind], mcu, freq);
+    sim_uart_quiet(avr);
+    uart_input = sim_uart_irq(avr, UART_IRQ_INPUT);
+
+    for (v = 0; v < num_watches; v += 1) {
+        watches[v].body = sim_isr_body(avr, argv[optind], watches[v].vector);
+        irq = avr_get_interrupt_irq(avr, (uint8_t)watches[v].vector);
+        if ((0 == watches[v].body) || (NULL == irq)) {
+            fprintf(stderr, "latency: %s has no %s handler\n",
+                    argv[optind], sim_vector_name(watches[v].vector));
+            continue;
+        }
+        avr_irq_register_notify(irq + AVR_INT_IRQ_PENDING, pending_notify, &watches[v]);
+    }
+
+    /* Track every handler so measurements can be filed by context. */
+    for (v = 1; v < NUM_VECTOR_CTX; v += 1) {
+        irq = avr_get_interrupt_irq(avr, (uint8_t)v);
+        if (NULL != irq) {
+            avr_irq_register_notify(irq + AVR_INT_IRQ_RUNNING, running_notify,
+                                    (void *)(intptr_t)v);
+        }
+    }
+
+    for (v = 0; v < num_actions; v += 1) {
+        if (SIM_NO_VECTOR == actions[v].during) {
+            actions[v].due = actions[v].every + random_spread(actions[v].spread);
+        }
+    }
+
+    state = cpu_Running;
+    while ((avr->cycle < cycles) && (cpu_Done != state) && (cpu_Crashed != state)) {
+        state = avr_run(avr);
+        check_watches();
+        run_actions();
+    }
+
+    if (cpu_Crashed == state) {
+        fprintf(stderr, "latency: the firmware crashed at cycle %llu\n",
+                (unsigned long long)avr->cycle);
+    }
+
+    print_report(argv[optind], avr->cycle);
+
+    return (cpu_Crashed == state) ? EXIT_FAILURE : EXIT_SUCCESS;
+}
+
+static void usage(const char *prog)
+{
+    fprintf(stderr,
+        "usage: %s [options] firmware.elf\n"
+        "  -e, --every CYCLES[+JITTER]:ACTION  periodic event\n"
+        "  -d, --during VECTOR[+DELAY]:ACTION  event while VECTOR runs\n"
+        "  -w, --watch VECTOR                  vector to measure (default:\n"
+        "                                      USART_RX, USART_UDRE, TIMER1_COMPA)\n"
+        "  -c, --cycles CYCLES                 run length (default: 2 seconds)\n"
+        "  -m, --mcu NAME                      part (default: " SIM_DEFAULT_MCU ")\n"
+        "  -f, --freq HZ                       clock (default: 16000000)\n"
+        "ACTION is rx:BYTE or irq:VECTOR\n",
+        prog);
+    exit(EXIT_FAILURE);
+}
+
+static void add_watch(const char *name)
+{
+    int vector;
+
+    if (MAX_WATCHES <= num_watches) {
+        fprintf(stderr, "latency: at most %d watches\n", MAX_WATCHES);
+        exit(EXIT_FAILURE);
+    }
+
+    vector = parse_vector(name);
+    memset(&watches[num_watches], 0, sizeof(watches[num_watches]));
+    watches[num_watches].vector = vector;
+    num_watches += 1;
+}
+
+/**
+ * @brief Parse "TRIGGER[+SPREAD]:KIND:VALUE" into a new action.
+ */
+static void add_action(const char *spec, int periodic)
+{
+    char      trigger[32];
+    char      kind[8];
+    char      value[32];
+    char     *plus;
+    Action_t *p_act;
+
+    if ((MAX_ACTIONS <= num_actions)
+        || (3 != sscanf(spec, "%31[^:]:%7[^:]:%31s", trigger, kind, value))) {
+        fprintf(stderr, "latency: bad event %s\n", spec);
+        exit(EXIT_FAILURE);
+    }
+
+    p_act = &actions[num_actions];
+    memset(p_act, 0, sizeof(*p_act));
+    p_act->during = SIM_NO_VECTOR;
+
+    plus = strchr(trigger, '+');
+    if (NULL != plus) {
+        *plus          = '\0';
+        p_act->spread  = strtoull(plus + 1, NULL, 0);
+    }
+
+    if (0 != periodic) {
+        p_act->every = strtoull(trigger, NULL, 0);
+        if (0 == p_act->every) {
+            fprintf(stderr, "latency: bad period %s\n", spec);
+            exit(EXIT_FAILURE);
+        }
+    } else {
+        p_act->during = parse_vector(trigger);
+    }
+
+    if (0 == strcmp(kind, "rx")) {
+        p_act->kind  = E_ACTION_RX;
+        p_act->value = (unsigned int)strtoul(value, NULL, 0) & 0xFFu;
+    } else if (0 == strcmp(kind, "irq")) {
+        p_act->kind  = E_ACTION_IRQ;
+        p_act->value = (unsigned int)parse_vector(value);
+    } else {
+        fprintf(stderr, "latency: bad action %s\n", spec);
+        exit(EXIT_FAILURE);
+    }
+
+    num_actions += 1;
+}
+
+static int parse_vector(const char *name)
+{
+    int vector;
+
+    vector = sim_vector_number(name);
+    if ((SIM_NO_VECTOR == vector) || (NUM_VECTOR_CTX <= vector)) {
+        fprintf(stderr, "latency: unknown vector %s\n", name);
+        exit(EXIT_FAILURE);
+    }
+
+    return vector;
+}
+
+/**
+ * @brief What the part is executing right now.
+ */
+static int current_context(void)
+{
+    int ctx;
+
+    if (0 != running_depth) {
+        ctx = running[running_depth - 1];
+    } else if (0 == avr->sreg[S_I]) {
+        ctx = CTX_MASKED;
+    } else {
+        ctx = CTX_MAIN;
+    }
+
+    return ctx;
+}
+
+/**
+ * @brief Pseudo random 0..spread (xorshift, the same every run).
+ */
+static avr_cycle_count_t random_spread(avr_cycle_count_t spread)
+{
+    if (0 == spread) {
+        return 0;
+    }
+
+    rand_state ^= rand_state << 13u;
+    rand_state ^= rand_state >> 17u;
+    rand_state ^= rand_state << 5u;
+
+    return (avr_cycle_count_t)rand_state % (spread + 1u);
+}
+
+/**
+ * @brief Take the actions that are due.
+ */
+static void run_actions(void)
+{
+    avr_int_vector_t *p_vector;
+    Action_t         *p_act;
+    int               a;
+
+    for (a = 0; a < num_actions; a += 1) {
+        p_act = &actions[a];
+
+        if ((0 == p_act->due) || (avr->cycle < p_act->due)) {
+            continue;
+        }
+
+        if (E_ACTION_RX == p_act->kind) {
+            avr_raise_irq(uart_input, p_act->value);
+        } else {
+            p_vector = sim_vector(avr, (int)p_act->value);
+            if (NULL != p_vector) {
+                avr_raise_interrupt(avr, p_vector);
+            }
+        }
+
+        p_act->count += 1u;
+
+        if (SIM_NO_VECTOR == p_act->during) {
+            p_act->due += p_act->every + random_spread(p_act->spread);
+        } else {
+            p_act->due = 0;
+        }
+    }
+}
+
+/**
+ * @brief Record the latency of watched vectors whose handler body is reached.
+ */
+static void check_watches(void)
+{
+    LatencyStats_t    *p_stats;
+    avr_cycle_count_t  latency;
+    int                w;
+
+    for (w = 0; w < num_watches; w += 1) {
+        if ((0 == watches[w].pending) || (avr->pc != watches[w].body)) {
+            continue;
+        }
+
+        latency = avr->cycle - watches[w].raised_at;
+        p_stats = &watches[w].stats[watches[w].raised_ctx];
+
+        if ((0u == p_stats->count) || (latency < p_stats->min)) {
+            p_stats->min = latency;
+        }
+        if (latency > p_stats->max) {
+            p_stats->max = latency;
+        }
+        p_stats->sum   += latency;
+        p_stats->count += 1u;
+
+        watches[w].pending = 0;
+    }
+}
+
+static void print_report(const char *elf_path, avr_cycle_count_t cycles)
+{
+    const LatencyStats_t *p_stats;
+    const char           *ctx_name;
+    int                   w;
+    int                   c;
+    int                   a;
+
+    printf("Interrupt latency of %s (%llu cycles, %llu usec)\n", elf_path,
+           (unsigned long long)cycles, sim_cycles_to_usec(avr, cycles));
+    printf("%-14s %-20s %8s %8s %8s %8s\n",
+           "vector", "raised during", "count", "min", "avg", "max");
+
+    for (w = 0; w < num_watches; w += 1) {
+        for (c = 0; c < NUM_CONTEXTS; c += 1) {
+            p_stats = &watches[w].stats[c];
+            if (0u == p_stats->count) {
+                continue;
+            }
+
+            ctx_name = (CTX_MASKED == c) ? "main (irq off)"
+                     : (CTX_MAIN == c)   ? "main"
+                     : sim_vector_name(c);
+
+            printf("%-14s %-20s %8lu %8llu %8llu %8llu\n",
+                   sim_vector_name(watches[w].vector), ctx_name, p_stats->count,
+                   (unsigned long long)p_stats->min,
+                   p_stats->sum / p_stats->count,
+                   (unsigned long long)p_stats->max);
+        }
+    }
+
+    for (a = 0; a < num_actions; a += 1) {
+        printf("event %d: %s 0x%02x taken %lu times\n", a,
+               (E_ACTION_RX == actions[a].kind) ? "rx" : "irq",
+               actions[a].value, actions[a].count);
+    }
+
+    printf("cycles are from the raised flag to the first instruction after the "
+           "handler prologue\n");
+}
+
+/*
+ * SIMAVR NOTIFICATIONS
+ */
+static void pending_notify(avr_irq_t *irq, uint32_t value, void *param)
+{
+    Watch_t *p_watch;
+
+    (void)irq;
+    p_watch = (Watch_t *)param;
+
+    if ((0u != value) && (0 == p_watch->pending)) {
+        p_watch->pending    = 1;
+        p_watch->raised_at  = avr->cycle;
+        p_watch->raised_ctx = current_context();
+    }
+}
+
+static void running_notify(avr_irq_t *irq, uint32_t value, void *param)
+{
+    int vector;
+    int a;
+
+    (void)irq;
+    vector = (int)(intptr_t)param;
+
+    if (0u != value) {
+        if (MAX_NESTING > running_depth) {
+            running[running_depth] = vector;
+            running_depth += 1;
+        }
+
+        for (a = 0; a < num_actions; a += 1) {
+            if (vector == actions[a].during) {
+                actions[a].due = avr->cycle + actions[a].spread;
+                if (0 == actions[a].due) {
+                    actions[a].due = 1;
+                }
+            }
+        }
+    } else if (0 != running_depth) {
+        running_depth -= 1;
+    }
+}
@@ -0,0 +1,158 @@
+/**
+ * @file led_trace.c
+ * @brief Builtin LED pin recorder.
+ *
+ * Runs an exercise executable in simavr and records the builtin LED pin (PB5)
+ * in a VCD file for scripts/morse_timing.py. Exercises that blink a message
+ * from the UART (08_morse_encoder) get it with --input, sent once the part has
+ * run for --input-at cycles. C escapes (\n, \r, \\) are expanded in the input.
+ */
+#include "sim.h"
+
+#include <getopt.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <simavr/avr_ioport.h>
+#include <simavr/avr_uart.h>
+#include <simavr/sim_io.h>
+#include <simavr/sim_vcd_file.h>
+
+#define LED_PORT            ('B')
+#define LED_PIN             (5)
+#define VCD_FLUSH_USEC      (100000u)
+#define DEFAULT_SECONDS     (12ull)
+#define DEFAULT_INPUT_USEC  (100000ull)     /* after the firmware has started */
+
+static avr_vcd_t vcd;
+
+static void usage(const char *prog);
+static void send_input(avr_t *avr, const char *text);
+
+int main(int argc, char *argv[])
+{
+    static const struct option OPTIONS[] = {
+        { "output",   required_argument, NULL, 'o' },
+        { "input",    required_argument, NULL, 'i' },
+        { "input-at", required_argument, NULL, 'a' },
+        { "cycles",   required_argument, NULL, 'c' },
+        { "mcu",      required_argument, NULL, 'm' },
+        { "freq",     required_argument, NULL, 'f' },
+        { NULL,       0,                 NULL, 0   },
+    };
+
+    const char        *output;
+    const char        *input;
+    const char        *mcu;
+    unsigned long      freq;
+    avr_cycle_count_t  cycles;
+    avr_cycle_count_t  input_at;
+    avr_t             *avr;
+    int                opt;
+    int                state;
+
+    output   = "led.vcd";
+    input    = NULL;
+    mcu      = SIM_DEFAULT_MCU;
+    freq     = SIM_DEFAULT_FREQ;
+    cycles   = 0;
+    input_at = 0;
+
+    while (-1 != (opt = getopt_long(argc, argv, "o:i:a:c:m:f:", OPTIONS, NULL))) {
+        switch (opt)
+        {
+            case 'o': output   = optarg;                        break;
+            case 'i': input    = optarg;                        break;
+            case 'a': input_at = strtoull(optarg, NULL, 0);     break;
+            case 'c': cycles   = strtoull(optarg, NULL, 0);     break;
+            case 'm': mcu      = optarg;                        break;
+            case 'f': freq     = strtoul(optarg, NULL, 0);      break;
+            default:  usage(argv[0]);                           break;
+        }
+    }
+
+    if ((optind + 1) != argc) {
+        usage(argv[0]);
+    }
+
+    if (0 == cycles) {
+        cycles = DEFAULT_SECONDS * freq;
+    }
+
+    if (0 == input_at) {
+        input_at = (DEFAULT_INPUT_USEC * freq) / 1000000ull;
+    }
+
+    avr = sim_open(argv[optind], mcu, freq);
+    sim_uart_quiet(avr);
+
+    avr_vcd_init(avr, output, &vcd, VCD_FLUSH_USEC);
+    avr_vcd_add_signal(&vcd,
+                       avr_io_getirq(avr, AVR_IOCTL_IOPORT_GETIRQ(LED_PORT), LED_PIN),
+                       1, "PB5");
+    avr_vcd_start(&vcd);
+
+    state = cpu_Running;
+    while ((avr->cycle < cycles) && (cpu_Done != state) && (cpu_Crashed != state)) {
+        state = avr_run(avr);
+
+        if ((NULL != input) && (avr->cycle >= input_at)) {
+            send_input(avr, input);
+            input = NULL;
+        }
+    }
+
+    avr_vcd_stop(&vcd);
+    avr_vcd_close(&vcd);
+
+    if (cpu_Crashed == state) {
+        fprintf(stderr, "led_trace: the firmware crashed at cycle %llu\n",
+                (unsigned long long)avr->cycle);
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
+
+static void usage(const char *prog)
+{
+    fprintf(stderr,
+        "usage: %s [options] firmware.elf\n"
+        "  -o, --output FILE       VCD file (default: led.vcd)\n"
+        "  -i, --input TEXT        text sent over the UART\n"
+        "  -a, --input-at CYCLES   when to send it (default: 100 msec)\n"
+        "  -c, --cycles CYCLES     run length (default: 12 seconds)\n"
+        "  -m, --mcu NAME          part (default: " SIM_DEFAULT_MCU ")\n"
+        "  -f, --freq HZ           clock (default: 16000000)\n",
+        prog);
+    exit(EXIT_FAILURE);
+}
+
+/**
+ * @brief Queue text in the UART receiver (it arrives at the baud rate).
+ */
+static void send_input(avr_t *avr, const char *text)
+{
+    avr_irq_t     *uart_input;
+    const char    *p_c;
+    unsigned char  byte;
+
+    uart_input = sim_uart_irq(avr, UART_IRQ_INPUT);
+
+    for (p_c = text; '\0' != *p_c; p_c += 1) {
+        byte = (unsigned char)*p_c;
+
+        if (('\\' == byte) && ('\0' != p_c[1])) {
+            p_c += 1;
+            switch (*p_c)
+            {
+                case 'n': byte = '\n';                      break;
+                case 'r': byte = '\r';                      break;
+                default:  byte = (unsigned char)*p_c;       break;
+            }
+        }
+
+        avr_raise_irq(uart_input, byte);
+    }
+}
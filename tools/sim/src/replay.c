@@ -0,0 +1,374 @@
+/**
+ * @file replay.c
+ * @brief UART session replay test bench.
+ *
+ * Runs an exercise executable in simavr and feeds it a session recorded with
+ * scripts/uart_session.py, with the original byte timing divided by --speed.
+ * Bytes never arrive faster than the line rate: a byte due while the previous
+ * one is still on the wire waits for it, and the longest such wait is reported.
+ *
+ * Every time the USART_RX handler starts, the fill of the driver's RX ring
+ * (the rx_ring object of uart.c, found in the symbol table) is read from the
+ * simulated RAM. A byte arriving at a full ring is dropped by the handler, so
+ * the report shows the highest fill, the drops, and the input rate around the
+ * first drop.
+ */
+#include "sim.h"
+
+#include <getopt.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <simavr/avr_uart.h>
+
+#define DEFAULT_RING        "rx_ring"
+#define DEFAULT_RING_SIZE   (256u)
+#define DEFAULT_BAUD        (19200ul)
+#define DEFAULT_START_USEC  (100000ull)     /* after the firmware has started */
+#define DEFAULT_TAIL_USEC   (1000000ull)    /* run time after the last byte   */
+#define RING_HEAD_OFFSET    (0u)            /* u8_t head, see utils/spsc_ring.h */
+#define RING_TAIL_OFFSET    (1u)            /* u8_t tail                        */
+#define DATA_SPACE_OFFSET   (0x800000ul)    /* AVR ELF address of RAM         */
+#define BITS_PER_FRAME      (10u)           /* start, 8 data, stop            */
+#define RATE_WINDOW         (16u)           /* bytes in the peak rate window  */
+#define LINE_SIZE           (128)
+
+typedef struct event
+{
+    avr_cycle_count_t due;          /* cycle the byte is played at */
+    unsigned char     byte;
+} Event_t;
+
+static avr_t             *avr;
+static Event_t           *events;
+static size_t             num_events;
+static unsigned long      ring_addr;
+static unsigned int       ring_size;
+static unsigned long      received;
+static unsigned long      dropped;
+static unsigned long      transmitted;
+static unsigned int       max_fill;
+static size_t             played;       /* events handed to the UART      */
+static size_t             first_drop;   /* played count at the first drop */
+static avr_cycle_count_t  first_drop_at;
+
+static void usage(const char *prog);
+static void read_session(const char *path, double speed, avr_cycle_count_t start);
+static unsigned int ring_counter(unsigned long offset);
+static unsigned int ring_capacity(void);
+static double byte_rate(size_t first, size_t last);
+static void print_report(double speed, avr_cycle_count_t max_wait);
+static void rx_running_notify(avr_irq_t *irq, uint32_t value, void *param);
+static void uart_output_notify(avr_irq_t *irq, uint32_t value, void *param);
+
+int main(int argc, char *argv[])
+{
+    static const struct option OPTIONS[] = {
+        { "speed",     required_argument, NULL, 's' },
+        { "baud",      required_argument, NULL, 'b' },
+        { "ring",      required_argument, NULL, 'r' },
+        { "ring-size", required_argument, NULL, 'n' },
+        { "output",    required_argument, NULL, 'o' },
+        { "mcu",       required_argument, NULL, 'm' },
+        { "freq",      required_argument, NULL, 'f' },
+        { NULL,        0,                 NULL, 0   },
+    };
+
+    const char        *ring;
+    const char        *output;
+    const char        *mcu;
+    const char        *elf_path;
+    FILE              *out_file;
+    unsigned long      freq;
+    unsigned long      baud;
+    double             speed;
+    avr_cycle_count_t  frame;
+    avr_cycle_count_t  wire_free;
+    avr_cycle_count_t  max_wait;
+    avr_cycle_count_t  end;
+    avr_irq_t         *uart_input;
+    avr_irq_t         *irq;
+    int                opt;
+    int                state;
+
+    ring      = DEFAULT_RING;
+    ring_size = DEFAULT_RING_SIZE;
+    output    = NULL;
+    mcu       = SIM_DEFAULT_MCU;
+    freq      = SIM_DEFAULT_FREQ;
+    baud      = DEFAULT_BAUD;
+    speed     = 1.0;
+
+    while (-1 != (opt = getopt_long(argc, argv, "s:b:r:n:o:m:f:", OPTIONS, NULL))) {
+        switch (opt)
+        {
+            case 's': speed     = strtod(optarg, NULL);                       break;
+            case 'b': baud      = strtoul(optarg, NULL, 0);                   break;
+            case 'r': ring      = optarg;                                     break;
+            case 'n': ring_size = (unsigned int)strtoul(optarg, NULL, 0);     break;
+            case 'o': output    = optarg;                                     break;
+            case 'm': mcu       = optarg;                                     break;
+            case 'f': freq      = strtoul(optarg, NULL, 0);                   break;
+            default:  usage(argv[0]);                                         break;
+        }
+    }
+
+    if (((optind + 2) != argc) || (0.0 >= speed) || (0ul == baud) ||
+        (0u == ring_size) || (256u < ring_size) || (0u != (ring_size & (ring_size - 1u)))) {
+        usage(argv[0]);
+    }
+
+    elf_path = argv[optind + 1];
+
+    if (0 == sim_elf_symbol(elf_path, ring, &ring_addr)) {
+        fprintf(stderr, "replay: no %s symbol in %s\n", ring, elf_path);
+        return EXIT_FAILURE;
+    }
+    ring_addr -= DATA_SPACE_OFFSET;
+
+    avr = sim_open(elf_path, mcu, freq);
+    sim_uart_quiet(avr);
+
+    read_session(argv[optind], speed, (DEFAULT_START_USEC * freq) / 1000000ull);
+
+    out_file = NULL;
+    if (NULL != output) {
+        out_file = fopen(output, "wb");
+        if (NULL == out_file) {
+            fprintf(stderr, "replay: unable to write %s\n", output);
+            return EXIT_FAILURE;
+        }
+    }
+
+    uart_input = sim_uart_irq(avr, UART_IRQ_INPUT);
+    avr_irq_register_notify(sim_uart_irq(avr, UART_IRQ_OUTPUT), uart_output_notify, out_file);
+
+    irq = avr_get_interrupt_irq(avr, (uint8_t)sim_vector_number("USART_RX"));
+    if (NULL == irq) {
+        fprintf(stderr, "replay: %s has no USART_RX interrupt\n", mcu);
+        return EXIT_FAILURE;
+    }
+    avr_irq_register_notify(irq + AVR_INT_IRQ_RUNNING, rx_running_notify, NULL);
+
+    frame     = ((avr_cycle_count_t)freq * BITS_PER_FRAME) / baud;
+    wire_free = 0;
+    max_wait  = 0;
+    end       = ((0 != num_events) ? events[num_events - 1u].due : 0) +
+                (DEFAULT_TAIL_USEC * freq) / 1000000ull;
+
+    state = cpu_Running;
+    while ((avr->cycle < end) && (cpu_Done != state) && (cpu_Crashed != state)) {
+        state = avr_run(avr);
+
+        if ((played < num_events) && (avr->cycle >= events[played].due) &&
+            (avr->cycle >= wire_free)) {
+            if ((avr->cycle - events[played].due) > max_wait) {
+                max_wait = avr->cycle - events[played].due;
+            }
+
+            avr_raise_irq(uart_input, events[played].byte);
+            wire_free = avr->cycle + frame;
+            played += 1u;
+
+            /* Keep the tail time after a late last byte. */
+            if (played == num_events) {
+                end = avr->cycle + (DEFAULT_TAIL_USEC * freq) / 1000000ull;
+            }
+        }
+    }
+
+    if (NULL != out_file) {
+        fclose(out_file);
+    }
+
+    print_report(speed, max_wait);
+
+    if (cpu_Crashed == state) {
+        fprintf(stderr, "replay: the firmware crashed at cycle %llu\n",
+                (unsigned long long)avr->cycle);
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
+
+static void usage(const char *prog)
+{
+    fprintf(stderr,
+        "usage: %s [options] session.uts firmware.elf\n"
+        "  -s, --speed FACTOR      playback speed (default: 1)\n"
+        "  -b, --baud RATE         line rate (default: 19200)\n"
+        "  -r, --ring SYMBOL       RX ring object (default: " DEFAULT_RING ")\n"
+        "  -n, --ring-size BYTES   RX ring size (default: 256)\n"
+        "  -o, --output FILE       write the firmware's UART output\n"
+        "  -m, --mcu NAME          part (default: " SIM_DEFAULT_MCU ")\n"
+        "  -f, --freq HZ           clock (default: 16000000)\n",
+        prog);
+    exit(EXIT_FAILURE);
+}
+
+/**
+ * @brief Load a session file and convert its times to cycles.
+ *
+ * @param[in] path  session file ("<usec> <hex byte>" lines, # comments)
+ * @param[in] speed playback speed
+ * @param[in] start cycle of the first byte
+ */
+static void read_session(const char *path, double speed, avr_cycle_count_t start)
+{
+    FILE               *file;
+    char                line[LINE_SIZE];
+    char               *comment;
+    unsigned long long  usec;
+    unsigned int        byte;
+    size_t              capacity;
+    unsigned long       number;
+
+    file = fopen(path, "r");
+    if (NULL == file) {
+        fprintf(stderr, "replay: unable to read %s\n", path);
+        exit(EXIT_FAILURE);
+    }
+
+    capacity = 0;
+    number   = 0;
+
+    while (NULL != fgets(line, sizeof(line), file)) {
+        number += 1ul;
+
+        comment = strchr(line, '#');
+        if (NULL != comment) {
+            *comment = '\0';
+        }
+
+        if ('\0' == line[strspn(line, " \t\r\n")]) {
+            continue;   /* blank */
+        }
+
+        if ((2 != sscanf(line, "%llu %x", &usec, &byte)) || (0xFFu < byte)) {
+            fprintf(stderr, "replay: %s:%lu: expected \"<usec> <hex byte>\"\n", path, number);
+            exit(EXIT_FAILURE);
+        }
+
+        if (num_events == capacity) {
+            capacity = (0u == capacity) ? 256u : (capacity * 2u);
+            events   = realloc(events, capacity * sizeof(Event_t));
+            if (NULL == events) {
+                fprintf(stderr, "replay: out of memory\n");
+                exit(EXIT_FAILURE);
+            }
+        }
+
+        events[num_events].due  = start +
+            (avr_cycle_count_t)(((double)usec * avr->frequency) / (1e6 * speed));
+        events[num_events].byte = (unsigned char)byte;
+        num_events += 1u;
+    }
+
+    fclose(file);
+}
+
+/**
+ * @brief Read a ring counter (head or tail) from the simulated RAM.
+ */
+static unsigned int ring_counter(unsigned long offset)
+{
+    return avr->data[ring_addr + offset];
+}
+
+/**
+ * @brief Bytes the ring holds (a 256 byte ring holds 255).
+ */
+static unsigned int ring_capacity(void)
+{
+    return (256u > ring_size) ? ring_size : 255u;
+}
+
+/**
+ * @brief Input rate in bytes per second between two played events.
+ */
+static double byte_rate(size_t first, size_t last)
+{
+    avr_cycle_count_t span;
+
+    span = events[last].due - events[first].due;
+
+    return (0 != span) ? (((double)(last - first) * avr->frequency) / (double)span) : 0.0;
+}
+
+static void print_report(double speed, avr_cycle_count_t max_wait)
+{
+    size_t e;
+    size_t last;
+    double peak;
+    double rate;
+
+    peak = 0.0;
+    for (e = RATE_WINDOW; e < num_events; e += 1u) {
+        rate = byte_rate(e - RATE_WINDOW, e);
+        if (rate > peak) {
+            peak = rate;
+        }
+    }
+
+    printf("speed %gx: %zu bytes played, %lu received, %lu dropped, %lu transmitted\n",
+           speed, played, received, dropped, transmitted);
+    printf("  input rate:   %.1f bytes/s average, %.1f bytes/s peak (%u bytes)\n",
+           (1u < num_events) ? byte_rate(0, num_events - 1u) : 0.0, peak, RATE_WINDOW);
+    printf("  rx ring fill: %u of %u bytes at most\n", max_fill, ring_capacity());
+    printf("  line delay:   %llu usec at most\n",
+           sim_cycles_to_usec(avr, max_wait));
+
+    if (0ul != dropped) {
+        /* The dropped byte is the last one played when its handler ran. */
+        last = first_drop - 1u;
+        printf("  first drop:   byte %zu at %llu usec, input at %.1f bytes/s\n",
+               last, sim_cycles_to_usec(avr, first_drop_at),
+               byte_rate((last > RATE_WINDOW) ? (last - RATE_WINDOW) : 0, last));
+    }
+}
+
+/*
+ * SIMAVR NOTIFICATIONS
+ */
+static void rx_running_notify(avr_irq_t *irq, uint32_t value, void *param)
+{
+    unsigned int head;
+    unsigned int tail;
+    unsigned int fill;
+
+    (void)irq;
+    (void)param;
+
+    if (0u != value) {
+        /* The ring as the handler finds it, before it pushes the new byte. */
+        head = ring_counter(RING_HEAD_OFFSET);
+        tail = ring_counter(RING_TAIL_OFFSET);
+        fill = (head - tail) & 0xFFu;
+
+        received += 1ul;
+        if (fill > max_fill) {
+            max_fill = fill;
+        }
+
+        if (ring_capacity() == fill) {
+            if (0ul == dropped) {
+                first_drop    = played;
+                first_drop_at = avr->cycle;
+            }
+            dropped += 1ul;
+        }
+    }
+}
+
+static void uart_output_notify(avr_irq_t *irq, uint32_t value, void *param)
+{
+    (void)irq;
+
+    transmitted += 1ul;
+    if (NULL != param) {
+        fputc((int)(value & 0xFFu), (FILE *)param);
+    }
+}
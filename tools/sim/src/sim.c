@@ -0,0 +1,314 @@
+/**
+ * @file sim.c
+ * @brief Common setup of the simavr test benches.
+ *
+ * Loads an exercise executable into a simulated part, looks up its symbols,
+ * and names the interrupt vectors of the ATmega328P. The executables do not
+ * carry a simavr .mmcu section, so the part and clock come from the caller.
+ */
+#include "sim.h"
+
+#include <elf.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <simavr/avr_uart.h>
+#include <simavr/sim_io.h>
+#include <simavr/sim_elf.h>
+
+#define UART_NAME           ('0')
+#define SREG_IO_ADDR        (0x3Fu)
+#define RAMPZ_IO_ADDR       (0x3Bu)
+#define USEC_PER_SEC        (1000000ull)
+
+/* ATmega328P interrupt vector names (index is the vector number). */
+static const char * const VECTOR_NAMES[] = {
+    "RESET",        "INT0",         "INT1",         "PCINT0",
+    "PCINT1",       "PCINT2",       "WDT",          "TIMER2_COMPA",
+    "TIMER2_COMPB", "TIMER2_OVF",   "TIMER1_CAPT",  "TIMER1_COMPA",
+    "TIMER1_COMPB", "TIMER1_OVF",   "TIMER0_COMPA", "TIMER0_COMPB",
+    "TIMER0_OVF",   "SPI_STC",      "USART_RX",     "USART_UDRE",
+    "USART_TX",     "ADC",          "EE_READY",     "ANALOG_COMP",
+    "TWI",          "SPM_READY",
+};
+
+#define NUM_VECTORS ((int)(sizeof(VECTOR_NAMES) / sizeof(VECTOR_NAMES[0])))
+
+static elf_firmware_t firmware;
+
+static unsigned char *read_file(const char *path, size_t *p_size);
+static int is_prologue(unsigned int op);
+
+/**
+ * @brief Create a simulated part running an executable.
+ *
+ * Exits the program when the executable or part cannot be loaded.
+ *
+ * @param[in] elf_path executable to load
+ * @param[in] mcu      part name (e.g. atmega328p)
+ * @param[in] freq     clock in Hz
+ *
+ * @return the initialized part, stopped at the reset vector
+ */
+avr_t *sim_open(const char *elf_path, const char *mcu, unsigned long freq)
+{
+    avr_t *avr;
+
+    memset(&firmware, 0, sizeof(firmware));
+    if (0 != elf_read_firmware(elf_path, &firmware)) {
+        fprintf(stderr, "sim: unable to read %s\n", elf_path);
+        exit(EXIT_FAILURE);
+    }
+
+    snprintf(firmware.mmcu, sizeof(firmware.mmcu), "%s", mcu);
+    firmware.frequency = (uint32_t)freq;
+
+    avr = avr_make_mcu_by_name(firmware.mmcu);
+    if (NULL == avr) {
+        fprintf(stderr, "sim: unknown part %s\n", mcu);
+        exit(EXIT_FAILURE);
+    }
+
+    avr_init(avr);
+    avr_load_firmware(avr, &firmware);
+
+    return avr;
+}
+
+/**
+ * @brief Look up a symbol in the symbol table of an executable.
+ *
+ * @param[in]  elf_path executable to read
+ * @param[in]  name     symbol name
+ * @param[out] p_addr   symbol value (a byte address for functions)
+ *
+ * @retval 1 - the symbol was found
+ * @retval 0 - no such symbol
+ */
+int sim_elf_symbol(const char *elf_path, const char *name, unsigned long *p_addr)
+{
+    const Elf32_Ehdr *p_ehdr;
+    const Elf32_Shdr *p_shdr;
+    const Elf32_Sym  *p_sym;
+    const char       *strtab;
+    unsigned char    *data;
+    size_t            size;
+    size_t            count;
+    size_t            s;
+    int               found;
+
+    found = 0;
+    data  = read_file(elf_path, &size);
+    if (NULL == data) {
+        return 0;
+    }
+
+    p_ehdr = (const Elf32_Ehdr *)data;
+    p_shdr = (const Elf32_Shdr *)(data + p_ehdr->e_shoff);
+
+    for (s = 0; (s < p_ehdr->e_shnum) && (0 == found); s += 1) {
+        if (SHT_SYMTAB != p_shdr[s].sh_type) {
+            continue;
+        }
+
+        p_sym  = (const Elf32_Sym *)(data + p_shdr[s].sh_offset);
+        count  = p_shdr[s].sh_size / sizeof(Elf32_Sym);
+        strtab = (const char *)(data + p_shdr[p_shdr[s].sh_link].sh_offset);
+
+        for (; 0 != count; count -= 1, p_sym += 1) {
+            if (0 == strcmp(strtab + p_sym->st_name, name)) {
+                *p_addr = p_sym->st_value;
+                found   = 1;
+                break;
+            }
+        }
+    }
+
+    free(data);
+
+    return found;
+}
+
+/**
+ * @brief Vector number from a name (USART_RX, USART_RX_vect) or a number.
+ *
+ * @return vector number or SIM_NO_VECTOR
+ */
+int sim_vector_number(const char *name)
+{
+    char  *end;
+    long   number;
+    size_t len;
+    int    v;
+
+    number = strtol(name, &end, 0);
+    if (('\0' != *name) && ('\0' == *end)) {
+        return ((0 < number) && (NUM_VECTORS > number)) ? (int)number : SIM_NO_VECTOR;
+    }
+
+    /* Accept the avr-libc spelling as well. */
+    len = strlen(name);
+    if ((5 < len) && (0 == strcmp(name + len - 5, "_vect"))) {
+        len -= 5;
+    }
+
+    for (v = 1; v < NUM_VECTORS; v += 1) {
+        if ((strlen(VECTOR_NAMES[v]) == len) && (0 == strncmp(VECTOR_NAMES[v], name, len))) {
+            return v;
+        }
+    }
+
+    return SIM_NO_VECTOR;
+}
+
+/**
+ * @brief Name of a vector number ("main" for SIM_NO_VECTOR).
+ */
+const char *sim_vector_name(int vector)
+{
+    const char *name;
+
+    if (SIM_NO_VECTOR == vector) {
+        name = "main";
+    } else if ((0 <= vector) && (NUM_VECTORS > vector)) {
+        name = VECTOR_NAMES[vector];
+    } else {
+        name = "?";
+    }
+
+    return name;
+}
+
+/**
+ * @brief The simavr interrupt vector of a vector number (NULL if not modeled).
+ */
+avr_int_vector_t *sim_vector(avr_t *avr, int vector)
+{
+    avr_int_table_t *p_table;
+    int              i;
+
+    p_table = &avr->interrupts;
+
+    for (i = 0; i < p_table->vector_count; i += 1) {
+        if (vector == p_table->vector[i]->vector) {
+            return p_table->vector[i];
+        }
+    }
+
+    return NULL;
+}
+
+/**
+ * @brief Address of the first useful instruction of an interrupt handler.
+ *
+ * The handler is the __vector_N function of the executable. Its prologue
+ * (register pushes, the SREG and RAMPZ reads, and clearing the zero register)
+ * is skipped, so execution reaching the returned address is the moment the
+ * handler starts doing its job.
+ *
+ * @return byte address in flash (0 when the executable has no such handler)
+ */
+avr_flashaddr_t sim_isr_body(avr_t *avr, const char *elf_path, int vector)
+{
+    char          symbol[32];
+    unsigned long addr;
+    unsigned int  op;
+
+    snprintf(symbol, sizeof(symbol), "__vector_%d", vector);
+    if (0 == sim_elf_symbol(elf_path, symbol, &addr)) {
+        return 0;
+    }
+
+    for (;;) {
+        op = (unsigned int)avr->flash[addr] | ((unsigned int)avr->flash[addr + 1u] << 8u);
+        if (0 == is_prologue(op)) {
+            break;
+        }
+        addr += 2u;
+    }
+
+    return (avr_flashaddr_t)addr;
+}
+
+/**
+ * @brief Stop simavr from echoing the UART output on stdout.
+ */
+void sim_uart_quiet(avr_t *avr)
+{
+    uint32_t flags;
+
+    flags = 0;
+    avr_ioctl(avr, AVR_IOCTL_UART_GET_FLAGS(UART_NAME), &flags);
+    flags &= ~AVR_UART_FLAG_STDIO;
+    avr_ioctl(avr, AVR_IOCTL_UART_SET_FLAGS(UART_NAME), &flags);
+}
+
+/**
+ * @brief UART IRQ of the part (UART_IRQ_INPUT, UART_IRQ_OUTPUT, ...).
+ */
+avr_irq_t *sim_uart_irq(avr_t *avr, int irq)
+{
+    return avr_io_getirq(avr, AVR_IOCTL_UART_GETIRQ(UART_NAME), irq);
+}
+
+/**
+ * @brief Convert simulated cycles to microseconds.
+ */
+unsigned long long sim_cycles_to_usec(const avr_t *avr, avr_cycle_count_t cycles)
+{
+    return (cycles * USEC_PER_SEC) / avr->frequency;
+}
+
+/**
+ * @brief Read a whole file into a malloc'ed buffer.
+ */
+static unsigned char *read_file(const char *path, size_t *p_size)
+{
+    unsigned char *data;
+    FILE          *file;
+    long           size;
+
+    data = NULL;
+    file = fopen(path, "rb");
+
+    if (NULL != file) {
+        if ((0 == fseek(file, 0, SEEK_END)) && (0 < (size = ftell(file)))) {
+            rewind(file);
+            data = malloc((size_t)size);
+
+            if ((NULL != data) && (1u != fread(data, (size_t)size, 1u, file))) {
+                free(data);
+                data = NULL;
+            }
+
+            *p_size = (size_t)size;
+        }
+
+        fclose(file);
+    }
+
+    return data;
+}
+
+/**
+ * @brief Check for an instruction of a GCC interrupt handler prologue.
+ */
+static int is_prologue(unsigned int op)
+{
+    unsigned int io_addr;
+
+    /* push Rr: 1001 001r rrrr 1111 */
+    if (0x920Fu == (op & 0xFE0Fu)) {
+        return 1;
+    }
+
+    /* in Rd, A: 1011 0AAd dddd AAAA (only SREG and RAMPZ) */
+    if (0xB000u == (op & 0xF800u)) {
+        io_addr = ((op >> 5u) & 0x30u) | (op & 0x0Fu);
+        return ((SREG_IO_ADDR == io_addr) || (RAMPZ_IO_ADDR == io_addr)) ? 1 : 0;
+    }
+
+    /* clr r1 (eor r1, r1) */
+    return (0x2411u == op) ? 1 : 0;
+}
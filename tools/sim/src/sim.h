@@ -0,0 +1,33 @@
+#ifndef SIM_H
+#define SIM_H
+
+#include <simavr/sim_avr.h>
+#include <simavr/sim_interrupts.h>
+#include <simavr/sim_irq.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define SIM_DEFAULT_MCU     "atmega328p"
+#define SIM_DEFAULT_FREQ    (16000000ul)
+#define SIM_NO_VECTOR       (-1)
+
+avr_t *sim_open(const char *elf_path, const char *mcu, unsigned long freq);
+int sim_elf_symbol(const char *elf_path, const char *name, unsigned long *p_addr);
+
+int sim_vector_number(const char *name);
+const char *sim_vector_name(int vector);
+avr_int_vector_t *sim_vector(avr_t *avr, int vector);
+avr_flashaddr_t sim_isr_body(avr_t *avr, const char *elf_path, int vector);
+
+void sim_uart_quiet(avr_t *avr);
+avr_irq_t *sim_uart_irq(avr_t *avr, int irq);
+
+unsigned long long sim_cycles_to_usec(const avr_t *avr, avr_cycle_count_t cycles);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SIM_H */